@@ -0,0 +1,72 @@
+// Times cb_adf prediction and learning on multiline examples with many actions:
+//   adf_benchmark [shared] [action] [iterations] [vw options...]
+// builds one example with shared features in namespace s and, for 50 to 500 actions, action
+// examples with action features each in namespace a, then reports the time per multiline example
+// and per action.  Further arguments, such as -q sa or --cb_type dr, are passed to vw.
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include "../vowpalwabbit/vw.h"
+
+using namespace std;
+
+multi_ex make_example(vw& all, size_t shared, size_t actions, size_t action, bool labeled)
+{
+  multi_ex ec_seq;
+  stringstream ss;
+  ss << "shared |s";
+  for (size_t i = 0; i < shared; i++)
+    ss << " s" << i;
+  ec_seq.push_back(VW::read_example(all, ss.str()));
+
+  for (size_t k = 0; k < actions; k++)
+  {
+    ss.str("");
+    if (labeled && k == 0)
+      ss << "0:1.0:0.5 ";
+    ss << "|a";
+    for (size_t i = 0; i < action; i++)
+      ss << " a" << k << "_" << i;
+    ec_seq.push_back(VW::read_example(all, ss.str()));
+  }
+  return ec_seq;
+}
+
+double time_learn(vw& all, multi_ex& ec_seq, size_t iterations)
+{
+  auto start = chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < iterations; i++)
+    all.learn(ec_seq);
+  auto end = chrono::high_resolution_clock::now();
+  return chrono::duration<double, micro>(end - start).count() / iterations;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t shared = argc > 1 ? atoi(argv[1]) : 100;
+  size_t action = argc > 2 ? atoi(argv[2]) : 10;
+  size_t iterations = argc > 3 ? atoi(argv[3]) : 200;
+  string options = "--cb_adf --quiet -b 22 --ring_size 1200";
+  for (int i = 4; i < argc; i++)
+    options = options + " " + argv[i];
+
+  const size_t actions[] = { 50, 100, 200, 500 };
+  for (size_t k : actions)
+  {
+    vw* all = VW::initialize(options);
+    multi_ex train = make_example(*all, shared, k, action, true);
+    multi_ex test = make_example(*all, shared, k, action, false);
+
+    double learn_us = time_learn(*all, train, iterations);
+    double predict_us = time_learn(*all, test, iterations);
+    printf("%4zu actions  predict %9.2f us (%6.1f ns/action)  learn %9.2f us (%6.1f ns/action)\n", k, predict_us,
+           1000. * predict_us / k, learn_us, 1000. * learn_us / k);
+
+    VW::finish_example(*all, train);
+    VW::finish_example(*all, test);
+    VW::finish(*all);
+  }
+  return 0;
+}
@@ -0,0 +1,127 @@
+// Times the socket AllReduce over loopback:
+//   allreduce_benchmark [nodes] [floats] [rounds]
+// starts a spanning tree server, forks that many nodes and has each of them sum a buffer of floats
+// over the tree rounds times, first reducing and then broadcasting the whole buffer (the tree
+// AllReduce of before) and then with the two pipelined.  Node 0 reports the time per round and
+// the bandwidth, buffer bytes over time; every node checks every sum.
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <chrono>
+#include <vector>
+#include "../vowpalwabbit/allreduce.h"
+#include "../vowpalwabbit/spanning_tree.h"
+
+using namespace std;
+
+void add_float(float& c1, const float& c2) { c1 += c2; }
+
+// small integers, so the sums come out exact in any order
+float value(size_t node, size_t i) { return (float)(node + i % 7); }
+
+template<void (AllReduceSockets::*reduce)(float*, const size_t)>
+double time_rounds(AllReduceSockets& ar, vector<float>& buffer, size_t total, size_t rounds)
+{
+  double seconds = 0.;
+  for (size_t r = 0; r < rounds; r++)
+  {
+    for (size_t i = 0; i < buffer.size(); i++)
+      buffer[i] = value(ar.node, i);
+
+    auto start = chrono::high_resolution_clock::now();
+    (ar.*reduce)(buffer.data(), buffer.size());
+    seconds += chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+    for (size_t i = 0; i < buffer.size(); i++)
+      if (buffer[i] != (float)(total * (total - 1) / 2 + total * (i % 7)))
+      {
+        printf("node %zu: wrong sum %g at %zu\n", ar.node, buffer[i], i);
+        exit(1);
+      }
+  }
+  return seconds / rounds;
+}
+
+void report(const char* name, size_t floats, double seconds)
+{
+  printf("%-10s %10zu floats  %9.3f ms  %8.1f MB/s\n", name, floats, seconds * 1e3, floats * sizeof(float) / seconds / 1e6);
+}
+
+// the tree setup talks a lot on stderr
+void silence_stderr()
+{
+  int null_fd = open("/dev/null", O_WRONLY);
+  dup2(null_fd, 2);
+  close(null_fd);
+}
+
+int run_node(size_t total, size_t node, size_t floats, size_t rounds)
+{
+  silence_stderr();
+  try
+  {
+    AllReduceSockets ar("localhost", 1, total, node);
+    vector<float> buffer(floats);
+    float warm_up = 1.f;
+    ar.all_reduce<float, add_float>(&warm_up, 1);
+
+    double tree = time_rounds<&AllReduceSockets::tree_all_reduce<float, add_float>>(ar, buffer, total, rounds);
+    double pipelined = time_rounds<&AllReduceSockets::all_reduce<float, add_float>>(ar, buffer, total, rounds);
+    if (node == 0)
+    {
+      report("tree", floats, tree);
+      report("pipelined", floats, pipelined);
+    }
+  }
+  catch (VW::vw_exception& e)
+  {
+    printf("node %zu (%s:%d): %s\n", node, e.Filename(), e.LineNumber(), e.what());
+    fflush(stdout);
+    return 1;
+  }
+  fflush(stdout);
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t total = argc > 1 ? atoi(argv[1]) : 4;
+  size_t floats = argc > 2 ? atoi(argv[2]) : 1 << 24;
+  size_t rounds = argc > 3 ? atoi(argv[3]) : 5;
+
+  VW::SpanningTree spanning_tree; // binds its port before any node looks for it
+  pid_t server = fork();
+  if (server == 0)
+  {
+    silence_stderr();
+    dup2(2, 1);
+    spanning_tree.Run();
+    _exit(0);
+  }
+  printf("%zu nodes, %zu rounds\n", total, rounds);
+  fflush(stdout);
+
+  vector<pid_t> nodes;
+  for (size_t node = 0; node < total; node++)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+      _exit(run_node(total, node, floats, rounds));
+    nodes.push_back(pid);
+  }
+
+  int failed = 0;
+  for (pid_t pid : nodes)
+  {
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      failed++;
+  }
+  kill(server, SIGTERM);
+  waitpid(server, nullptr, 0);
+  return failed;
+}
@@ -0,0 +1,66 @@
+// Times prediction and learning on examples dominated by interaction features:
+//   interactions_benchmark [width] [iterations] [bits] [vw options...]
+// builds one example with width features in each of the namespaces a, b and c and reports the
+// cost per generated feature for -q ab (width^2 features) and --cubic abc (width^3 / 8 features).
+// Further arguments, such as --prefetch_distance 8 or --huge_pages transparent, are passed to vw.
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include "../vowpalwabbit/vw.h"
+#include "../vowpalwabbit/gd.h"
+
+using namespace std;
+
+string make_example(size_t width)
+{
+  stringstream ss;
+  ss << "1";
+  for (char ns = 'a'; ns <= 'c'; ns++)
+  {
+    ss << " |" << ns;
+    for (size_t i = 0; i < width; i++)
+      ss << " " << ns << i << ":" << 0.5 + 0.001 * i;
+  }
+  return ss.str();
+}
+
+void run(const char* name, const char* args, string line, size_t features, size_t iterations)
+{
+  vw* all = VW::initialize(args);
+  example* ec = VW::read_example(*all, (char*)line.c_str());
+
+  auto start = chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < iterations; i++)
+    all->learn(*ec);
+  auto learned = chrono::high_resolution_clock::now();
+  float sum = 0.;
+  for (size_t i = 0; i < iterations; i++)
+    sum += GD::inline_predict(*all, *ec);
+  auto predicted = chrono::high_resolution_clock::now();
+
+  double learn_ns = chrono::duration<double, nano>(learned - start).count();
+  double predict_ns = chrono::duration<double, nano>(predicted - learned).count();
+  printf("%-8s %10zu features  predict %6.2f ns/feature  learn %6.2f ns/feature  (%g)\n", name, features,
+         predict_ns / (iterations * features), learn_ns / (iterations * features), sum);
+
+  VW::finish_example(*all, *ec);
+  VW::finish(*all);
+}
+
+int main(int argc, char* argv[])
+{
+  size_t width = argc > 1 ? atoi(argv[1]) : 200;
+  size_t iterations = argc > 2 ? atoi(argv[2]) : 200;
+  string common = string("--quiet --noconstant -b ") + (argc > 3 ? argv[3] : "24");
+  for (int i = 4; i < argc; i++)
+    common = common + " " + argv[i];
+
+  run("-q ab", (common + " -q ab").c_str(), make_example(width), width * width, iterations);
+
+  size_t cubic_width = width / 2;
+  run("--cubic", (common + " --cubic abc").c_str(), make_example(cubic_width),
+      cubic_width * cubic_width * cubic_width, iterations);
+  return 0;
+}
@@ -6,6 +6,7 @@ namespace reinforcement_learning {  namespace name {
       const char *const  MODEL_BLOB_URI          = "model.blob.uri";
       const char *const  MODEL_REFRESH_INTERVAL_MS  = "model.refreshintervalms";
       const char *const  MODEL_IMPLEMENTATION    = "model.implementation";       // VW vs other ML
+      const char *const  MODEL_CONTEXT_CACHE_SIZE = "model.context_cache.size";  // shared contexts kept parsed by each vw object, 0 for none
       const char *const  VW_CMDLINE              = "vw.commandline";
       const char *const  INITIAL_EPSILON         = "initial_exploration.epsilon";
       const char *const  INTERACTION_EH_HOST     = "interaction.eventhub.host";
@@ -26,6 +27,8 @@ namespace reinforcement_learning {  namespace name {
       const char *const  OBSERVATION_SEND_BATCH_INTERVAL_MS   = "observation.send.batchintervalms";
       const char *const  OBSERVATION_SENDER_IMPLEMENTATION    = "observation.sender.implementation";
       const char *const  INTERACTION_SENDER_IMPLEMENTATION    = "interaction.sender.implementation";
+      const char *const  INTERACTION_SERIALIZATION            = "interaction.serialization";
+      const char *const  OBSERVATION_SERIALIZATION            = "observation.serialization";
       const char *const  EH_TEST                 = "eventhub.mock";
       const char *const  TRACE_LOG_IMPLEMENTATION = "trace.logger.implementation";
 }}
@@ -37,5 +40,7 @@ namespace reinforcement_learning {  namespace value {
       const char *const INTERACTION_EH_SENDER = "INTERACTION_EH_SENDER";
       const char *const NULL_TRACE_LOGGER = "NULL_TRACE_LOGGER";
       const char *const CONSOLE_TRACE_LOGGER = "CONSOLE_TRACE_LOGGER";
+      const char *const JSON_SERIALIZATION = "JSON";
+      const char *const BINARY_SERIALIZATION = "BINARY";
 }}
 
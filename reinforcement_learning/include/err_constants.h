@@ -41,6 +41,7 @@ namespace reinforcement_learning { namespace error_code {
   const int eh_connstr_parse_error      = 27;
   const int unhandled_background_error_occurred = 28;
   const int thread_unresponsive_timeout = 29;
+  const int invalid_event_batch         = 30;
   //! [Error Codes]
 }}
 
@@ -73,5 +74,6 @@ namespace reinforcement_learning { namespace error_code {
   char const * const eh_connstr_parse_error_s = "Unable to parse event hub connection string.";
   char const * const unhandled_background_error_occurred_s = "A background thread encountered an error but there was no error handler registered. Register an error handler to see the error code and message.";
   char const * const thread_unresponsive_timeout_s = "A background thread exceeded the watchdog timer.";
+  char const * const invalid_event_batch_s = "Malformed binary event batch: ";
   //! [Error Description]
 }}
@@ -0,0 +1,181 @@
+#include "binary_event.h"
+#include "api_status.h"
+#include "constants.h"
+#include "err_constants.h"
+#include "utility/data_buffer.h"
+
+#include <cstring>
+
+namespace reinforcement_learning {
+  namespace u = utility;
+
+  event_encoding to_event_encoding(const char* value) {
+    return value != nullptr && std::strcmp(value, value::BINARY_SERIALIZATION) == 0 ? event_encoding::binary : event_encoding::json;
+  }
+
+  namespace binary_event {
+    void write_batch_header(u::data_buffer& buffer) {
+      buffer.write(magic, sizeof(magic));
+      write(buffer, schema_version);
+    }
+
+    void write(u::data_buffer& buffer, uint8_t value) {
+      buffer.write(&value, 1);
+    }
+
+    void write(u::data_buffer& buffer, uint32_t value) {
+      const uint8_t bytes[] = {
+        static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+        static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24) };
+      buffer.write(bytes, sizeof(bytes));
+    }
+
+    void write(u::data_buffer& buffer, float value) {
+      uint32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      write(buffer, bits);
+    }
+
+    void write(u::data_buffer& buffer, const char* str, size_t size) {
+      write(buffer, static_cast<uint32_t>(size));
+      buffer.write(str, size);
+    }
+
+    void write(u::data_buffer& buffer, const char* str) {
+      write(buffer, str, std::strlen(str));
+    }
+
+    namespace {
+      // reads [pos, end) of a batch, every read fails once one ran past the end
+      class reader {
+      public:
+        reader(const char* pos, const char* end) : _pos(pos), _end(end) {}
+
+        bool ok() const { return _ok; }
+        bool at_end() const { return _pos == _end; }
+        const char* pos() const { return _pos; }
+
+        uint8_t u8() {
+          if (!has(1)) return 0;
+          return static_cast<uint8_t>(*_pos++);
+        }
+
+        uint32_t u32() {
+          if (!has(4)) return 0;
+          const auto bytes = reinterpret_cast<const uint8_t*>(_pos);
+          _pos += 4;
+          return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+        }
+
+        float f32() {
+          const auto bits = u32();
+          float value;
+          std::memcpy(&value, &bits, sizeof(value));
+          return value;
+        }
+
+        std::string str() {
+          const auto size = u32();
+          if (!has(size)) return std::string();
+          std::string value(_pos, size);
+          _pos += size;
+          return value;
+        }
+
+        void skip(size_t size) {
+          if (has(size)) _pos += size;
+        }
+
+      private:
+        bool has(size_t size) {
+          if (_ok && static_cast<size_t>(_end - _pos) >= size) return true;
+          _ok = false;
+          return false;
+        }
+
+        const char* _pos;
+        const char* _end;
+        bool _ok = true;
+      };
+
+      // the same text ranking_event and outcome_event write in the json encoding
+      void ranking_to_json(reader& in, u::data_buffer& oss) {
+        const auto event_id = in.str();
+        const auto model_id = in.str();
+        const auto context = in.str();
+        const auto count = in.u32();
+
+        oss << R"({"Version":"1","EventId":")" << event_id << R"(","a":[)";
+        const auto actions = in.pos();
+        for (uint32_t i = 0; i < count && in.ok(); ++i) {
+          oss << static_cast<size_t>(in.u32()) + 1;
+          if (i + 1 < count) oss << ",";
+          in.f32();
+        }
+
+        oss << R"(],"c":)" << context << R"(,"p":[)";
+        reader probabilities(actions, in.pos());
+        for (uint32_t i = 0; i < count && in.ok(); ++i) {
+          probabilities.u32();
+          oss << probabilities.f32();
+          if (i + 1 < count) oss << ",";
+        }
+
+        oss << R"(],"VWState":{"m":")" << model_id << R"("})";
+        const auto pass_prob = in.f32();
+        if (pass_prob < 1) {
+          oss << R"(,"pdrop":)" << (1 - pass_prob);
+        }
+        oss << R"(})";
+      }
+    }
+
+    int to_json(const char* batch, size_t size, std::string& json, api_status* status) {
+      if (size < batch_header_size || std::memcmp(batch, magic, sizeof(magic)) != 0) {
+        RETURN_ERROR_LS(nullptr, status, invalid_event_batch) << "no batch header";
+      }
+      if (static_cast<uint8_t>(batch[sizeof(magic)]) != schema_version) {
+        RETURN_ERROR_LS(nullptr, status, invalid_event_batch) << "unknown schema version " << static_cast<int>(batch[sizeof(magic)]);
+      }
+
+      json.clear();
+      u::data_buffer oss(u::translate_func('\n', ' '));
+      reader records(batch + batch_header_size, batch + size);
+      while (!records.at_end()) {
+        const auto record_size = records.u32();
+        const auto record_begin = records.pos();
+        records.skip(record_size);
+        if (!records.ok()) {
+          RETURN_ERROR_LS(nullptr, status, invalid_event_batch) << "record past the end of the batch";
+        }
+
+        reader in(record_begin, record_begin + record_size);
+        oss.reset();
+        switch (in.u8()) {
+        case ranking:
+          ranking_to_json(in, oss);
+          break;
+        case number_outcome: {
+          const auto event_id = in.str();
+          oss << R"({"EventId":")" << event_id << R"(","v":)" << in.f32() << R"(})";
+          break;
+        }
+        case string_outcome: {
+          const auto event_id = in.str();
+          oss << R"({"EventId":")" << event_id << R"(","v":)" << in.str() << R"(})";
+          break;
+        }
+        default:
+          continue;
+        }
+        if (!in.ok()) {
+          RETURN_ERROR_LS(nullptr, status, invalid_event_batch) << "truncated record";
+        }
+
+        if (!json.empty()) json += '\n';
+        json += oss.str();
+      }
+      return error_code::success;
+    }
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace reinforcement_learning {
+  namespace utility { class data_buffer; }
+  class api_status;
+
+  // How the loggers write events: newline separated JSON, or the length-prefixed records below
+  enum class event_encoding { json, binary };
+
+  // value::BINARY_SERIALIZATION selects the binary encoding, anything else JSON
+  event_encoding to_event_encoding(const char* value);
+
+  // A binary batch is the 4 bytes "RLEB", a schema version byte and then the events, one record each:
+  //   u32 size of the rest of the record, u8 kind, then by kind
+  //   ranking:        str event_id, str model_id, str context, u32 n, n * (u32 action_id, f32 probability), f32 pass_prob
+  //   number outcome: str event_id, f32 value
+  //   string outcome: str event_id, str value
+  // where str is a u32 byte count and the bytes.  Integers and floats are little endian, action ids zero based.
+  // A reader skips the records of kinds it does not know by their size.
+  namespace binary_event {
+    const char magic[] = { 'R', 'L', 'E', 'B' };
+    const uint8_t schema_version = 1;
+    const size_t batch_header_size = sizeof(magic) + 1;
+
+    enum record_kind : uint8_t {
+      ranking = 1,
+      number_outcome = 2,
+      string_outcome = 3
+    };
+
+    void write_batch_header(utility::data_buffer& buffer);
+    void write(utility::data_buffer& buffer, uint8_t value);
+    void write(utility::data_buffer& buffer, uint32_t value);
+    void write(utility::data_buffer& buffer, float value);
+    void write(utility::data_buffer& buffer, const char* str, size_t size);
+    void write(utility::data_buffer& buffer, const char* str);
+
+    // Rewrites a binary batch as the newline separated JSON events the json encoding sends for the same events
+    int to_json(const char* batch, size_t size, std::string& json, api_status* status = nullptr);
+  }
+}
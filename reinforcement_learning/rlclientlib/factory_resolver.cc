@@ -84,8 +84,9 @@ namespace reinforcement_learning {
     return error_code::success;
   }
 
-  int vw_model_create(m::i_model** retval, const u::configuration&, i_trace* trace_logger, api_status* status) {
-    *retval = new m::vw_model(trace_logger);
+  int vw_model_create(m::i_model** retval, const u::configuration& config, i_trace* trace_logger, api_status* status) {
+    const auto context_cache_size = config.get_int(name::MODEL_CONTEXT_CACHE_SIZE, 0);
+    *retval = new m::vw_model(trace_logger, context_cache_size > 0 ? context_cache_size : 0);
     return error_code::success;
   }
 
@@ -15,7 +15,8 @@ namespace reinforcement_learning {
   class error_callback_fn;
 
   // This class takes uses a queue and a background thread to accumulate events, and send them by batch asynchronously.
-  // A batch is shipped with TSender::send(data)
+  // A batch is shipped with TSender::send(data): newline separated events for the json encoding, a batch header
+  // and the events' records for the binary one.
   template<typename TEvent>
   class async_batcher {
   public:
@@ -27,7 +28,7 @@ namespace reinforcement_learning {
     int run_iteration(api_status* status);
 
   private:
-    size_t fill_buffer(size_t remaining);
+    size_t fill_buffer(size_t& remaining);
     void prune_if_needed();
     void flush(); //flush all batches
 
@@ -37,7 +38,8 @@ namespace reinforcement_learning {
                   error_callback_fn* perror_cb = nullptr,
                   size_t send_high_water_mark = (1024 * 1024 * 4),
                   size_t batch_timeout_ms = 1000,
-                  size_t queue_max_size = (8 * 1024));
+                  size_t queue_max_size = (8 * 1024),
+                  event_encoding encoding = event_encoding::json);
 
     ~async_batcher();
 
@@ -48,6 +50,7 @@ namespace reinforcement_learning {
     utility::data_buffer _buffer;           // Re-used buffer to prevent re-allocation during sends.
     size_t _send_high_water_mark;
     size_t _queue_max_size;
+    event_encoding _encoding;
     error_callback_fn* _perror_cb;
 
     utility::periodic_background_proc<async_batcher> _periodic_background_proc;
@@ -63,7 +66,14 @@ namespace reinforcement_learning {
 
   template<typename TEvent>
   int async_batcher<TEvent>::append(TEvent&& evt, api_status* status) {
-    _queue.push(std::move(evt));
+    if (!_queue.push(std::move(evt))) {
+      // the queue is full: make room as the size limit would, and give up on the event if that
+      // was not enough
+      _queue.prune(_pass_prob);
+      if (!_queue.push(std::move(evt))) {
+        RETURN_ERROR_LS(nullptr, status, background_queue_overflow);
+      }
+    }
     prune_if_needed();
     return error_code::success;
   }
@@ -86,21 +96,32 @@ namespace reinforcement_learning {
     return error_code::success;
   }
 
+  // the number of events serialized into the buffer
   template<typename TEvent>
-  size_t async_batcher<TEvent>::fill_buffer(size_t remaining)
+  size_t async_batcher<TEvent>::fill_buffer(size_t& remaining)
   {
     TEvent evt;
     _buffer.reset();
+    if (_encoding == event_encoding::binary)
+      binary_event::write_batch_header(_buffer);
 
+    size_t count = 0;
     while (remaining > 0 && _buffer.size() < _send_high_water_mark) {
-      _queue.pop(&evt);
+      // an event its producer is still writing ends the flush, it goes with the next one
+      if (!_queue.pop(&evt)) {
+        remaining = 0;
+        break;
+      }
       evt.serialize(_buffer);
-      _buffer << "\n";
+      if (_encoding == event_encoding::json)
+        _buffer << "\n";
       --remaining;
+      ++count;
     }
-    _buffer.remove_last();
 
-    return remaining;
+    if (count > 0 && _encoding == event_encoding::json)
+      _buffer.remove_last();
+    return count;
   }
 
   template<typename TEvent>
@@ -115,7 +136,8 @@ namespace reinforcement_learning {
     auto remaining = queue_size;
     // Handle batching
     while (remaining > 0) {
-      remaining = fill_buffer(remaining);
+      if (fill_buffer(remaining) == 0)
+        break;
       api_status status;
       if (_sender->send(_buffer.str(), &status) != error_code::success) {
         ERROR_CALLBACK(_perror_cb, status);
@@ -125,10 +147,12 @@ namespace reinforcement_learning {
 
   template<typename TEvent>
   async_batcher<TEvent>::async_batcher(i_sender* sender, utility::watchdog& watchdog, error_callback_fn* perror_cb, const size_t send_high_water_mark,
-    const size_t batch_timeout_ms, const size_t queue_max_size)
+    const size_t batch_timeout_ms, const size_t queue_max_size, const event_encoding encoding)
     : _sender(sender),
+    _queue(queue_max_size),
     _send_high_water_mark(send_high_water_mark),
     _queue_max_size(queue_max_size),
+    _encoding(encoding),
     _perror_cb(perror_cb),
     _periodic_background_proc(static_cast<int>(batch_timeout_ms), watchdog, "Async batcher thread", perror_cb),
     _pass_prob(0.5)
@@ -24,7 +24,8 @@ namespace reinforcement_learning {
       int send_batch_interval_ms,
       int send_queue_maxsize,
       utility::watchdog& watchdog,
-      error_callback_fn* perror_cb = nullptr);
+      error_callback_fn* perror_cb = nullptr,
+      event_encoding encoding = event_encoding::json);
 
     int init(api_status* status);
   
@@ -34,6 +35,7 @@ namespace reinforcement_learning {
 
   protected:
     bool _initialized = false;
+    event_encoding _encoding;
 
     // Handle batching for the data sent to the eventhub client
     async_batcher<TEvent> _batcher;
@@ -48,15 +50,18 @@ namespace reinforcement_learning {
     int send_batch_interval_ms,
     int send_queue_maxsize,
     utility::watchdog& watchdog,
-    error_callback_fn* perror_cb
+    error_callback_fn* perror_cb,
+    event_encoding encoding
   )
-    : _batcher(
+    : _encoding(encoding),
+    _batcher(
       sender,
       watchdog,
       perror_cb,
       send_high_watermark,
       send_batch_interval_ms,
-      send_queue_maxsize),
+      send_queue_maxsize,
+      encoding),
     _buffer_pool(new utility::buffer_factory(utility::translate_func('\n', ' ')))
   {}
 
@@ -93,7 +98,8 @@ namespace reinforcement_learning {
         c.get_int(name::INTERACTION_SEND_BATCH_INTERVAL_MS, 1000),
         c.get_int(name::INTERACTION_SEND_QUEUE_MAXSIZE, 100000 * 2),
         watchdog,
-        perror_cb)
+        perror_cb,
+        to_event_encoding(c.get(name::INTERACTION_SERIALIZATION, value::JSON_SERIALIZATION)))
     {}
 
     int log(const char* event_id, const char* context, const ranking_response& response, api_status* status);
@@ -108,7 +114,8 @@ namespace reinforcement_learning {
         c.get_int(name::OBSERVATION_SEND_BATCH_INTERVAL_MS, 1000),
         c.get_int(name::OBSERVATION_SEND_QUEUE_MAXSIZE, 100000 * 2),
         watchdog,
-        perror_cb)
+        perror_cb,
+        to_event_encoding(c.get(name::OBSERVATION_SERIALIZATION, value::JSON_SERIALIZATION)))
     {}
 
     template <typename D>
@@ -116,7 +123,7 @@ namespace reinforcement_learning {
       // Serialize outcome
       utility::pooled_object_guard<utility::data_buffer, utility::buffer_factory> buffer(_buffer_pool, _buffer_pool.get_or_create());
       buffer->reset();
-      return append(std::move(outcome_event(*buffer.get(), event_id, outcome)), status);
+      return append(std::move(outcome_event(*buffer.get(), event_id, outcome, 1, _encoding)), status);
     }
   };
 }
\ No newline at end of file
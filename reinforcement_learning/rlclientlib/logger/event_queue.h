@@ -2,62 +2,124 @@
 
 #include "ranking_event.h"
 
-#include <list>
-#include <queue>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <type_traits>
 
 namespace reinforcement_learning {
 
-  //a moving concurrent queue with locks and mutex
+  // A bounded queue of events, many producers and one consumer.
+  // Producers claim a slot of a ring with a compare-and-swap on the tail and publish the event by
+  // bumping the slot's sequence number, so push neither locks nor allocates.  The consumer side,
+  // pop and prune, is serialized by a mutex producers never take.
   template <class T>
   class event_queue {
-    using queue_t = std::list<T>;
+    struct cell {
+      std::atomic<size_t> sequence; // pos + 1 once the event at pos is published, pos + capacity once it is consumed
+      T value;
+    };
 
-    queue_t _queue;
-    std::mutex _mutex;
+    std::unique_ptr<cell[]> _cells;
+    size_t _mask;
+    char _pad0[64];
+    std::atomic<size_t> _tail{ 0 };   // next slot for producers
+    char _pad1[64];
+    std::atomic<size_t> _head{ 0 };   // next slot for the consumer
+    std::mutex _consumer_mutex;
     int _drop_pass{ 0 };
 
   public:
-    event_queue() {
+    // room for at least twice max_size events: max_size is where the batcher starts pruning
+    explicit event_queue(size_t max_size = 8 * 1024) {
       static_assert(std::is_base_of<event, T>::value, "T must be a descendant of event");
+      size_t capacity = 2;
+      while (capacity < 2 * max_size)
+        capacity <<= 1;
+      _cells.reset(new cell[capacity]);
+      for (size_t i = 0; i < capacity; ++i)
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+      _mask = capacity - 1;
     }
 
-    void pop(T* item)
+    // false if the queue is empty, or its oldest event is not published yet
+    bool pop(T* item)
     {
-      std::unique_lock<std::mutex> mlock(_mutex);
-      if (!_queue.empty())
-      {
-        *item = std::move(_queue.front());
-        _queue.pop_front();
-      }
+      std::unique_lock<std::mutex> mlock(_consumer_mutex);
+      const size_t pos = _head.load(std::memory_order_relaxed);
+      cell& c = _cells[pos & _mask];
+      if (c.sequence.load(std::memory_order_acquire) != pos + 1)
+        return false;
+      *item = std::move(c.value);
+      c.sequence.store(pos + _mask + 1, std::memory_order_release);
+      _head.store(pos + 1, std::memory_order_release);
+      return true;
     }
 
-    void push(T& item) {
-      push(std::move(item));
+    // false, leaving item as it was, if the queue is full
+    bool push(T& item) {
+      return push(std::move(item));
     }
 
-    void push(T&& item)
+    bool push(T&& item)
     {
-      std::unique_lock<std::mutex> mlock(_mutex);
-      _queue.push_back(std::forward<T>(item));
+      size_t pos = _tail.load(std::memory_order_relaxed);
+      cell* c;
+      for (;;) {
+        c = &_cells[pos & _mask];
+        const size_t seq = c->sequence.load(std::memory_order_acquire);
+        const intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+          if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if (dif < 0)
+          return false; // the slot still holds the event of the previous lap
+        else
+          pos = _tail.load(std::memory_order_relaxed);
+      }
+      c->value = std::forward<T>(item);
+      c->sequence.store(pos + 1, std::memory_order_release);
+      return true;
     }
 
+    // Drops the published events try_drop lets go.  The survivors keep their order and move to
+    // the back of the published stretch, and the head moves past the slots they left, so the
+    // producers filling slots beyond are never in the way.
     void prune(float pass_prob)
     {
-      std::unique_lock<std::mutex> mlock(_mutex);
-      for (typename queue_t::iterator it = _queue.begin(); it != _queue.end();) {
-        it = it->try_drop(pass_prob, _drop_pass) ? _queue.erase(it) : (++it);
+      std::unique_lock<std::mutex> mlock(_consumer_mutex);
+      const size_t head = _head.load(std::memory_order_relaxed);
+      size_t end = head;
+      while (_cells[end & _mask].sequence.load(std::memory_order_acquire) == end + 1)
+        ++end;
+
+      size_t kept = end;
+      for (size_t pos = end; pos-- > head;) {
+        cell& c = _cells[pos & _mask];
+        if (!c.value.try_drop(pass_prob, _drop_pass)) {
+          --kept;
+          if (kept != pos)
+            _cells[kept & _mask].value = std::move(c.value);
+        }
       }
+      for (size_t pos = head; pos < kept; ++pos) {
+        cell& c = _cells[pos & _mask];
+        c.value = T();
+        c.sequence.store(pos + _mask + 1, std::memory_order_release);
+      }
+      _head.store(kept, std::memory_order_release);
       ++_drop_pass;
     }
 
-    //approximate size
+    //approximate size: counts the events producers are still writing
     size_t size()
     {
-      std::unique_lock<std::mutex> mlock(_mutex);
-      return _queue.size();
+      const size_t head = _head.load(std::memory_order_acquire);
+      return _tail.load(std::memory_order_acquire) - head;
     }
+
+    size_t capacity() const { return _mask + 1; }
   };
 }
-
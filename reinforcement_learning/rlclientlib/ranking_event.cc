@@ -51,27 +51,39 @@ namespace reinforcement_learning {
   { }
 
   ranking_event::ranking_event(u::data_buffer& oss, const char* event_id, const char* context,
-    const ranking_response& response, float pass_prob)
+    const ranking_response& response, float pass_prob, event_encoding encoding)
     : event(event_id, pass_prob)
+    , _encoding(encoding)
   {
-    serialize(oss, event_id, context, response, _pass_prob);
+    if (_encoding == event_encoding::binary)
+      serialize_binary(oss, event_id, context, response);
+    else
+      serialize(oss, event_id, context, response, _pass_prob);
     _body = oss.str();
   }
 
   ranking_event::ranking_event(ranking_event&& other)
     : event(std::move(other))
     , _body(std::move(other._body))
+    , _encoding(other._encoding)
   {}
 
   ranking_event& ranking_event::operator=(ranking_event&& other) {
     if (&other != this) {
       event::operator=(std::move(other));
       _body = std::move(other._body);
+      _encoding = other._encoding;
     }
     return *this;
   }
 
   void ranking_event::serialize(u::data_buffer& oss) {
+    if (_encoding == event_encoding::binary) {
+      binary_event::write(oss, static_cast<uint32_t>(_body.size() + sizeof(float)));
+      oss.write(_body.data(), _body.size());
+      binary_event::write(oss, _pass_prob);
+      return;
+    }
     oss << _body;
     if (_pass_prob < 1) {
       oss << R"(,"pdrop":)" << (1 - _pass_prob);
@@ -105,37 +117,67 @@ namespace reinforcement_learning {
     oss << R"(],"VWState":{"m":")" << resp.get_model_id() << R"("})";
 	}
 
+  void ranking_event::serialize_binary(u::data_buffer& oss, const char* event_id, const char* context,
+    const ranking_response& resp) {
+    binary_event::write(oss, static_cast<uint8_t>(binary_event::ranking));
+    binary_event::write(oss, event_id);
+    binary_event::write(oss, resp.get_model_id());
+    binary_event::write(oss, context);
+    binary_event::write(oss, static_cast<uint32_t>(resp.size()));
+    for (auto const &r : resp) {
+      binary_event::write(oss, static_cast<uint32_t>(r.action_id));
+      binary_event::write(oss, r.probability);
+    }
+  }
+
   outcome_event::outcome_event()
   { }
 
-  outcome_event::outcome_event(utility::data_buffer& oss, const char* event_id, const char* outcome, float pass_prob)
+  outcome_event::outcome_event(utility::data_buffer& oss, const char* event_id, const char* outcome, float pass_prob,
+    event_encoding encoding)
     : event(event_id, pass_prob)
+    , _encoding(encoding)
   {
-    serialize(oss, event_id, outcome);
+    if (_encoding == event_encoding::binary)
+      serialize_binary(oss, event_id, outcome);
+    else
+      serialize(oss, event_id, outcome);
     _body = oss.str();
   }
 
-  outcome_event::outcome_event(utility::data_buffer& oss, const char* event_id, float outcome, float pass_prob)
+  outcome_event::outcome_event(utility::data_buffer& oss, const char* event_id, float outcome, float pass_prob,
+    event_encoding encoding)
     : event(event_id)
+    , _encoding(encoding)
   {
-    serialize(oss, event_id, outcome);
+    if (_encoding == event_encoding::binary)
+      serialize_binary(oss, event_id, outcome);
+    else
+      serialize(oss, event_id, outcome);
     _body = oss.str();
   }
 
   outcome_event::outcome_event(outcome_event&& other)
     : event(std::move(other))
     , _body(std::move(other._body))
+    , _encoding(other._encoding)
   { }
 
   outcome_event& outcome_event::operator=(outcome_event&& other) {
     if (&other != this) {
       event::operator=(std::move(other));
       _body = std::move(other._body);
+      _encoding = other._encoding;
     }
     return *this;
   }
 
   void outcome_event::serialize(u::data_buffer& oss) {
+    if (_encoding == event_encoding::binary) {
+      binary_event::write(oss, static_cast<uint32_t>(_body.size()));
+      oss.write(_body.data(), _body.size());
+      return;
+    }
     oss << _body;
   }
 
@@ -146,4 +188,16 @@ namespace reinforcement_learning {
   void outcome_event::serialize(u::data_buffer& oss, const char* event_id, float outcome, float pass_prob) {
     oss << R"({"EventId":")" << event_id << R"(","v":)" << outcome << R"(})";
   }
+
+  void outcome_event::serialize_binary(u::data_buffer& oss, const char* event_id, const char* outcome) {
+    binary_event::write(oss, static_cast<uint8_t>(binary_event::string_outcome));
+    binary_event::write(oss, event_id);
+    binary_event::write(oss, outcome);
+  }
+
+  void outcome_event::serialize_binary(u::data_buffer& oss, const char* event_id, float outcome) {
+    binary_event::write(oss, static_cast<uint8_t>(binary_event::number_outcome));
+    binary_event::write(oss, event_id);
+    binary_event::write(oss, outcome);
+  }
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include "binary_event.h"
 #include <string>
 
 namespace reinforcement_learning {
@@ -33,7 +34,7 @@ namespace reinforcement_learning {
     ranking_event();
 
     ranking_event(utility::data_buffer& oss, const char* event_id, const char* context,
-      const ranking_response& resp, float pass_prob = 1);
+      const ranking_response& resp, float pass_prob = 1, event_encoding encoding = event_encoding::json);
 
     ranking_event(ranking_event&& other);
 
@@ -43,9 +44,13 @@ namespace reinforcement_learning {
   public:
     static void serialize(utility::data_buffer& oss, const char* event_id, const char* context,
       const ranking_response& resp, float pass_prob = 1);
+    //the record of the binary encoding up to the pass probability, which is added at send time
+    static void serialize_binary(utility::data_buffer& oss, const char* event_id, const char* context,
+      const ranking_response& resp);
 
   private:
     std::string _body;
+    event_encoding _encoding = event_encoding::json;
   };
 
   //serializable outcome event
@@ -53,8 +58,10 @@ namespace reinforcement_learning {
   public:
     outcome_event();
 
-    outcome_event(utility::data_buffer& oss, const char* event_id, const char* outcome, float pass_prob = 1);
-    outcome_event(utility::data_buffer& oss, const char* event_id, float outcome, float pass_prob = 1 );
+    outcome_event(utility::data_buffer& oss, const char* event_id, const char* outcome, float pass_prob = 1,
+      event_encoding encoding = event_encoding::json);
+    outcome_event(utility::data_buffer& oss, const char* event_id, float outcome, float pass_prob = 1,
+      event_encoding encoding = event_encoding::json);
 
     outcome_event(outcome_event&& other);
     outcome_event& operator=(outcome_event&& other);
@@ -63,8 +70,12 @@ namespace reinforcement_learning {
   public:
     static void serialize(utility::data_buffer& oss, const char* event_id, const char* outcome, float pass_prob = 1);
     static void serialize(utility::data_buffer& oss, const char* event_id, float outcome, float pass_prob = 1);
+    //records of the binary encoding, without their size
+    static void serialize_binary(utility::data_buffer& oss, const char* event_id, const char* outcome);
+    static void serialize_binary(utility::data_buffer& oss, const char* event_id, float outcome);
 
   private:
     std::string _body;
+    event_encoding _encoding = event_encoding::json;
   };
 }
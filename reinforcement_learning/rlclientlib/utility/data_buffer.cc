@@ -44,6 +44,12 @@ namespace reinforcement_learning { namespace utility {
 
   data_buffer& data_buffer::operator<<(float rhs) { return operator<<(std::to_string(rhs)); }
 
+  data_buffer& data_buffer::write(const void* data, size_t size) {
+    const auto bytes = static_cast<const char*>(data);
+    _buffer.insert(_buffer.end(), bytes, bytes + size);
+    return *this;
+  }
+
   translate_func::translate_func() : empty(true) {}
 
   translate_func::translate_func(char _src, char _dst) : empty(false), src(_src), dst(_dst) {}
@@ -32,6 +32,9 @@ namespace reinforcement_learning { namespace utility {
     data_buffer& operator<<(size_t rhs);
     data_buffer& operator<<(float rhs);
 
+    // copies size bytes as they are, no translation: for the binary event encoding
+    data_buffer& write(const void* data, size_t size);
+
   private:
     std::vector<char> _buffer;
     translate_func translate;
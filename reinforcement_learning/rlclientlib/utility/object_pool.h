@@ -1,4 +1,5 @@
 #pragma once
+#include <chrono>
 #include <mutex>
 #include <vector>
 
@@ -54,17 +55,28 @@ namespace reinforcement_learning { namespace utility {
     TObject* get() { return _obj->val(); }
   };
 
+  struct pool_stats {
+    int version;        // bumped by every update_factory
+    size_t pooled;      // objects waiting in the pool
+    size_t objects;     // objects of the current factory, pooled or in use
+    double warm_ms;     // last update_factory: making the objects of the new factory
+    double swap_us;     // last update_factory: how long the pool was locked to swap them in
+  };
+
   template<typename TObject, typename TFactory>
   class object_pool {
     int _version;
     std::vector<pooled_object<TObject>*> _pool;
     TFactory* _factory;
     std::mutex _mutex;
-    int _used_objects;
+    std::mutex _update_mutex;
+    size_t _used_objects;
+    double _warm_ms;
+    double _swap_us;
 
   public:
     object_pool(TFactory* factory)
-      : _version(0), _factory(factory), _used_objects(0)
+      : _version(0), _factory(factory), _used_objects(0), _warm_ms(0), _swap_us(0)
     { }
 
     object_pool(const object_pool&) = delete;
@@ -110,21 +122,58 @@ namespace reinforcement_learning { namespace utility {
     }
 
     // takes owner-ship of factory (and will free using delete)
+    // The new factory's objects, as many as the old one had made (at least one), are made before the pool
+    // is locked, so the caller pays for them instead of the next requests.  The lock is only held to swap
+    // them in; the old factory and its pooled objects are deleted after.
     void update_factory(TFactory* new_factory) {
-      std::lock_guard<std::mutex> lock(_mutex);
+      using clock = std::chrono::steady_clock;
+      std::lock_guard<std::mutex> update_lock(_update_mutex);
+
+      const auto warm_start = clock::now();
+      size_t objects;
+      int version;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        objects = _used_objects > 0 ? _used_objects : 1;
+        version = _version + 1;
+      }
 
-      // use new factory and delete old one
-      if (_factory)
-        delete _factory;
-      _factory = new_factory;
+      std::vector<pooled_object<TObject>*> warm;
+      try {
+        for (size_t i = 0; i < objects; ++i)
+          warm.push_back(new pooled_object<TObject>((*new_factory)(), version));
+      }
+      catch (...) {
+        for (auto&& obj : warm)
+          delete obj;
+        delete new_factory;
+        throw;
+      }
 
-      // increment the version
-      _version++;
+      const auto swap_start = clock::now();
+      TFactory* old_factory;
+      std::vector<pooled_object<TObject>*> old_objects;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        old_factory = _factory;
+        _factory = new_factory;
+        _version = version;
+        _pool.swap(old_objects);
+        _pool.swap(warm);
+        _used_objects = _pool.size();
+        _warm_ms = std::chrono::duration<double, std::milli>(swap_start - warm_start).count();
+        _swap_us = std::chrono::duration<double, std::micro>(clock::now() - swap_start).count();
+      }
 
-      // dispose old objects
-      for (auto&& obj : _pool)
+      // dispose old objects; the ones in use are deleted as they come back
+      for (auto&& obj : old_objects)
         delete obj;
-      _pool.clear();
+      delete old_factory;
+    }
+
+    pool_stats stats() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return { _version, _pool.size(), _used_objects, _warm_ms, _swap_us };
     }
   };
 }}
@@ -0,0 +1,174 @@
+#include "context_cache.h"
+#include "hash.h"
+
+#include <cstring>
+#include <iterator>
+
+namespace reinforcement_learning {
+
+  namespace {
+    const char* skip_space(const char* p) {
+      while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        ++p;
+      return p;
+    }
+
+    // past the closing quote of the string opening at p, nullptr if it is not closed
+    const char* skip_string(const char* p) {
+      for (++p; *p != '"'; ++p) {
+        if (*p == '\0')
+          return nullptr;
+        if (*p == '\\' && *++p == '\0')
+          return nullptr;
+      }
+      return p + 1;
+    }
+
+    // past the value starting at p: the ',' or '}' after a number or literal
+    const char* skip_value(const char* p) {
+      int depth = 0;
+      for (;;) {
+        switch (*p) {
+        case '\0':
+          return nullptr;
+        case '"':
+          p = skip_string(p);
+          if (p == nullptr || depth == 0)
+            return p;
+          continue;
+        case '{':
+        case '[':
+          ++depth;
+          break;
+        case '}':
+        case ']':
+          if (depth == 0)
+            return p;
+          if (--depth == 0)
+            return p + 1;
+          break;
+        case ',':
+          if (depth == 0)
+            return p;
+          break;
+        }
+        ++p;
+      }
+    }
+  }
+
+  context_cache::entry::~entry()
+  {
+    for (auto& group : _groups)
+      group.second.delete_v();
+  }
+
+  void context_cache::entry::assign(uint64_t hash, const std::string& shared, example& ex)
+  {
+    _hash = hash;
+    _shared = shared;
+    for (size_t i = ex.indices.size(); i < _groups.size(); ++i)
+      _groups[i].second.delete_v();
+    _groups.resize(ex.indices.size());
+    for (size_t i = 0; i < _groups.size(); ++i) {
+      _groups[i].first = ex.indices[i];
+      _groups[i].second.deep_copy_from(ex.feature_space[ex.indices[i]]);
+    }
+  }
+
+  void context_cache::entry::copy_to(example& ex) const
+  {
+    for (auto& group : _groups) {
+      ex.feature_space[group.first].deep_copy_from(group.second);
+      ex.indices.push_back(group.first);
+    }
+  }
+
+  context_cache::context_cache(size_t capacity)
+    : _capacity(capacity)
+  {}
+
+  bool context_cache::split(const char* context, std::string& shared, const char*& actions_begin, const char*& actions_end)
+  {
+    const char* multi_begin = nullptr;
+    const char* multi_end = nullptr;
+
+    const char* p = skip_space(context);
+    if (*p != '{')
+      return false;
+    p = skip_space(p + 1);
+    while (*p != '}') {
+      if (*p != '"')
+        return false;
+      const char* key = p + 1;
+      p = skip_string(p);
+      if (p == nullptr)
+        return false;
+      const size_t key_length = p - 1 - key;
+      p = skip_space(p);
+      if (*p != ':')
+        return false;
+      const char* value = skip_space(p + 1);
+      p = skip_value(value);
+      if (p == nullptr)
+        return false;
+
+      if (key_length > 0 && key[0] == '_') {
+        if (key_length != 6 || strncmp(key, "_multi", 6) != 0 || *value != '[' || multi_begin != nullptr)
+          return false;
+        multi_begin = key - 1;
+        multi_end = p;
+        actions_begin = value;
+        actions_end = p;
+      }
+
+      p = skip_space(p);
+      if (*p == ',')
+        p = skip_space(p + 1);
+      else if (*p != '}')
+        return false;
+    }
+    if (multi_begin == nullptr)
+      return false;
+
+    shared.assign(context, multi_begin);
+    shared.append(multi_end);
+    return true;
+  }
+
+  const context_cache::entry* context_cache::find(const std::string& shared)
+  {
+    const auto it = _index.find(uniform_hash(shared.data(), shared.size(), 0));
+    if (it == _index.end() || it->second->shared() != shared) {
+      ++_misses;
+      return nullptr;
+    }
+    ++_hits;
+    _entries.splice(_entries.begin(), _entries, it->second);
+    return &_entries.front();
+  }
+
+  void context_cache::put(const std::string& shared, example& ex)
+  {
+    if (_capacity == 0)
+      return;
+    const auto hash = uniform_hash(shared.data(), shared.size(), 0);
+
+    // a context of the same hash is replaced, else the least recently used one once the cache is full:
+    // the entry is reused, and so is the room of its features
+    const auto it = _index.find(hash);
+    if (it != _index.end()) {
+      _entries.splice(_entries.begin(), _entries, it->second);
+    }
+    else {
+      if (_entries.size() >= _capacity) {
+        _index.erase(_entries.back().hash());
+        _entries.splice(_entries.begin(), _entries, std::prev(_entries.end()));
+      }
+      else
+        _entries.emplace_front();
+      _index[hash] = _entries.begin();
+    }
+    _entries.front().assign(hash, shared, ex);
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../../vowpalwabbit/example.h"
+
+namespace reinforcement_learning {
+
+  // Least recently used cache of the parsed and hashed features of the shared example, keyed by the
+  // shared part of a context: the context without its "_multi" member.  A context whose shared part is
+  // cached only needs its actions parsed.
+  class context_cache {
+  public:
+    class entry {
+      uint64_t _hash;
+      std::string _shared;
+      std::vector<std::pair<namespace_index, features>> _groups;
+
+    public:
+      entry() : _hash(0) {}
+      ~entry();
+      entry(const entry&) = delete;
+      entry& operator=(const entry&) = delete;
+
+      uint64_t hash() const { return _hash; }
+      const std::string& shared() const { return _shared; }
+
+      // takes the features of ex, reusing the room of the ones it had
+      void assign(uint64_t hash, const std::string& shared, example& ex);
+
+      // adds the features to an example that has none in these namespaces
+      void copy_to(example& ex) const;
+    };
+
+    explicit context_cache(size_t capacity);
+
+    // Splits a context into its shared part, and the array of "_multi" at [actions_begin, actions_end).
+    // false if there is no top level "_multi" array, or other top level keys start with '_': those may set
+    // more than the features of the shared example.
+    static bool split(const char* context, std::string& shared, const char*& actions_begin, const char*& actions_end);
+
+    // nullptr on a miss; valid until the next put
+    const entry* find(const std::string& shared);
+
+    // remembers the features of the shared example ex parsed from a context with this shared part
+    void put(const std::string& shared, example& ex);
+
+    size_t size() const { return _entries.size(); }
+    size_t hits() const { return _hits; }
+    size_t misses() const { return _misses; }
+
+  private:
+    size_t _capacity;
+    std::list<entry> _entries; // most recently used first
+    std::unordered_map<uint64_t, std::list<entry>::iterator> _index;
+    size_t _hits = 0;
+    size_t _misses = 0;
+  };
+}
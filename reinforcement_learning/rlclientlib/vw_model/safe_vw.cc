@@ -4,52 +4,49 @@
 
 namespace reinforcement_learning {
 
+  // Reads a model in place: the model bytes are handed to io_buf as the space it has already loaded,
+  // so reads return pointers into them rather than copying them through a buffer of its own.
   class in_memory_buf : public io_buf
   {
-  private:
-    const char* _model_data;
-    const char* _model_data_end;
-    const char* _current;
-
   public:
     in_memory_buf(const char* model_data, size_t len)
-      : _model_data(model_data), _model_data_end(model_data + len), _current(model_data)
     {
+      space.delete_v();
+      // io_buf only ever reads through space here: fill and compact below never write to it
+      space.begin() = const_cast<char*>(model_data);
+      space.end() = space.begin() + len;
+      space.end_array = space.end();
+      head = space.begin();
       files.push_back(0);
     }
 
+    ~in_memory_buf()
+    {
+      // the bytes are not ours to free
+      space.begin() = space.end() = space.end_array = nullptr;
+    }
+
     in_memory_buf(const in_memory_buf&) = delete;
     in_memory_buf& operator=(const in_memory_buf& other) = delete;
     in_memory_buf(in_memory_buf&& other) = delete;
 
     virtual int open_file(const char* name, bool stdin_off, int flag = READ)
     {
-      _current = _model_data;
+      head = space.begin();
       return 0;
     }
 
     virtual void reset_file(int f)
     {
-      _current = _model_data;
+      head = space.begin();
     }
 
-    virtual ssize_t read_file(int f, void* buf, size_t nbytes)
-    {
-      size_t left_over = min(nbytes, (size_t)(_model_data_end - _current));
-
-      if (left_over == 0)
-        return 0;
+    // everything is loaded from the start
+    virtual ssize_t fill(int f) { return 0; }
 
-#ifdef WIN32
-      memcpy_s(buf, nbytes, &*_current, left_over);
-#else
-      memcpy(buf, &*_current, left_over);
-#endif
+    virtual void compact() {}
 
-      _current += left_over;
-
-      return left_over;
-    }
+    virtual ssize_t read_file(int f, void* buf, size_t nbytes) { return 0; }
 
     virtual size_t num_files() { return 1; }
 
@@ -61,9 +58,11 @@ namespace reinforcement_learning {
   };
 
 
-  safe_vw::safe_vw(const std::shared_ptr<safe_vw>& master) : _master(master)
+  safe_vw::safe_vw(const std::shared_ptr<safe_vw>& master, size_t context_cache_size) : _master(master)
   {
     _vw = VW::seed_vw_model(_master->_vw, "", nullptr, nullptr);
+    if (context_cache_size > 0)
+      _context_cache.reset(new context_cache(context_cache_size));
   }
 
   safe_vw::safe_vw(const char* model_data, size_t len)
@@ -115,9 +114,30 @@ namespace reinforcement_learning {
     auto examples = v_init<example*>();
     examples.push_back(get_or_create_example());
 
-    std::vector<char> line_vec(context, context + strlen(context) + 1);
+    std::string shared;
+    const char* actions_begin;
+    const char* actions_end;
+    const bool cacheable = _context_cache && context_cache::split(context, shared, actions_begin, actions_end);
+    const context_cache::entry* cached = cacheable ? _context_cache->find(shared) : nullptr;
+
+    if (cached != nullptr) {
+      // the shared example comes from the cache, only the actions are parsed
+      static const char multi[] = R"({"_multi":)";
+      std::vector<char> line_vec(multi, multi + sizeof(multi) - 1);
+      line_vec.insert(line_vec.end(), actions_begin, actions_end);
+      line_vec.push_back('}');
+      line_vec.push_back('\0');
+
+      VW::read_line_json<false>(*_vw, examples, &line_vec[0], get_or_create_example_f, this);
+      cached->copy_to(*examples[0]);
+    }
+    else {
+      std::vector<char> line_vec(context, context + strlen(context) + 1);
 
-    VW::read_line_json<false>(*_vw, examples, &line_vec[0], get_or_create_example_f, this);
+      VW::read_line_json<false>(*_vw, examples, &line_vec[0], get_or_create_example_f, this);
+      if (cacheable)
+        _context_cache->put(shared, *examples[0]);
+    }
 
     // finalize example
     VW::setup_examples(*_vw, examples);
@@ -148,17 +168,27 @@ const char* safe_vw::id() const {
   return _vw->id.c_str();
 }
 
-safe_vw_factory::safe_vw_factory(const model_management::model_data& master_data)
-  : _master_data(master_data)
+safe_vw_factory::safe_vw_factory(const model_management::model_data& master_data, size_t context_cache_size)
+  : _master(load_master(master_data)), _context_cache_size(context_cache_size)
   {}
 
-safe_vw_factory::safe_vw_factory(const model_management::model_data&& master_data)
-  : _master_data(master_data)
+safe_vw_factory::safe_vw_factory(const model_management::model_data&& master_data, size_t context_cache_size)
+  : _master(load_master(master_data)), _context_cache_size(context_cache_size)
   {}
 
+  std::shared_ptr<safe_vw> safe_vw_factory::load_master(const model_management::model_data& master_data)
+  {
+    // without model data there is nothing to share: every object fails to load on its own, as it always did
+    if (master_data.data_sz() == 0)
+      return nullptr;
+    return std::make_shared<safe_vw>(master_data.data(), master_data.data_sz());
+  }
+
   safe_vw* safe_vw_factory::operator()()
   {
-    // Construct new vw object from raw model data.
-    return new safe_vw(_master_data.data(), _master_data.data_sz());
+    if (!_master)
+      return new safe_vw(nullptr, 0);
+    // Seed a new vw object from the master: it shares the master's weights, nothing is read or copied.
+    return new safe_vw(_master, _context_cache_size);
   }
 }
@@ -4,6 +4,7 @@
 #include <memory>
 #include "../../vowpalwabbit/vw.h"
 #include "model_mgmt.h"
+#include "context_cache.h"
 
 namespace reinforcement_learning {
 
@@ -12,12 +13,14 @@ namespace reinforcement_learning {
     std::shared_ptr<safe_vw> _master;
     vw* _vw;
     std::vector<example*> _example_pool;
+    std::unique_ptr<context_cache> _context_cache;
 
     example* get_or_create_example();
     static example& get_or_create_example_f(void* vw);
 
   public:
-    safe_vw(const std::shared_ptr<safe_vw>& master);
+    // context_cache_size: how many shared parts of contexts rank keeps parsed, none if 0
+    safe_vw(const std::shared_ptr<safe_vw>& master, size_t context_cache_size = 0);
     safe_vw(const char* model_data, size_t len);
 
     ~safe_vw();
@@ -29,12 +32,16 @@ namespace reinforcement_learning {
   };
 
   class safe_vw_factory {
-    model_management::model_data _master_data;
+    // The model is read once, into the master, when the factory is made; the objects of the pool are
+    // seeded from it and share its weights.  No copy of the model data is kept.
+    std::shared_ptr<safe_vw> _master;
+    size_t _context_cache_size;
+
+    static std::shared_ptr<safe_vw> load_master(const model_management::model_data& master_data);
 
   public:
-    // model_data is copied and stored in the factory object.
-    safe_vw_factory(const model_management::model_data& master_data);
-    safe_vw_factory(const model_management::model_data&& master_data);
+    safe_vw_factory(const model_management::model_data& master_data, size_t context_cache_size = 0);
+    safe_vw_factory(const model_management::model_data&& master_data, size_t context_cache_size = 0);
 
     safe_vw* operator()();
   };
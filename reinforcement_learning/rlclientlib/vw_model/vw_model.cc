@@ -9,16 +9,21 @@
 namespace e = exploration;
 namespace reinforcement_learning { namespace model_management {
 
-  vw_model::vw_model(i_trace* trace_logger) :
-    _vw_pool(nullptr) , _trace_logger(trace_logger) {
+  vw_model::vw_model(i_trace* trace_logger, size_t context_cache_size) :
+    _vw_pool(nullptr) , _trace_logger(trace_logger), _context_cache_size(context_cache_size) {
   }
 
   int vw_model::update(const model_data& data, api_status* status) {
     try {
       TRACE_INFO(_trace_logger, utility::concat("Recieved new model data. With size ", data.data_sz()));
       
-      // safe_vw_factory will create a copy of the model data to use for vw object construction.
-      _vw_pool.update_factory(new safe_vw_factory(std::move(data)));
+      // safe_vw_factory reads the model here, once; the pooled vw objects share its weights.
+      // They are made here too, so no request waits on them.
+      _vw_pool.update_factory(new safe_vw_factory(data, _context_cache_size));
+
+      const auto stats = _vw_pool.stats();
+      TRACE_INFO(_trace_logger, utility::concat("Model swapped in. ", stats.objects, " vw objects warmed in ",
+        stats.warm_ms, " ms, pool locked for ", stats.swap_us, " us"));
     }
     catch(const std::exception& e) {
       RETURN_ERROR_LS(_trace_logger, status, model_update_error) << e.what();
@@ -10,7 +10,7 @@ namespace reinforcement_learning {
 namespace reinforcement_learning { namespace model_management {
   class vw_model : public i_model {
   public:
-    vw_model(i_trace* trace_logger);
+    vw_model(i_trace* trace_logger, size_t context_cache_size = 0);
     int update(const model_data& data, api_status* status = nullptr) override;
     int choose_rank(uint64_t rnd_seed, const char* features, ranking_response& response, api_status* status = nullptr) override;
   private:
@@ -18,5 +18,6 @@ namespace reinforcement_learning { namespace model_management {
     using pooled_vw = utility::pooled_object_guard<safe_vw, safe_vw_factory>;
     utility::object_pool<safe_vw, safe_vw_factory> _vw_pool;
     i_trace* _trace_logger;
+    size_t _context_cache_size;
   };
 }}
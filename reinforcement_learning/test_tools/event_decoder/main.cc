@@ -0,0 +1,43 @@
+// Prints the events of binary batches (interaction.serialization or observation.serialization set to BINARY)
+// as the newline separated JSON the default encoding would have sent, one batch per file.
+#include "binary_event.h"
+#include "api_status.h"
+#include "err_constants.h"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+namespace r = reinforcement_learning;
+using namespace std;
+
+int decode(istream& in, const char* name) {
+  const string batch((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  string json;
+  r::api_status status;
+  if (r::binary_event::to_json(batch.data(), batch.size(), json, &status) != r::error_code::success) {
+    cerr << name << ": " << status.get_error_msg() << endl;
+    return 1;
+  }
+  if (!json.empty())
+    cout << json << endl;
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2)
+    return decode(cin, "stdin");
+
+  int ret = 0;
+  for (int i = 1; i < argc; ++i) {
+    ifstream in(argv[i], ios::binary);
+    if (!in) {
+      cerr << argv[i] << ": cannot open" << endl;
+      ret = 1;
+      continue;
+    }
+    ret |= decode(in, argv[i]);
+  }
+  return ret;
+}
@@ -0,0 +1,158 @@
+// Contention benchmark for the logging queue on the request path: many producer threads push
+// events while one consumer drains them the way async_batcher::flush does, every batch interval.
+// The lock-free event_queue is timed against the std::list and single mutex it replaced.
+#include "logger/event_queue.h"
+#include "utility/data_buffer.h"
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace po = boost::program_options;
+namespace r = reinforcement_learning;
+using namespace std;
+using clock_type = chrono::high_resolution_clock;
+
+class bench_event : public r::event {
+public:
+  bench_event() {}
+  bench_event(const string& id) : event(id.c_str()) {}
+  bench_event(bench_event&& other) : event(std::move(other)) {}
+  bench_event& operator=(bench_event&& other) {
+    if (&other != this) event::operator=(std::move(other));
+    return *this;
+  }
+  void serialize(r::utility::data_buffer& buffer) override { buffer << _event_id; }
+};
+
+// event_queue as it was: a list node per event, one mutex for producers and consumer alike
+class locked_list_queue {
+  list<bench_event> _queue;
+  mutex _mutex;
+  int _drop_pass{ 0 };
+
+public:
+  explicit locked_list_queue(size_t) {}
+
+  bool pop(bench_event* item) {
+    unique_lock<mutex> mlock(_mutex);
+    if (_queue.empty()) return false;
+    *item = std::move(_queue.front());
+    _queue.pop_front();
+    return true;
+  }
+
+  bool push(bench_event&& item) {
+    unique_lock<mutex> mlock(_mutex);
+    _queue.push_back(std::move(item));
+    return true;
+  }
+
+  void prune(float pass_prob) {
+    unique_lock<mutex> mlock(_mutex);
+    for (auto it = _queue.begin(); it != _queue.end();)
+      it = it->try_drop(pass_prob, _drop_pass) ? _queue.erase(it) : (++it);
+    ++_drop_pass;
+  }
+
+  size_t size() {
+    unique_lock<mutex> mlock(_mutex);
+    return _queue.size();
+  }
+};
+
+struct result {
+  double seconds;
+  size_t pushed;
+  size_t consumed;
+  double p50_ns;
+  double p99_ns;
+};
+
+template <typename Queue>
+result run(size_t producers, size_t events, size_t queue_max_size, size_t flush_ms) {
+  Queue queue(queue_max_size);
+  atomic<bool> done{ false };
+  atomic<size_t> pushed{ 0 };
+  size_t consumed = 0;
+
+  // the batcher's background thread: wake up, pop what is there, serialize it
+  thread consumer([&]() {
+    bench_event evt;
+    r::utility::data_buffer buffer;
+    while (!done.load()) {
+      this_thread::sleep_for(chrono::milliseconds(flush_ms));
+      buffer.reset();
+      for (size_t n = queue.size(); n > 0 && queue.pop(&evt); --n) {
+        evt.serialize(buffer);
+        ++consumed;
+      }
+    }
+    while (queue.pop(&evt)) ++consumed;
+  });
+
+  vector<vector<double>> latencies(producers);
+  const auto start = clock_type::now();
+  vector<thread> threads;
+  for (size_t p = 0; p < producers; ++p)
+    threads.emplace_back([&, p]() {
+      const string prefix = to_string(p) + "-";
+      latencies[p].reserve(events);
+      for (size_t i = 0; i < events; ++i) {
+        bench_event evt(prefix + to_string(i));
+        const auto before = clock_type::now();
+        bool ok = queue.push(std::move(evt));
+        if (queue.size() > queue_max_size) // async_batcher::append's prune_if_needed
+          queue.prune(0.5);
+        latencies[p].push_back(chrono::duration<double, nano>(clock_type::now() - before).count());
+        if (ok) ++pushed;
+      }
+    });
+  for (auto& t : threads) t.join();
+  const double seconds = chrono::duration<double>(clock_type::now() - start).count();
+  done = true;
+  consumer.join();
+
+  vector<double> all;
+  for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+  sort(all.begin(), all.end());
+  return { seconds, pushed.load(), consumed, all[all.size() / 2], all[all.size() * 99 / 100] };
+}
+
+void report(const char* name, size_t producers, size_t events, const result& res) {
+  cout << name << ": " << producers * events / res.seconds / 1e6 << " M events/s, push p50 " << res.p50_ns
+    << " ns, p99 " << res.p99_ns << " ns (" << res.pushed << " queued, " << res.consumed << " sent, the rest pruned)" << endl;
+}
+
+int main(int argc, char** argv) {
+  po::options_description desc("Options");
+  desc.add_options()
+    ("help", "produce help message")
+    ("producers,p", po::value<size_t>()->default_value(64), "Producer threads")
+    ("events,n", po::value<size_t>()->default_value(20000), "Events per producer")
+    ("queue_max_size,q", po::value<size_t>()->default_value(8 * 1024), "Queue size past which events are pruned")
+    ("flush_ms,f", po::value<size_t>()->default_value(10), "Consumer batch interval in ms")
+    ;
+  po::variables_map vm;
+  store(parse_command_line(argc, argv, desc), vm);
+  if (vm.count("help")) {
+    cout << desc << endl;
+    return 0;
+  }
+
+  const size_t producers = vm["producers"].as<size_t>();
+  const size_t events = vm["events"].as<size_t>();
+  const size_t queue_max_size = vm["queue_max_size"].as<size_t>();
+  const size_t flush_ms = vm["flush_ms"].as<size_t>();
+
+  report("std::list + mutex", producers, events, run<locked_list_queue>(producers, events, queue_max_size, flush_ms));
+  report("event_queue      ", producers, events, run<r::event_queue<bench_event>>(producers, events, queue_max_size, flush_ms));
+  return 0;
+}
@@ -0,0 +1,103 @@
+// Serialization cost of the logged events, JSON against the binary encoding: each event is built the way
+// interaction_logger and observation_logger build it, from a reused translating buffer, and written into
+// a batch the way async_batcher fills one.
+#include "ranking_event.h"
+#include "ranking_response.h"
+#include "utility/data_buffer.h"
+
+#include <boost/program_options.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace po = boost::program_options;
+namespace r = reinforcement_learning;
+using namespace std;
+using clock_type = chrono::high_resolution_clock;
+
+struct result {
+  double events_per_second;
+  double bytes_per_event;
+};
+
+string make_context(size_t actions, size_t features) {
+  string context = R"({"GUser":{"id":"a","major":"eng","hobby":"hiking"},"_multi":[)";
+  for (size_t a = 0; a < actions; ++a) {
+    context += R"({"TAction":{)";
+    for (size_t f = 0; f < features; ++f)
+      context += "\"f" + to_string(f) + "\":" + to_string(a * features + f) + (f + 1 < features ? "," : "");
+    context += a + 1 < actions ? "}}," : "}}";
+  }
+  return context + "]}";
+}
+
+result run(r::event_encoding encoding, size_t events, const string& context, const r::ranking_response& response, size_t batch_size) {
+  r::utility::data_buffer oss(r::utility::translate_func('\n', ' '));
+  r::utility::data_buffer batch;
+  size_t bytes = 0;
+  size_t in_batch = 0;
+
+  const auto start = clock_type::now();
+  for (size_t i = 0; i < events; ++i) {
+    if (in_batch == 0) {
+      bytes += batch.size();
+      batch.reset();
+      if (encoding == r::event_encoding::binary)
+        r::binary_event::write_batch_header(batch);
+    }
+    const string event_id = "0b5e6c3a-" + to_string(i);
+
+    oss.reset();
+    r::ranking_event ranking(oss, event_id.c_str(), context.c_str(), response, 1, encoding);
+    ranking.serialize(batch);
+    if (encoding == r::event_encoding::json) batch << "\n";
+
+    oss.reset();
+    r::outcome_event outcome(oss, event_id.c_str(), 1.0f, 1, encoding);
+    outcome.serialize(batch);
+    if (encoding == r::event_encoding::json) batch << "\n";
+
+    in_batch = (in_batch + 1) % batch_size;
+  }
+  bytes += batch.size();
+  const double seconds = chrono::duration<double>(clock_type::now() - start).count();
+
+  return { 2 * events / seconds, bytes / (2.0 * events) };
+}
+
+void report(const char* name, const result& res) {
+  cout << name << ": " << res.events_per_second / 1e6 << " M events/s, " << res.bytes_per_event << " bytes/event" << endl;
+}
+
+int main(int argc, char** argv) {
+  po::options_description desc("Options");
+  desc.add_options()
+    ("help", "produce help message")
+    ("events,n", po::value<size_t>()->default_value(200000), "Ranking and outcome event pairs")
+    ("actions,a", po::value<size_t>()->default_value(10), "Actions per ranking")
+    ("features,f", po::value<size_t>()->default_value(8), "Features per action in the context")
+    ("batch,b", po::value<size_t>()->default_value(1000), "Event pairs per batch")
+    ;
+  po::variables_map vm;
+  store(parse_command_line(argc, argv, desc), vm);
+  if (vm.count("help")) {
+    cout << desc << endl;
+    return 0;
+  }
+
+  const size_t events = vm["events"].as<size_t>();
+  const size_t actions = vm["actions"].as<size_t>();
+  const string context = make_context(actions, vm["features"].as<size_t>());
+  const size_t batch_size = vm["batch"].as<size_t>();
+
+  r::ranking_response response("event_id");
+  for (size_t a = 0; a < actions; ++a)
+    response.push_back(a, a == 0 ? 0.9f + 0.1f / actions : 0.1f / actions);
+  response.set_model_id("2018-09-06T18:24:52.1234567Z");
+
+  cout << "context of " << context.size() << " bytes" << endl;
+  report("JSON  ", run(r::event_encoding::json, events, context, response, batch_size));
+  report("binary", run(r::event_encoding::binary, events, context, response, batch_size));
+  return 0;
+}
@@ -142,6 +142,29 @@ BOOST_AUTO_TEST_CASE(flush_after_deletion)
   BOOST_CHECK_EQUAL(items.front(), expected);
 }
 
+//test that a binary batch is a header followed by the records, nothing in between
+BOOST_AUTO_TEST_CASE(flush_binary_batch)
+{
+  std::vector<std::string> items;
+  auto s = new sender(items);
+  utility::watchdog watchdog(nullptr);
+  auto batcher = new async_batcher<outcome_event>(s, watchdog, nullptr, 262143, 1000, 8192, event_encoding::binary);
+  batcher->init(nullptr);
+
+  utility::data_buffer oss;
+  batcher->append(outcome_event(oss, "foo", 1.0f, 1, event_encoding::binary));
+  oss.reset();
+  batcher->append(outcome_event(oss, "bar", "{}", 1, event_encoding::binary));
+  delete batcher;
+
+  BOOST_REQUIRE_EQUAL(items.size(), 1);
+  std::string json;
+  BOOST_REQUIRE_EQUAL(binary_event::to_json(items[0].data(), items[0].size(), json), error_code::success);
+  BOOST_CHECK_EQUAL(json, "{\"EventId\":\"foo\",\"v\":1.000000}\n{\"EventId\":\"bar\",\"v\":{}}");
+  //header, then 4 + 1 + 4 + 3 + 4 bytes and 4 + 1 + 4 + 3 + 4 + 2 bytes
+  BOOST_CHECK_EQUAL(items[0].size(), binary_event::batch_header_size + 16 + 18);
+}
+
 //test that events are dropped if the queue max capacity is reached
 /*BOOST_AUTO_TEST_CASE(queue_overflow_drop_event)
 {
@@ -6,6 +6,8 @@
 #include "utility/data_buffer.h"
 #include "logger/event_queue.h"
 #include <boost/test/unit_test.hpp>
+#include <thread>
+#include <vector>
 
 using namespace reinforcement_learning;
 using namespace std;
@@ -134,3 +136,85 @@ BOOST_AUTO_TEST_CASE(queue_move_push)
   queue.pop(&item);
   BOOST_CHECK_EQUAL(item.str(), "hello");
 }
+
+BOOST_AUTO_TEST_CASE(queue_full)
+{
+  event_queue<test_event> queue(2);
+  BOOST_CHECK_EQUAL(queue.capacity(), 4);
+  for (int i = 0; i < 4; ++i)
+    BOOST_CHECK(queue.push(test_event(std::to_string(i))));
+
+  // a push that fails leaves the event with the caller
+  test_event extra("extra");
+  BOOST_CHECK(!queue.push(extra));
+  BOOST_CHECK_EQUAL(extra.str(), "extra");
+
+  test_event item;
+  BOOST_CHECK(queue.pop(&item));
+  BOOST_CHECK_EQUAL(item.str(), "0");
+  BOOST_CHECK(queue.push(extra));
+  BOOST_CHECK_EQUAL(queue.size(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(prune_across_the_ring_end) {
+  event_queue<test_event> queue(4);
+  test_event val;
+  // move the head to the last slots of the ring, so what follows wraps around
+  for (int i = 0; i < 6; ++i) {
+    queue.push(test_event("x"));
+    queue.pop(&val);
+  }
+  queue.push(test_event("no_drop_1"));
+  queue.push(test_event("drop_1"));
+  queue.push(test_event("drop_2"));
+  queue.push(test_event("no_drop_2"));
+  queue.push(test_event("drop_3"));
+  queue.push(test_event("no_drop_3"));
+  queue.prune(1.0);
+
+  BOOST_CHECK_EQUAL(queue.size(), 3);
+  for (int i = 1; i <= 3; ++i) {
+    BOOST_CHECK(queue.pop(&val));
+    BOOST_CHECK_EQUAL(val.str(), "no_drop_" + std::to_string(i));
+  }
+  BOOST_CHECK(!queue.pop(&val));
+  // the slots pruned are free again
+  for (int i = 0; i < 8; ++i)
+    BOOST_CHECK(queue.push(test_event("x")));
+}
+
+BOOST_AUTO_TEST_CASE(queue_concurrent_producers)
+{
+  const int producers = 8;
+  const int per_producer = 20000;
+  event_queue<test_event> queue(256);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p)
+    threads.emplace_back([&queue, p]() {
+      for (int i = 0; i < per_producer; ++i) {
+        test_event evt(std::to_string(p) + ":" + std::to_string(i));
+        while (!queue.push(evt))
+          std::this_thread::yield();
+      }
+    });
+
+  // every event arrives once, and those of a producer in the order it pushed them
+  std::vector<int> next(producers, 0);
+  test_event item;
+  for (int received = 0; received < producers * per_producer;) {
+    if (!queue.pop(&item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    const std::string id = item.str();
+    const size_t colon = id.find(':');
+    const int p = std::stoi(id.substr(0, colon));
+    BOOST_REQUIRE_EQUAL(std::stoi(id.substr(colon + 1)), next[p]);
+    ++next[p];
+    ++received;
+  }
+  for (auto& t : threads)
+    t.join();
+  BOOST_CHECK_EQUAL(queue.size(), 0);
+}
@@ -7,6 +7,8 @@
 #include <boost/test/unit_test.hpp>
 #include "ranking_response.h"
 #include "utility/data_buffer.h"
+#include "err_constants.h"
+#include "api_status.h"
 
 using namespace reinforcement_learning;
 using namespace std;
@@ -96,3 +98,91 @@ BOOST_AUTO_TEST_CASE(interaction_message_survive_test) {
 
   BOOST_CHECK_EQUAL(buffer.str(), expected_buffer.str());
 }
+
+//the decoded binary batch reads as the json the same events are sent as
+BOOST_AUTO_TEST_CASE(binary_batch_to_json) {
+  ranking_response resp("event_id");
+  resp.push_back(1, 0.8f);
+  resp.push_back(0, 0.2f);
+  resp.set_model_id("model_id");
+  const auto context = "{\"shared\":\"line\nbreak\"}";
+
+  utility::data_buffer json_oss(utility::translate_func('\n', ' '));
+  utility::data_buffer binary_oss(utility::translate_func('\n', ' '));
+  ranking_event json_ranking(json_oss, "event_id", context, resp, 0.5f);
+  json_oss.reset();
+  ranking_event binary_ranking(binary_oss, "event_id", context, resp, 0.5f, event_encoding::binary);
+  binary_oss.reset();
+  outcome_event json_number(json_oss, "event_id", 1.5f);
+  json_oss.reset();
+  outcome_event binary_number(binary_oss, "event_id", 1.5f, 1, event_encoding::binary);
+  binary_oss.reset();
+  outcome_event json_string(json_oss, "event_id", R"({"clicked":true})");
+  outcome_event binary_string(binary_oss, "event_id", R"({"clicked":true})", 1, event_encoding::binary);
+
+  utility::data_buffer json_batch;
+  json_ranking.serialize(json_batch);
+  json_batch << "\n";
+  json_number.serialize(json_batch);
+  json_batch << "\n";
+  json_string.serialize(json_batch);
+
+  utility::data_buffer binary_batch;
+  binary_event::write_batch_header(binary_batch);
+  binary_ranking.serialize(binary_batch);
+  binary_number.serialize(binary_batch);
+  binary_string.serialize(binary_batch);
+
+  const auto binary = binary_batch.str();
+  std::string decoded;
+  BOOST_REQUIRE_EQUAL(binary_event::to_json(binary.data(), binary.size(), decoded), error_code::success);
+  BOOST_CHECK_EQUAL(decoded, json_batch.str());
+  BOOST_CHECK_LT(binary.size(), json_batch.size());
+}
+
+BOOST_AUTO_TEST_CASE(binary_event_survive_test) {
+  ranking_response resp("interaction_id");
+  resp.push_back(1, 0.1f);
+  resp.push_back(2, 0.2f);
+  resp.set_model_id("model_id");
+
+  utility::data_buffer oss;
+  ranking_event evt(oss, "interaction_id", "{}", resp, 1, event_encoding::binary);
+  evt.try_drop(0.5, 1);
+  evt.try_drop(0.5, 1);
+
+  utility::data_buffer batch;
+  binary_event::write_batch_header(batch);
+  evt.serialize(batch);
+  const auto binary = batch.str();
+  std::string decoded;
+  BOOST_REQUIRE_EQUAL(binary_event::to_json(binary.data(), binary.size(), decoded), error_code::success);
+  BOOST_CHECK_EQUAL(decoded, R"({"Version":"1","EventId":"interaction_id","a":[2,3],"c":{},"p":[0.100000,0.200000],"VWState":{"m":"model_id"},"pdrop":0.750000})");
+}
+
+BOOST_AUTO_TEST_CASE(binary_batch_malformed) {
+  utility::data_buffer oss;
+  outcome_event evt(oss, "event_id", 1.0f, 1, event_encoding::binary);
+  utility::data_buffer batch;
+  binary_event::write_batch_header(batch);
+  evt.serialize(batch);
+  const auto binary = batch.str();
+
+  std::string decoded;
+  api_status status;
+  //cut in the middle of the record
+  BOOST_CHECK_EQUAL(binary_event::to_json(binary.data(), binary.size() - 2, decoded, &status), error_code::invalid_event_batch);
+  BOOST_CHECK_EQUAL(status.get_error_code(), error_code::invalid_event_batch);
+  //no header
+  BOOST_CHECK_EQUAL(binary_event::to_json(binary.data() + 1, binary.size() - 1, decoded), error_code::invalid_event_batch);
+  //a record of an unknown kind is skipped
+  utility::data_buffer future;
+  binary_event::write_batch_header(future);
+  binary_event::write(future, static_cast<uint32_t>(2));
+  binary_event::write(future, static_cast<uint8_t>(42));
+  binary_event::write(future, static_cast<uint8_t>(0));
+  evt.serialize(future);
+  const auto with_unknown = future.str();
+  BOOST_REQUIRE_EQUAL(binary_event::to_json(with_unknown.data(), with_unknown.size(), decoded), error_code::success);
+  BOOST_CHECK_EQUAL(decoded, R"({"EventId":"event_id","v":1.000000})");
+}
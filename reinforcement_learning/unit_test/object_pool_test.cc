@@ -93,3 +93,64 @@ BOOST_AUTO_TEST_CASE(object_pool_update_factory)
   pooled_object_guard<my_object, my_object_factory> guard2(pool, pool.get_or_create());
   BOOST_CHECK_EQUAL(guard2->_id, 0); // _id is 0 as this is created from the new factory
 }
+
+BOOST_AUTO_TEST_CASE(object_pool_update_factory_prewarms)
+{
+  object_pool<my_object, my_object_factory> pool(new my_object_factory);
+  {
+    pooled_object_guard<my_object, my_object_factory> guard1(pool, pool.get_or_create());
+    pooled_object_guard<my_object, my_object_factory> guard2(pool, pool.get_or_create());
+  }
+
+  // the new factory makes as many objects as the old one had, before any request asks for one
+  auto factory = new my_object_factory;
+  pool.update_factory(factory);
+  BOOST_CHECK_EQUAL(factory->_count, 2);
+
+  auto stats = pool.stats();
+  BOOST_CHECK_EQUAL(stats.version, 1);
+  BOOST_CHECK_EQUAL(stats.pooled, 2);
+  BOOST_CHECK_EQUAL(stats.objects, 2);
+  BOOST_CHECK_GE(stats.warm_ms, 0);
+  BOOST_CHECK_GE(stats.swap_us, 0);
+
+  {
+    pooled_object_guard<my_object, my_object_factory> guard1(pool, pool.get_or_create());
+    pooled_object_guard<my_object, my_object_factory> guard2(pool, pool.get_or_create());
+    BOOST_CHECK_EQUAL(guard1->_id + guard2->_id, 1);
+  }
+  BOOST_CHECK_EQUAL(factory->_count, 2);
+}
+
+BOOST_AUTO_TEST_CASE(object_pool_update_factory_in_use)
+{
+  object_pool<my_object, my_object_factory> pool(new my_object_factory);
+  pooled_object_guard<my_object, my_object_factory> old_guard(pool, pool.get_or_create());
+
+  pool.update_factory(new my_object_factory);
+  BOOST_CHECK_EQUAL(pool.stats().pooled, 1);
+  {
+    // an object of the old factory is not pooled again
+    pooled_object_guard<my_object, my_object_factory> guard(pool, pool.get_or_create());
+    BOOST_CHECK_EQUAL(pool.stats().pooled, 0);
+  }
+  BOOST_CHECK_EQUAL(pool.stats().pooled, 1);
+}
+
+class failing_factory
+{
+public:
+  my_object* operator()()
+  {
+    throw std::runtime_error("no model");
+  }
+};
+
+BOOST_AUTO_TEST_CASE(object_pool_update_factory_failure)
+{
+  object_pool<my_object, failing_factory> pool(new failing_factory);
+
+  // a factory that cannot make objects is not swapped in
+  BOOST_CHECK_THROW(pool.update_factory(new failing_factory), std::runtime_error);
+  BOOST_CHECK_EQUAL(pool.stats().version, 0);
+}
@@ -110,3 +110,108 @@ BOOST_AUTO_TEST_CASE(factory_with_empty_model) {
     BOOST_CHECK_EQUAL_COLLECTIONS(ranking.begin(), ranking.end(), ranking_expected.begin(), ranking_expected.end());
   }
 }
+
+BOOST_AUTO_TEST_CASE(factory_objects_share_master) {
+  const auto json = R"({"a":{"0":1,"5":2},"_multi":[{"b":{"0":1}},{"b":{"0":2}},{"b":{"0":3}}]})";
+  std::vector<float> ranking_expected = { .8f, .1f, .1f };
+
+  const auto model_data = get_model_data_from_raw(cb_data_5_model, cb_data_5_model_len);
+  safe_vw loaded((const char*)cb_data_5_model, cb_data_5_model_len);
+  object_pool<safe_vw, safe_vw_factory> pool(new safe_vw_factory(model_data));
+
+  // two objects out of the pool at once, both seeded from the one loaded model
+  pooled_vw first(pool, pool.get_or_create());
+  pooled_vw second(pool, pool.get_or_create());
+  BOOST_CHECK_NE(first.get(), second.get());
+
+  for (auto vw : { first.get(), second.get() }) {
+    std::vector<int> actions;
+    std::vector<float> ranking;
+    vw->rank(json, actions, ranking);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(ranking.begin(), ranking.end(), ranking_expected.begin(), ranking_expected.end());
+    BOOST_CHECK_EQUAL(vw->id(), loaded.id());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(factory_with_bad_model) {
+  // a bad model fails when the factory is made, not on the first ranking
+  model_management::model_data bad_data;
+  std::memcpy(bad_data.alloc(4), "junk", 4);
+
+  BOOST_CHECK_THROW(safe_vw_factory factory(bad_data), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(context_cache_split) {
+  std::string shared;
+  const char* begin;
+  const char* end;
+
+  const auto context = R"({"a":{"0":1,"s":"x,}"}, "_multi" : [{"b":{"0":1}},{"b":{"0":2}}], "c":[1,2]})";
+  BOOST_CHECK(context_cache::split(context, shared, begin, end));
+  BOOST_CHECK_EQUAL(shared, R"({"a":{"0":1,"s":"x,}"}, , "c":[1,2]})");
+  BOOST_CHECK_EQUAL(std::string(begin, end), R"([{"b":{"0":1}},{"b":{"0":2}}])");
+
+  // no actions, keys that may set more than shared features, broken json
+  BOOST_CHECK(!context_cache::split(R"({"a":{"0":1}})", shared, begin, end));
+  BOOST_CHECK(!context_cache::split(R"({"_tag":"t","_multi":[{"b":{"0":1}}]})", shared, begin, end));
+  BOOST_CHECK(!context_cache::split(R"({"a":{"0":1},"_multi":[{"b":{"0":1}})", shared, begin, end));
+}
+
+BOOST_AUTO_TEST_CASE(rank_with_context_cache) {
+  const auto model_data = get_model_data_from_raw(cb_data_5_model, cb_data_5_model_len);
+  safe_vw_factory plain_factory(model_data);
+  safe_vw_factory cached_factory(model_data, 2);
+  std::unique_ptr<safe_vw> plain(plain_factory());
+  std::unique_ptr<safe_vw> cached(cached_factory());
+
+  const char* contexts[] = {
+    R"({"a":{"0":1,"5":2},"_multi":[{"b":{"0":1}},{"b":{"0":2}},{"b":{"0":3}}]})",
+    R"({"a":{"0":1,"5":2},"_multi":[{"b":{"0":3}},{"b":{"0":1}}]})",
+    R"({"a":{"0":2,"5":1},"_multi":[{"b":{"0":1}},{"b":{"0":2}},{"b":{"0":3}}]})",
+    R"({"a":{"0":1,"5":2},"_multi":[{"b":{"0":2}},{"b":{"0":3}},{"b":{"0":1}}]})",
+  };
+
+  // the cached shared example ranks as the parsed one
+  for (int pass = 0; pass < 2; ++pass) {
+    for (auto context : contexts) {
+      std::vector<int> actions, actions_expected;
+      std::vector<float> ranking, ranking_expected;
+      plain->rank(context, actions_expected, ranking_expected);
+      cached->rank(context, actions, ranking);
+
+      BOOST_CHECK_EQUAL_COLLECTIONS(actions.begin(), actions.end(), actions_expected.begin(), actions_expected.end());
+      BOOST_CHECK_EQUAL_COLLECTIONS(ranking.begin(), ranking.end(), ranking_expected.begin(), ranking_expected.end());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(context_cache_lru) {
+  example& ex = *VW::alloc_examples(0, 1);
+  context_cache cache(2);
+  ex.indices.push_back('a');
+  ex.feature_space['a'].push_back(1.f, 42);
+
+  cache.put("one", ex);
+  cache.put("two", ex);
+  BOOST_CHECK(cache.find("one") != nullptr);
+  // "two" is the least recently used
+  cache.put("three", ex);
+  BOOST_CHECK(cache.find("two") == nullptr);
+  BOOST_REQUIRE(cache.find("one") != nullptr);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL(cache.hits(), 2);
+  BOOST_CHECK_EQUAL(cache.misses(), 1);
+
+  example& copy = *VW::alloc_examples(0, 1);
+  cache.find("three")->copy_to(copy);
+  BOOST_CHECK_EQUAL(copy.indices.size(), 1);
+  BOOST_CHECK_EQUAL(copy.feature_space['a'].indicies.size(), 1);
+  if (copy.feature_space['a'].indicies.size() == 1)
+    BOOST_CHECK_EQUAL(copy.feature_space['a'].indicies[0], 42);
+
+  for (example* e : { &ex, &copy }) {
+    VW::dealloc_example(nullptr, *e);
+    free(e);
+  }
+}
@@ -11,8 +11,11 @@ MODEL=$NAME.model
 TRAINSET=$NAME.train
 PREDREF=$NAME.predref
 PREDOUT=$NAME.predict
+SENDSET=$NAME.send
 NETCAT_STATUS=$NAME.netcat-status
 PORT=54248
+Serve="--num_children 1"
+Learn="-t"
 
 while [ $# -gt 0 ]
 do
@@ -20,6 +23,14 @@ do
         --foreground)
             Foreground="$1"
             ;;
+        --threads)
+            Serve="--daemon_threads 2"
+            ;;
+        --snapshot)
+            # learn from the labeled requests, predict the others on the weights published last
+            Serve="--daemon_threads 2 --snapshot_interval 1"
+            Learn=""
+            ;;
         *)
             echo "$NAME: unknown argument $1"
             exit 1
@@ -61,7 +72,7 @@ fi
 
 
 # A command (+pattern) that is unlikely to match anything but our own test
-DaemonCmd="$VW -t -i $MODEL --daemon $Foreground --num_children 1 --quiet --port $PORT"
+DaemonCmd="$VW $Learn -i $MODEL --daemon $Foreground $Serve --quiet --port $PORT"
 # libtool may wrap vw with '.libs/lt-vw' so we need to be flexible
 # on the exact process pattern we try to kill.
 DaemonPat=`echo $DaemonCmd | sed 's/^[^ ]*vw /.*vw /'`
@@ -93,7 +104,7 @@ start_daemon() {
 }
 
 cleanup() {
-    /bin/rm -f $MODEL $TRAINSET $PREDREF $PREDOUT $NETCAT_STATUS
+    /bin/rm -f $MODEL $TRAINSET $SENDSET $PREDREF $PREDOUT $NETCAT_STATUS
     stop_daemon
 }
 
@@ -115,6 +126,20 @@ EOF
 # Train
 $VW -b 10 --quiet -d $TRAINSET -f $MODEL
 
+if [ -z "$Learn" ]; then
+    # With an interval of 1, each labeled request is published before the next one is answered, so
+    # the daemon predicts what learning from the same requests in a row does.
+    cat > $SENDSET <<EOF
+2 1 '1| a
+'2| a
+-1 1 '3| b c
+'4| b c
+EOF
+    $VW --quiet -i $MODEL -d $SENDSET -p $PREDREF
+else
+    cp $TRAINSET $SENDSET
+fi
+
 DaemonPid=`start_daemon`
 
 # Test --foreground argument
@@ -146,9 +171,9 @@ fi
 #wait
 # However, GNU netcat does not know -q, so let's do a work-around
 touch $PREDOUT
-( $NETCAT localhost $PORT < $TRAINSET > $PREDOUT; STATUS=$?; echo $STATUS > $NETCAT_STATUS ) &
+( $NETCAT localhost $PORT < $SENDSET > $PREDOUT; STATUS=$?; echo $STATUS > $NETCAT_STATUS ) &
 # Wait until we recieve a prediction from the vw daemon then kill netcat
-until [ `wc -l < $PREDOUT` -eq 2 ]; do
+until [ `wc -l < $PREDOUT` -eq `wc -l < $SENDSET` ]; do
     if [ -f $NETCAT_STATUS ]; then
         STATUS=`cat $NETCAT_STATUS`
         if [ $STATUS -ne 0 ]; then
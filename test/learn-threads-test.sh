@@ -0,0 +1,68 @@
+#!/bin/bash
+# -- --learn_threads (Hogwild) test
+#
+# Usage: learn-threads-test.sh <vw> <vw arguments including --learn_threads N>
+#
+# The order of the updates differs from run to run, so there is no reference output
+# to compare with: the run is repeated on one thread (the same arguments without
+# --learn_threads), and the average loss of the threaded run must be within
+# $Bound of it, over the same number of examples.
+#
+NAME='learn-threads-test'
+Bound=0.02 # relative
+
+die() {
+    echo "$NAME: $@" 1>&2
+    exit 1
+}
+
+case "$#" in
+    (0|1) die "Usage: $0 <vw_executable> <vw arguments>"
+        ;;
+esac
+VW="$1"
+shift
+
+Threaded=("$@")
+Single=()
+while [ $# -gt 0 ]
+do
+    case "$1" in
+        --learn_threads)
+            Threads="$2"
+            shift
+            ;;
+        *)
+            Single+=("$1")
+            ;;
+    esac
+    shift
+done
+[ -n "$Threads" ] || die "no --learn_threads among the arguments"
+
+# prints the value of the summary line starting with $1
+summary() {
+    sed -n "s/^$1[^=]*= *\([^ ]*\).*/\1/p"
+}
+
+One=`"$VW" "${Single[@]}" 2>&1` || die "one thread: $VW ${Single[*]} failed"
+Many=`"$VW" "${Threaded[@]}" 2>&1` || die "$Threads threads: $VW ${Threaded[*]} failed"
+
+case "$Many" in
+    (*"ignoring --learn_threads"*)
+        die "$Threads threads fell back to one: $Many"
+        ;;
+esac
+
+OneExamples=`echo "$One" | summary 'number of examples'`
+ManyExamples=`echo "$Many" | summary 'number of examples'`
+[ -n "$OneExamples" -a "$OneExamples" = "$ManyExamples" ] || \
+    die "$ManyExamples examples on $Threads threads, $OneExamples on one"
+
+OneLoss=`echo "$One" | summary 'average loss'`
+ManyLoss=`echo "$Many" | summary 'average loss'`
+awk -v one="$OneLoss" -v many="$ManyLoss" -v bound="$Bound" \
+    'BEGIN { d = many - one; if (d < 0) d = -d; exit !(one != "" && many != "" && d <= bound * one) }' || \
+    die "average loss $ManyLoss on $Threads threads, $OneLoss on one: more than $Bound apart"
+
+echo "average loss on $Threads threads within $Bound of the one on one thread"
@@ -0,0 +1,71 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <vector>
+
+#include "allreduce_compress.h"
+
+using namespace allreduce_compress;
+
+std::vector<float> changes()
+{
+  std::vector<float> v(1000, 0.f);
+  v[0] = 0.5f;
+  v[3] = -1.25f;
+  v[200] = 3e-3f;
+  v[999] = 7.f;
+  v[500] = 1e-9f;
+  return v;
+}
+
+BOOST_AUTO_TEST_CASE(allreduce_compress_sparse_exact)
+{
+  std::vector<float> v = changes();
+  std::vector<float> expected = v;
+  std::vector<char> message;
+  encode(SyncEncoding::sparse, v.data(), v.size(), message);
+
+  for (float residual : v)
+    BOOST_CHECK_EQUAL(residual, 0.f);
+  std::vector<float> sum(v.size(), 0.f);
+  decode_add(message, sum.data(), sum.size());
+  BOOST_CHECK_EQUAL_COLLECTIONS(sum.begin(), sum.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(allreduce_compress_quantized_residual)
+{
+  for (SyncEncoding encoding : { SyncEncoding::fp16, SyncEncoding::int8 })
+  {
+    std::vector<float> v = changes();
+    std::vector<float> expected = v;
+    std::vector<char> message;
+    encode(encoding, v.data(), v.size(), message);
+
+    // what was sent and what was kept add back up to the original, exactly
+    std::vector<float> sum(v.size(), 0.f);
+    decode_add(message, sum.data(), sum.size());
+    for (size_t i = 0; i < v.size(); i++)
+      BOOST_CHECK_EQUAL(sum[i] + v[i], expected[i]);
+    BOOST_CHECK_CLOSE(sum[999], 7.f, 0.1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(allreduce_compress_half)
+{
+  BOOST_CHECK_EQUAL(to_half(1.f), 0x3c00);
+  BOOST_CHECK_EQUAL(to_half(-2.f), 0xc000);
+  BOOST_CHECK_EQUAL(to_half(65504.f), 0x7bff);
+  BOOST_CHECK_EQUAL(to_half(1e10f), 0x7bff);
+  BOOST_CHECK_EQUAL(to_half(1.f + 1.f / 2048), 0x3c00); // a tie, to even
+  BOOST_CHECK_EQUAL(from_half(0x0001), 5.9604645e-8f);
+  for (uint16_t h = 0; h < 0x7c00; h++)
+    BOOST_CHECK_EQUAL(to_half(from_half(h)), h);
+}
+
+BOOST_AUTO_TEST_CASE(allreduce_compress_bad_name)
+{
+  BOOST_CHECK(parse_sync_encoding("int8") == SyncEncoding::int8);
+  BOOST_CHECK_THROW(parse_sync_encoding("zip"), std::exception);
+}
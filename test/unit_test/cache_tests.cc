@@ -0,0 +1,123 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "vw.h"
+#include "cache.h"
+#include "learner.h"
+
+// Lines whose indices are 1, 2, 4 and 8 bytes apart, sorted and not, with and without values.
+static std::vector<std::string> cache_test_lines()
+{
+  std::vector<std::string> lines;
+  uint64_t state = 12345;
+  for (size_t n = 0; n < 200; n++)
+  {
+    std::ostringstream line;
+    line << (n % 3 == 0 ? "1" : "0") << " |a";
+    for (size_t f = 0; f < n % 13; f++)
+    {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      line << " " << (state >> 33) % (1 << (4 + 7 * (f % 4)));
+      if (f % 5 == 4)
+        line << ":" << (float)((state >> 40) % 100) / 10.f;
+    }
+    line << " |b x" << n % 7 << " y:0.5";
+    lines.push_back(line.str());
+  }
+  return lines;
+}
+
+static std::string slurp(const std::string& name)
+{
+  std::ifstream file(name, std::ios::binary);
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+// the byte of a cache file's header naming its format
+static char cache_format(const std::string& name)
+{
+  return slurp(name).at(sizeof(size_t) + version.to_string().length() + 1);
+}
+
+// a cache in the varint format, which only a daemon's clients still write
+static void write_varint_cache(const std::string& name, const std::vector<std::string>& lines)
+{
+  vw& all = *VW::initialize("--quiet --noconstant -b 20");
+  io_buf cache;
+  int f = cache.open_file(name.c_str(), all.stdin_off, io_buf::WRITE);
+  BOOST_REQUIRE(f != -1);
+  std::string v = version.to_string();
+  size_t v_length = v.length() + 1;
+  uint32_t numbits = (uint32_t)all.num_bits;
+  cache.write_file(f, &v_length, sizeof(v_length));
+  cache.write_file(f, v.c_str(), v_length);
+  cache.write_file(f, &cache_varint_format, 1);
+  cache.write_file(f, &numbits, sizeof(numbits));
+  for (const std::string& line : lines)
+  {
+    example* ec = VW::read_example(all, line.c_str());
+    all.p->lp.cache_label(&ec->l, cache);
+    cache_features(cache, ec, all.parse_mask);
+    VW::finish_example(all, *ec);
+  }
+  cache.flush();
+  cache.close_file();
+  VW::finish(all);
+}
+
+struct cache_run
+{
+  std::vector<float> weights;
+  std::string predictions;
+};
+
+static cache_run learn_from_cache(const std::string& cache, const std::string& options)
+{
+  std::string predictions = cache + ".predict";
+  vw& all = *VW::initialize("--quiet --noconstant -b 20 --passes 2 --holdout_off -p " + predictions + " --cache_file " + cache + " " + options);
+  VW::start_parser(all);
+  LEARNER::generic_driver(all);
+  VW::end_parser(all);
+  cache_run run;
+  for (float& w : all.weights.dense_weights)
+    run.weights.push_back(w);
+  VW::finish(all);
+  run.predictions = slurp(predictions);
+  remove(predictions.c_str());
+  return run;
+}
+
+// learning from a varint cache converted to columns gives the weights and predictions learning
+// from the varint cache does, with every delta decoder
+BOOST_AUTO_TEST_CASE(cache_converted_to_columns)
+{
+  std::string varint = "cache_tests.varint.cache";
+  write_varint_cache(varint, cache_test_lines());
+  cache_run expected = learn_from_cache(varint, "");
+  BOOST_CHECK_EQUAL(cache_format(varint), cache_varint_format); // read as it is
+  BOOST_REQUIRE(!expected.predictions.empty());
+
+  delta_decoder dispatched = decode_deltas;
+  for (const named_decoder& decoder : delta_decoders())
+  {
+    std::string columns = "cache_tests.columns.cache";
+    { std::ofstream(columns, std::ios::binary) << slurp(varint); }
+    decode_deltas = decoder.decode;
+    cache_run converted = learn_from_cache(columns, "--convert_cache");
+    BOOST_CHECK_MESSAGE(converted.weights == expected.weights, decoder.name << " weights");
+    BOOST_CHECK_MESSAGE(converted.predictions == expected.predictions, decoder.name << " predictions");
+    BOOST_CHECK_EQUAL(cache_format(columns), cache_columns_format);
+    remove(columns.c_str());
+  }
+  decode_deltas = dispatched;
+  remove(varint.c_str());
+}
@@ -0,0 +1,107 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <float.h>
+#include <math.h>
+
+#include "gd_simd.h"
+#include "array_parameters.h"
+
+const uint32_t gd_simd_stride_shift = 2;
+const size_t gd_simd_weights = 1 << 10;
+
+static uint64_t gd_simd_state = 1;
+
+static uint64_t gd_simd_next()
+{
+  gd_simd_state = gd_simd_state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return gd_simd_state >> 33;
+}
+
+// in [-1, 1), zero one time in eight
+static float gd_simd_value()
+{
+  uint64_t r = gd_simd_next();
+  return r % 8 == 0 ? 0.f : (float)(r % 2000) / 1000.f - 1.f;
+}
+
+static void fill(dense_parameters& weights)
+{
+  for (size_t i = 0; i <= weights.mask(); i++)
+    weights[i] = gd_simd_value();
+}
+
+// n features, offset by less than the stride; with few weights to pick from, some repeat
+static void fill(features& fs, size_t n, size_t weights_used)
+{
+  fs.clear();
+  for (size_t i = 0; i < n; i++)
+    fs.push_back(gd_simd_value(), (gd_simd_next() % weights_used) << gd_simd_stride_shift);
+}
+
+// lengths around every vector width
+static const size_t gd_simd_lengths[] = { 0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 33, 100 };
+
+BOOST_AUTO_TEST_CASE(gd_simd_dot_kernels_agree)
+{
+  std::vector<GD::named_dot_kernel> kernels = GD::dot_kernels();
+  BOOST_REQUIRE(!kernels.empty());
+  dense_parameters weights(gd_simd_weights, gd_simd_stride_shift);
+  fill(weights);
+  features fs;
+  for (size_t n : gd_simd_lengths)
+    for (size_t round = 0; round < 20; round++)
+    {
+      fill(fs, n, gd_simd_weights);
+      uint64_t offset = round % 4;
+      float p0 = gd_simd_value() * 10.f;
+      float magnitude = fabsf(p0);
+      for (size_t i = 0; i < n; i++)
+        magnitude += fabsf(weights[fs.indicies[i] + offset] * fs.values[i]);
+      float tolerance = 2 * n * FLT_EPSILON * magnitude;
+
+      float expected = p0;
+      kernels[0].dot(weights, fs, offset, expected);
+      for (const GD::named_dot_kernel& kernel : kernels)
+      {
+        float p = p0;
+        kernel.dot(weights, fs, offset, p);
+        BOOST_CHECK_MESSAGE(fabsf(p - expected) <= tolerance,
+                            kernel.name << " over " << n << " features: " << p << " instead of " << expected);
+      }
+    }
+  fs.delete_v();
+}
+
+BOOST_AUTO_TEST_CASE(gd_simd_update_kernels_agree)
+{
+  std::vector<GD::named_update_kernel> kernels = GD::update_kernels();
+  BOOST_REQUIRE(!kernels.empty());
+  dense_parameters initial(gd_simd_weights, gd_simd_stride_shift);
+  dense_parameters expected(gd_simd_weights, gd_simd_stride_shift);
+  dense_parameters updated(gd_simd_weights, gd_simd_stride_shift);
+  fill(initial);
+  features fs;
+  for (size_t n : gd_simd_lengths)
+    for (size_t weights_used : { gd_simd_weights, (size_t)12 })
+      for (size_t spare : { 0, 1 })
+        for (bool feature_mask_off : { true, false })
+        {
+          fill(fs, n, weights_used);
+          uint64_t offset = n % 2;
+          float update = gd_simd_value();
+          memcpy(expected.first(), initial.first(), (expected.mask() + 1) * sizeof(float));
+          kernels[0].update(expected, fs, offset, update, spare, feature_mask_off);
+          for (const GD::named_update_kernel& kernel : kernels)
+          {
+            memcpy(updated.first(), initial.first(), (updated.mask() + 1) * sizeof(float));
+            kernel.update(updated, fs, offset, update, spare, feature_mask_off);
+            BOOST_CHECK_MESSAGE(memcmp(updated.first(), expected.first(), (updated.mask() + 1) * sizeof(float)) == 0,
+                                kernel.name << " over " << n << " features of " << weights_used << " weights, spare " << spare
+                                << (feature_mask_off ? "" : ", feature mask on"));
+          }
+        }
+  fs.delete_v();
+}
@@ -0,0 +1,36 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include "huge_pages.h"
+#include "array_parameters.h"
+
+// more than any address space: every backing fails and the request falls all the way back
+BOOST_AUTO_TEST_CASE(huge_pages_fallback_maps_nothing)
+{
+  for (weight_pages requested : { huge_pages_1g, huge_pages_2m, transparent_pages })
+  {
+    weight_pages pages = requested;
+    size_t mapped = 12345;
+    void* data = map_weights((size_t)1 << 62, pages, mapped);
+    BOOST_CHECK(data == nullptr);
+    BOOST_CHECK_EQUAL(pages, small_pages);
+    BOOST_CHECK_EQUAL(mapped, (size_t)0);
+  }
+}
+
+// whichever backing the host grants, the weights are zeroed, writable and released
+BOOST_AUTO_TEST_CASE(huge_pages_dense_weights)
+{
+  for (weight_pages requested : { huge_pages_1g, huge_pages_2m, transparent_pages, small_pages })
+  {
+    dense_parameters weights(1 << 10, 2, requested);
+    BOOST_CHECK(weights.pages() <= requested);
+    for (uint64_t i = 0; i < (1 << 12); i++)
+    {
+      BOOST_CHECK_EQUAL(weights[i], 0.f);
+      weights[i] = 1.f;
+    }
+  }
+}
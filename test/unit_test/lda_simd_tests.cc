@@ -0,0 +1,151 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "lda_simd.h"
+
+/* Every kernel against the scalar approximations over random topics and topic counts that are no
+** multiple of any vector width.  The vector digamma is a different rational approximation than the
+** scalar one, a few 1e-5 apart, and the sums add up in a different order, so the results agree
+** within a relative lda_simd_tolerance rather than bit for bit.
+*/
+const float lda_simd_tolerance = 1e-4f;
+const float lda_simd_threshold = 1e-10f;
+
+static uint64_t lda_simd_state = 7;
+
+// in [low, high)
+static float lda_simd_uniform(float low, float high)
+{
+  lda_simd_state = lda_simd_state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return low + (high - low) * (float)(lda_simd_state >> 40) / (float)(1 << 24);
+}
+
+static std::vector<float> lda_simd_random(size_t n, float low, float high)
+{
+  std::vector<float> v(n);
+  for (float& x : v)
+    x = lda_simd_uniform(low, high);
+  return v;
+}
+
+static const size_t lda_simd_topics[] = { 1, 3, 5, 7, 9, 13, 15, 17, 23, 31, 33, 47, 100 };
+
+static bool agree(float actual, float expected)
+{
+  return fabsf(actual - expected) <= lda_simd_tolerance * std::max(fabsf(expected), 1.f);
+}
+
+static void check_close(const std::vector<float>& actual, const std::vector<float>& expected, const std::string& what)
+{
+  for (size_t k = 0; k < expected.size(); k++)
+    BOOST_CHECK_MESSAGE(agree(actual[k], expected[k]),
+                        what << " over " << expected.size() << " topics, topic " << k << ": " << actual[k] << " instead of " << expected[k]);
+}
+
+static std::vector<float> expdigammify_scalar(std::vector<float> gamma)
+{
+  float sum = 0.f;
+  for (float g : gamma)
+    sum += g;
+  float norm = ldamath::fastdigamma(sum);
+  for (float& g : gamma)
+    g = std::max(lda_simd_threshold, ldamath::fastexp(ldamath::fastdigamma(g) - norm));
+  return gamma;
+}
+
+static std::vector<float> expdigammify_2_scalar(std::vector<float> gamma, const std::vector<float>& norm)
+{
+  for (size_t k = 0; k < gamma.size(); k++)
+    gamma[k] = std::max(lda_simd_threshold, ldamath::fastexp(ldamath::fastdigamma(gamma[k]) - norm[k]));
+  return gamma;
+}
+
+static float dot_scalar(const std::vector<float>& u, const std::vector<float>& v)
+{
+  float sum = 0.f;
+  for (size_t k = 0; k < u.size(); k++)
+    sum += u[k] * v[k];
+  return sum;
+}
+
+BOOST_AUTO_TEST_CASE(lda_simd_expdigammify)
+{
+  std::vector<const ldamath::lda_kernels*> kernels = ldamath::all_wide_lda_kernels();
+  for (size_t topics : lda_simd_topics)
+    for (size_t round = 0; round < 10; round++)
+    {
+      std::vector<float> gamma = lda_simd_random(topics, 0.1f, 20.f);
+      std::vector<float> norm = lda_simd_random(topics, 0.f, 5.f);
+      std::vector<float> expected = expdigammify_scalar(gamma);
+      std::vector<float> expected_2 = expdigammify_2_scalar(gamma, norm);
+      for (const ldamath::lda_kernels* kernel : kernels)
+      {
+        std::vector<float> actual = gamma;
+        kernel->expdigammify(actual.data(), topics, lda_simd_threshold);
+        check_close(actual, expected, std::string(kernel->name) + " expdigammify");
+        actual = gamma;
+        kernel->expdigammify_2(actual.data(), norm.data(), topics, lda_simd_threshold);
+        check_close(actual, expected_2, std::string(kernel->name) + " expdigammify_2");
+      }
+#if defined(__SSE2__) && !defined(VW_NO_INLINE_SIMD)
+      // starting off the 16 byte alignment, so that the SSE2 code runs its scalar part first
+      for (size_t skip = 0; skip < 4; skip++)
+      {
+        std::vector<float> actual(topics + 8);
+        float* start = (float*)((((uintptr_t)actual.data() + 15) & ~(uintptr_t)15) + 4 * skip);
+        std::copy(gamma.begin(), gamma.end(), start);
+        ldamath::vexpdigammify(start, topics, lda_simd_threshold);
+        check_close(std::vector<float>(start, start + topics), expected, "sse2 expdigammify");
+        std::copy(gamma.begin(), gamma.end(), start);
+        ldamath::vexpdigammify_2(start, norm.data(), topics, lda_simd_threshold);
+        check_close(std::vector<float>(start, start + topics), expected_2, "sse2 expdigammify_2");
+      }
+#endif
+    }
+}
+
+BOOST_AUTO_TEST_CASE(lda_simd_word_kernels)
+{
+  for (const ldamath::lda_kernels* kernel : ldamath::all_wide_lda_kernels())
+    for (size_t topics : lda_simd_topics)
+      for (size_t round = 0; round < 10; round++)
+      {
+        std::vector<float> u = lda_simd_random(topics, 0.f, 1.f);
+        std::vector<float> v = lda_simd_random(topics, 0.f, 1.f);
+        std::vector<float> gamma = lda_simd_random(topics, 0.f, 10.f);
+        std::vector<float> w = lda_simd_random(topics, 0.f, 10.f);
+        std::vector<float> total = lda_simd_random(topics, 10.f, 100.f);
+        float x = lda_simd_uniform(0.5f, 3.f);
+        std::string name = kernel->name;
+
+        float dot = dot_scalar(u, v);
+        BOOST_CHECK_MESSAGE(agree(kernel->dot(u.data(), v.data(), topics), dot), name << " dot over " << topics << " topics");
+
+        std::vector<float> expected_gamma = gamma;
+        float c = 1.f / dot;
+        for (size_t k = 0; k < topics; k++)
+          expected_gamma[k] += c * x * u[k];
+        std::vector<float> actual_gamma = gamma;
+        float actual_c = kernel->accumulate_word(u.data(), v.data(), actual_gamma.data(), topics, x);
+        BOOST_CHECK_MESSAGE(agree(actual_c, c), name << " accumulate_word over " << topics << " topics");
+        check_close(actual_gamma, expected_gamma, name + " accumulate_word");
+
+        std::vector<float> expected_w = w, expected_total = total;
+        for (size_t k = 0; k < topics; k++)
+        {
+          float d = u[k] * v[k] * c;
+          expected_w[k] += d;
+          expected_total[k] += d;
+        }
+        kernel->update_word(w.data(), total.data(), u.data(), v.data(), topics, c);
+        check_close(w, expected_w, name + " update_word w");
+        check_close(total, expected_total, name + " update_word total");
+      }
+}
@@ -0,0 +1,108 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "parse_primitives.h"
+#include "delimiter_scan.h"
+
+float parse(std::string s)
+{
+  char* end;
+  return parseFloat(&s[0], &end, &s[0] + s.size());
+}
+
+BOOST_AUTO_TEST_CASE(parse_float_values)
+{
+  BOOST_CHECK_EQUAL(parse("0.5"), 0.5f);
+  BOOST_CHECK_EQUAL(parse("-12"), -12.f);
+  BOOST_CHECK_EQUAL(parse("1e3"), 1000.f);
+  BOOST_CHECK_EQUAL(parse("2.5e-2"), 25.f * powf(10, -3));
+  // more digits than a float holds exactly
+  BOOST_CHECK_CLOSE(parse("123456789.125"), 123456789.125f, 1e-4);
+  BOOST_CHECK_CLOSE(parse("0.00000000000000000001"), 1e-20f, 1e-3);
+  // as many digits as are gathered in an integer, and one more
+  BOOST_CHECK_EQUAL(parse("1677720.9"), 1677720.9f);
+  BOOST_CHECK_EQUAL(parse("16777217"), 16777217.f);
+  // decimals past the 35th are dropped
+  BOOST_CHECK_EQUAL(parse("0.00000000000000000000000000000000000000001"), 0.f);
+}
+
+// the names between delimiters, each followed by '/', splitting at one byte at a time
+std::string split_names(const std::string& line)
+{
+  std::string names;
+  for (char c : line)
+    names += c == ' ' || c == '\t' || c == '|' || c == ':' || c == '\r' ? '/' : c;
+  return names + "/";
+}
+
+// the same from a scanner over whichever kernel scan_block is
+std::string scan_names(std::string line)
+{
+  char* begin = &line[0];
+  char* end = begin + line.size();
+  delimiter_scan::scanner delimiters;
+  delimiters.start(begin, end);
+
+  std::string names;
+  for (char* p = begin; p <= end;)
+  {
+    char* q = delimiters.next(p);
+    names += std::string(p, q) + "/";
+    p = q + 1;
+  }
+  BOOST_CHECK(delimiters.next(end) == end);
+  return names;
+}
+
+// delimiters either side of the 16, 32 and 64 byte lanes of the kernels, and names running across them
+std::vector<std::string> block_edge_lines()
+{
+  const char delimiters[] = " \t|:\r";
+  std::vector<std::string> lines;
+  std::string line(200, 'n');
+  size_t d = 0;
+  for (size_t i : { 15, 16, 31, 32, 63, 64, 127, 128, 191 })
+    line[i] = delimiters[d++ % 5];
+  lines.push_back(line);
+  // the same shifted by one, and names alone from 15 to 65 bytes long
+  lines.push_back("x" + line);
+  for (size_t n : { 15, 16, 17, 31, 32, 33, 63, 64, 65 })
+    lines.push_back(std::string(n, 'n') + " " + std::string(n, 'm'));
+  lines.push_back("a_rather_long_feature_name_that_runs_on_past_the_end_of_the_first_64_byte_block:0.5 b\tc|d\re"
+                  + std::string(100, 'x') + " tail");
+  return lines;
+}
+
+BOOST_AUTO_TEST_CASE(delimiter_scan_kernels_agree)
+{
+  std::vector<delimiter_scan::named_kernel> kernels = delimiter_scan::kernels();
+  BOOST_REQUIRE(!kernels.empty());
+  delimiter_scan::scan_kernel scalar = kernels[0].scan;
+  for (const std::string& line : block_edge_lines())
+  {
+    const char* end = line.data() + line.size();
+    for (const delimiter_scan::named_kernel& kernel : kernels)
+      for (size_t from = 0; from < line.size(); from++)
+        for (const char* block_end : { end, line.data() + std::min(line.size(), from + 64), line.data() + from + 1 })
+          BOOST_CHECK_MESSAGE(kernel.scan(line.data() + from, block_end) == scalar(line.data() + from, block_end),
+                              kernel.name << " from " << from << " to " << block_end - line.data() << " of a " << line.size() << " byte line");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(delimiter_scan_names)
+{
+  delimiter_scan::scan_kernel dispatched = delimiter_scan::scan_block;
+  for (const delimiter_scan::named_kernel& kernel : delimiter_scan::kernels())
+  {
+    delimiter_scan::scan_block = kernel.scan;
+    for (const std::string& line : block_edge_lines())
+      BOOST_CHECK_MESSAGE(scan_names(line) == split_names(line), kernel.name << " on " << line);
+  }
+  delimiter_scan::scan_block = dispatched;
+}
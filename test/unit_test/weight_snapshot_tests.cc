@@ -0,0 +1,85 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include "weight_snapshot.h"
+#include "vw_exception.h"
+
+const uint32_t weight_snapshot_stride_shift = 2;
+const size_t weight_snapshot_weights = 1 << 8;
+
+static void fill(dense_parameters& weights, float value)
+{
+  for (size_t i = 0; i <= weights.mask(); i++)
+    weights[i] = value + i;
+}
+
+static bool holds(dense_parameters& weights, float value)
+{
+  for (size_t i = 0; i <= weights.mask(); i++)
+    if (weights[i] != value + i)
+      return false;
+  return true;
+}
+
+BOOST_AUTO_TEST_CASE(weight_snapshot_acquire_sees_the_last_publish)
+{
+  dense_parameters weights(weight_snapshot_weights, weight_snapshot_stride_shift);
+  fill(weights, 1.f);
+  weight_snapshots snapshots(weights, 3);
+  BOOST_CHECK_EQUAL(snapshots.generations(), 1);
+  BOOST_CHECK(holds(*snapshots.acquire(), 1.f));
+
+  // learning on goes unseen until it is published
+  fill(weights, 2.f);
+  BOOST_CHECK(holds(*snapshots.acquire(), 1.f));
+  BOOST_CHECK(snapshots.publish(weights));
+  BOOST_CHECK(holds(*snapshots.acquire(), 2.f));
+  BOOST_CHECK_EQUAL(snapshots.generations(), 2);
+
+  // a generation let go of is written again rather than another allocated
+  fill(weights, 3.f);
+  BOOST_CHECK(snapshots.publish(weights));
+  BOOST_CHECK(holds(*snapshots.acquire(), 3.f));
+  BOOST_CHECK_EQUAL(snapshots.generations(), 2);
+  BOOST_CHECK_EQUAL(snapshots.published(), 2);
+  BOOST_CHECK_EQUAL(snapshots.skipped(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(weight_snapshot_skips_while_every_generation_is_read)
+{
+  dense_parameters weights(weight_snapshot_weights, weight_snapshot_stride_shift);
+  fill(weights, 1.f);
+  weight_snapshots snapshots(weights, 2);
+
+  weight_snapshots::generation first = snapshots.acquire();
+  fill(weights, 2.f);
+  BOOST_CHECK(snapshots.publish(weights));
+  weight_snapshots::generation second = snapshots.acquire();
+
+  // one generation is held, the other current: nothing is free to publish into
+  fill(weights, 3.f);
+  BOOST_CHECK(!snapshots.publish(weights));
+  BOOST_CHECK_EQUAL(snapshots.skipped(), 1);
+  BOOST_CHECK_EQUAL(snapshots.generations(), 2);
+  BOOST_CHECK(holds(*first, 1.f));
+  BOOST_CHECK(holds(*second, 2.f));
+  BOOST_CHECK(holds(*snapshots.acquire(), 2.f));
+
+  // the current generation stays current while held, so letting go of it frees nothing
+  second.reset();
+  BOOST_CHECK(!snapshots.publish(weights));
+  BOOST_CHECK_EQUAL(snapshots.skipped(), 2);
+
+  first.reset();
+  BOOST_CHECK(snapshots.publish(weights));
+  BOOST_CHECK(holds(*snapshots.acquire(), 3.f));
+  BOOST_CHECK_EQUAL(snapshots.published(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(weight_snapshot_needs_two_generations)
+{
+  dense_parameters weights(weight_snapshot_weights, weight_snapshot_stride_shift);
+  BOOST_CHECK_THROW(weight_snapshots(weights, 1), VW::vw_exception);
+}
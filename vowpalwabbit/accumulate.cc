@@ -12,13 +12,34 @@ Alekh Agarwal and John Langford, with help Olivier Chapelle.
 #include <sys/timeb.h>
 #include <cmath>
 #include <stdint.h>
+#include <string.h>
 #include "global_data.h"
 #include "vw_allreduce.h"
+#include "accumulate.h"
 
 using namespace std;
 
 void add_float(float& c1, const float& c2) { c1 += c2; }
 
+bool compressed(vw& all) { return all.sync_encoding != SyncEncoding::dense && all.all_reduce_type == AllReduceType::Socket; }
+
+// Sums pending over the nodes into sum, sending only encoded messages: each node adds the messages
+// of its children into its pending and passes that up encoded.  Whatever the encoding loses, of
+// this node's values or of those its children passed, stays in pending.
+void all_reduce_encoded(vw& all, SyncEncoding encoding, float* pending, float* sum, size_t length)
+{
+  vector<char> message;
+  ((AllReduceSockets*)all.all_reduce)->all_reduce_messages(message,
+      [&](const vector<char>* children, size_t count, vector<char>& message)
+  {
+    for (size_t c = 0; c < count; c++)
+      allreduce_compress::decode_add(children[c], pending, length);
+    allreduce_compress::encode(encoding, pending, length, message);
+  });
+  memset(sum, 0, length * sizeof(float));
+  allreduce_compress::decode_add(message, sum, length);
+}
+
 void accumulate(vw& all, parameters& weights, size_t offset)
 {
   uint64_t length = UINT64_ONE << all.num_bits; //This is size of gradient
@@ -31,7 +52,15 @@ void accumulate(vw& all, parameters& weights, size_t offset)
     for (uint64_t i = 0; i < length; i++)
       local_grad[i] = (&(weights.dense_weights[i << weights.dense_weights.stride_shift()]))[offset];
 
-  all_reduce<float, add_float>(all, local_grad, length); //TODO: modify to not use first()
+  if (compressed(all))
+  { // quantized gradients would throw the line search off, so only their zeros are dropped
+    float* sum = new float[length];
+    all_reduce_encoded(all, SyncEncoding::sparse, local_grad, sum, length);
+    swap(local_grad, sum);
+    delete[] sum;
+  }
+  else
+    all_reduce<float, add_float>(all, local_grad, length); //TODO: modify to not use first()
 
   if (weights.sparse)
     for (uint64_t i = 0; i < length; i++)
@@ -56,6 +85,31 @@ void accumulate_avg(vw& all, parameters& weights, size_t offset)
   float numnodes = (float)all.all_reduce->total;
   float* local_grad = new float[length];
 
+  if (compressed(all) && all.sync != nullptr)
+  { // every node starts from the weights of the last sync, so only the changes since are sent
+    float* last = all.sync->last;
+    float* residual = all.sync->residual;
+    if (weights.sparse)
+      for (uint64_t i = 0; i < length; i++)
+        residual[i] += (&(weights.sparse_weights[i << weights.sparse_weights.stride_shift()]))[offset] - last[i];
+    else
+      for (uint64_t i = 0; i < length; i++)
+        residual[i] += (&(weights.dense_weights[i << weights.dense_weights.stride_shift()]))[offset] - last[i];
+
+    all_reduce_encoded(all, all.sync_encoding, residual, local_grad, length);
+
+    for (uint64_t i = 0; i < length; i++)
+      last[i] += local_grad[i] / numnodes;
+    if (weights.sparse)
+      for (uint64_t i = 0; i < length; i++)
+        (&(weights.sparse_weights[i << weights.sparse_weights.stride_shift()]))[offset] = last[i];
+    else
+      for (uint64_t i = 0; i < length; i++)
+        (&(weights.dense_weights[i << weights.dense_weights.stride_shift()]))[offset] = last[i];
+    delete[] local_grad;
+    return;
+  }
+
   if (weights.sparse)
     for (uint64_t i = 0; i < length; i++)
       local_grad[i] = (&(weights.sparse_weights[i << weights.sparse_weights.stride_shift()]))[offset];
@@ -72,6 +126,12 @@ void accumulate_avg(vw& all, parameters& weights, size_t offset)
     for (uint64_t i = 0; i < length; i++)
       (&(weights.dense_weights[i << weights.dense_weights.stride_shift()]))[offset] = local_grad[i] / numnodes;
 
+  if (compressed(all))
+  { // the first sync is dense, after it the nodes agree on the weights
+    all.sync = new sync_state(length);
+    for (uint64_t i = 0; i < length; i++)
+      all.sync->last[i] = local_grad[i] / numnodes;
+  }
   delete[] local_grad;
 }
 
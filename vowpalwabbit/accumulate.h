@@ -11,3 +11,19 @@ void accumulate(vw& all, parameters& weights, size_t o);
 float accumulate_scalar(vw& all, float local_sum);
 void accumulate_weighted_avg(vw& all, parameters& weights);
 void accumulate_avg(vw& all, parameters& weights, size_t o);
+
+// What compressed weight syncs (--allreduce_compression) keep between syncs: the weights as last
+// synced, the same on every node, and what quantizing this node's changes has lost so far.
+struct sync_state
+{
+  float* last;
+  float* residual;
+
+  sync_state(size_t length) : last(new float[length]), residual(new float[length]())
+  {}
+  ~sync_state()
+  {
+    delete[] last;
+    delete[] residual;
+  }
+};
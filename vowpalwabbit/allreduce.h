@@ -7,6 +7,8 @@ license as described in the file LICENSE.
 
 #pragma once
 #include <string>
+#include <vector>
+#include <functional>
 #ifdef _WIN32
 #include <WinSock2.h>
 #include <WS2tcpip.h>
@@ -261,6 +263,91 @@ private:
   void pass_down(char* buffer, const size_t parent_read_pos, size_t& children_sent_pos);
   void broadcast(char* buffer, const size_t n);
 
+  void set_nonblocking(bool on); // on Windows; elsewhere send_some and recv_some never block anyway
+  // what one call sends or receives without blocking, 0 when the socket would block
+  static size_t send_some(socket_t sock, const char* buffer, size_t length, const char* peer);
+  static size_t recv_some(socket_t sock, char* buffer, size_t length, const char* peer);
+  // whole messages, blocking: a uint64_t length and then the bytes
+  static void send_message(socket_t sock, const std::vector<char>& message, const char* peer);
+  static void recv_message(socket_t sock, std::vector<char>& message, const char* peer);
+
+  // Reduces and broadcasts at once.  Whatever whole Ts the children have sent are added in and
+  // passed up as they come, and the result is passed down as it comes back from the parent (or,
+  // at the root, as it is reduced), so every stretch of the buffer moves up and down the tree
+  // while the next one is being read and added.  Nothing blocks but the select: a node sending up
+  // and its parent sending down must not wait on each other.
+  template <class T, void(*f)(T&, const T&)> void pipeline(char* buffer, const size_t n)
+  { size_t child_read_pos[2] = { 0,0 }; //First unread byte from left and right children
+    int child_unprocessed[2] = { 0,0 }; //The number of bytes sent by the child but not yet added to the buffer
+    char child_read_buf[2][ar_buf_size + sizeof(T) - 1];
+    size_t parent_sent_pos = 0; //First byte of the reduction not yet sent to the parent
+    size_t parent_read_pos = 0; //First byte of the result not yet read from the parent
+    size_t children_sent_pos[2] = { 0,0 }; //First byte of the result not yet sent to each child
+
+    for (int i = 0; i < 2; i++)
+      if (socks.children[i] == -1)
+        child_read_pos[i] = children_sent_pos[i] = n;
+    if (socks.parent == -1)
+      parent_sent_pos = parent_read_pos = n;
+
+    set_nonblocking(true);
+    while (parent_sent_pos < n || parent_read_pos < n || child_read_pos[0] < n || child_read_pos[1] < n ||
+           children_sent_pos[0] < n || children_sent_pos[1] < n)
+    { size_t reduced = (std::min)(child_read_pos[0], child_read_pos[1]) / sizeof(T) * sizeof(T);
+      size_t result = socks.parent == -1 ? reduced : parent_read_pos;
+
+      fd_set read_fds, write_fds;
+      FD_ZERO(&read_fds);
+      FD_ZERO(&write_fds);
+      socket_t max_fd = 0;
+      if (parent_sent_pos < reduced)
+        FD_SET(socks.parent, &write_fds);
+      if (parent_read_pos < n)
+        FD_SET(socks.parent, &read_fds);
+      for (int i = 0; i < 2; i++)
+      { if (child_read_pos[i] < n)
+          FD_SET(socks.children[i], &read_fds);
+        if (children_sent_pos[i] < result)
+          FD_SET(socks.children[i], &write_fds);
+      }
+      if (parent_sent_pos < n || parent_read_pos < n)
+        max_fd = socks.parent;
+      for (int i = 0; i < 2; i++)
+        if (child_read_pos[i] < n || children_sent_pos[i] < n)
+          max_fd = (std::max)(max_fd, socks.children[i]);
+
+      if (select((int)max_fd + 1, &read_fds, &write_fds, nullptr, nullptr) == -1)
+        THROWERRNO("select");
+
+      for (int i = 0; i < 2; i++)
+        if (child_read_pos[i] < n && FD_ISSET(socks.children[i], &read_fds))
+        { size_t count = (std::min) (ar_buf_size, n - child_read_pos[i]);
+          size_t read_size = recv_some(socks.children[i], &child_read_buf[i][child_unprocessed[i]], count, "child");
+
+          addbufs<T, f>((T*)buffer + child_read_pos[i] / sizeof(T), (T*)child_read_buf[i], (child_read_pos[i] + read_size) / sizeof(T) - child_read_pos[i] / sizeof(T));
+
+          child_read_pos[i] += read_size;
+          int old_unprocessed = child_unprocessed[i];
+          child_unprocessed[i] = child_read_pos[i] % (int)sizeof(T);
+          for (int j = 0; j < child_unprocessed[i]; j++)
+            child_read_buf[i][j] = child_read_buf[i][((old_unprocessed + read_size) / (int)sizeof(T)) * sizeof(T) + j];
+        }
+
+      if (parent_sent_pos < reduced && FD_ISSET(socks.parent, &write_fds))
+        parent_sent_pos += send_some(socks.parent, buffer + parent_sent_pos, reduced - parent_sent_pos, "parent");
+
+      // the parent sends a byte of the result only after it got that byte from here, so reading
+      // the result into the buffer never overwrites what is still to be passed up
+      if (parent_read_pos < n && FD_ISSET(socks.parent, &read_fds))
+        parent_read_pos += recv_some(socks.parent, buffer + parent_read_pos, n - parent_read_pos, "parent");
+
+      for (int i = 0; i < 2; i++)
+        if (children_sent_pos[i] < result && FD_ISSET(socks.children[i], &write_fds))
+          children_sent_pos[i] += send_some(socks.children[i], buffer + children_sent_pos[i], result - children_sent_pos[i], "child");
+    }
+    set_nonblocking(false);
+  }
+
 public:
   AllReduceSockets(std::string pspan_server, const size_t punique_id, size_t ptotal, const size_t pnode)
     : AllReduce(ptotal, pnode), span_server(pspan_server), unique_id(punique_id)
@@ -272,9 +359,24 @@ public:
   }
 
   template <class T, void(*f)(T&, const T&)> void all_reduce(T* buffer, const size_t n)
+  { if (span_server != socks.current_master)
+      all_reduce_init();
+    pipeline<T, f>((char*)buffer, n*sizeof(T));
+  }
+
+  // the whole reduction up the tree, then the whole broadcast down it; what all_reduce did before
+  // it was pipelined, kept to compare against (library/allreduce_benchmark.cc)
+  template <class T, void(*f)(T&, const T&)> void tree_all_reduce(T* buffer, const size_t n)
   { if (span_server != socks.current_master)
       all_reduce_init();
     reduce<T, f>((char*)buffer, n*sizeof(T));
     broadcast((char*)buffer, n*sizeof(T));
   }
+
+  // The AllReduce of messages whose length depends on what they hold (allreduce_compress.h).
+  // combine(children, count, message) merges the count messages of the children into this node's
+  // message, which is then passed up; the root's combined message comes back down the tree and is
+  // what every node's message holds on return.
+  typedef std::function<void(const std::vector<char>* children, size_t count, std::vector<char>& message)> combiner;
+  void all_reduce_messages(std::vector<char>& message, const combiner& combine);
 };
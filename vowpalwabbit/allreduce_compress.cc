@@ -0,0 +1,188 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#include <string.h>
+#include <cmath>
+#include "allreduce_compress.h"
+#include "vw_exception.h"
+
+using namespace std;
+
+SyncEncoding parse_sync_encoding(const string& name)
+{
+  if (name == "dense")
+    return SyncEncoding::dense;
+  if (name == "sparse")
+    return SyncEncoding::sparse;
+  if (name == "fp16")
+    return SyncEncoding::fp16;
+  if (name == "int8")
+    return SyncEncoding::int8;
+  THROW("--allreduce_compression must be dense, sparse, fp16 or int8, not " << name);
+}
+
+namespace allreduce_compress
+{
+// encoding, entry count, int8 scale
+const size_t header_size = 1 + sizeof(uint64_t) + sizeof(float);
+
+uint16_t to_half(float f)
+{
+  uint32_t x;
+  memcpy(&x, &f, sizeof(x));
+  uint16_t sign = (x >> 16) & 0x8000;
+  uint32_t magnitude = x & 0x7fffffff;
+
+  if (magnitude < 0x38800000) // below the smallest normal half: a multiple of 2^-24
+    return sign | (uint16_t)lrintf(fabsf(f) * 16777216.f);
+
+  // rebias the exponent from 127 to 15 and round the mantissa from 23 bits to 10, to nearest even;
+  // a carry out of the mantissa moves the exponent up, as it should
+  uint32_t h = (magnitude - 0x38000000 + 0xfff + ((magnitude >> 13) & 1)) >> 13;
+  if (h >= 0x7c00)
+    h = 0x7bff;
+  return sign | (uint16_t)h;
+}
+
+float from_half(uint16_t h)
+{
+  uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+  uint32_t exponent = (h >> 10) & 0x1f;
+  uint32_t mantissa = h & 0x3ff;
+  if (exponent == 0)
+  {
+    float f = ldexpf((float)mantissa, -24);
+    return sign ? -f : f;
+  }
+  uint32_t x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  float f;
+  memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+inline void put(vector<char>& message, const void* p, size_t size)
+{
+  message.insert(message.end(), (const char*)p, (const char*)p + size);
+}
+
+inline void put_varint(vector<char>& message, uint64_t v)
+{
+  while (v >= 0x80)
+  {
+    message.push_back((char)(v | 0x80));
+    v >>= 7;
+  }
+  message.push_back((char)v);
+}
+
+inline uint64_t get_varint(const char*& p, const char* end)
+{
+  uint64_t v = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7)
+  {
+    uint8_t b = (uint8_t)*p++;
+    v |= (uint64_t)(b & 0x7f) << shift;
+    if (b < 0x80)
+      return v;
+  }
+  THROW("truncated allreduce message");
+}
+
+void encode(SyncEncoding encoding, float* values, size_t length, vector<char>& message)
+{
+  float scale = 0.f;
+  if (encoding == SyncEncoding::int8)
+  {
+    float largest = 0.f;
+    for (size_t i = 0; i < length; i++)
+      largest = max(largest, fabsf(values[i]));
+    scale = largest / 127.f;
+  }
+
+  size_t header = message.size();
+  message.resize(header + header_size);
+  uint64_t count = 0;
+  size_t previous = 0;
+  for (size_t i = 0; i < length; i++)
+  {
+    float v = values[i];
+    if (v == 0.f)
+      continue;
+
+    float kept;
+    if (encoding == SyncEncoding::fp16)
+    {
+      uint16_t h = to_half(v);
+      kept = from_half(h);
+      if (kept == 0.f)
+        continue;
+      put_varint(message, i - previous);
+      put(message, &h, sizeof(h));
+    }
+    else if (encoding == SyncEncoding::int8)
+    {
+      long q = lrintf(v / scale);
+      if (q == 0)
+        continue;
+      int8_t b = (int8_t)max(-127L, min(127L, q));
+      kept = (float)b * scale;
+      put_varint(message, i - previous);
+      put(message, &b, sizeof(b));
+    }
+    else
+    {
+      kept = v;
+      put_varint(message, i - previous);
+      put(message, &v, sizeof(v));
+    }
+    values[i] = v - kept;
+    previous = i;
+    count++;
+  }
+
+  message[header] = (char)encoding;
+  memcpy(&message[header + 1], &count, sizeof(count));
+  memcpy(&message[header + 1 + sizeof(count)], &scale, sizeof(scale));
+}
+
+void decode_add(const vector<char>& message, float* values, size_t length)
+{
+  if (message.size() < header_size)
+    THROW("truncated allreduce message");
+  const char* p = message.data();
+  const char* end = p + message.size();
+  SyncEncoding encoding = (SyncEncoding)p[0];
+  uint64_t count;
+  memcpy(&count, p + 1, sizeof(count));
+  float scale;
+  memcpy(&scale, p + 1 + sizeof(count), sizeof(scale));
+  p += header_size;
+
+  size_t value_size = encoding == SyncEncoding::fp16 ? sizeof(uint16_t) : encoding == SyncEncoding::int8 ? sizeof(int8_t) : sizeof(float);
+  size_t index = 0;
+  for (uint64_t c = 0; c < count; c++)
+  {
+    index += get_varint(p, end);
+    if (index >= length || end - p < (ptrdiff_t)value_size)
+      THROW("bad allreduce message: entry " << c << " of " << count << " at " << index << " of " << length);
+
+    if (encoding == SyncEncoding::fp16)
+    {
+      uint16_t h;
+      memcpy(&h, p, sizeof(h));
+      values[index] += from_half(h);
+    }
+    else if (encoding == SyncEncoding::int8)
+      values[index] += (float)(int8_t)*p * scale;
+    else
+    {
+      float v;
+      memcpy(&v, p, sizeof(v));
+      values[index] += v;
+    }
+    p += value_size;
+  }
+}
+}
@@ -0,0 +1,34 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/* Encodings of the weight syncs of the socket AllReduce (--allreduce_compression).  A message holds
+** only the nonzero entries of a vector, their indices as varint coded gaps: as float32 (sparse,
+** exact), as fp16, or as int8 scaled by the largest magnitude in the message.  Rounding error is not
+** lost: the encoder leaves it in the vector it encoded, to be sent with the next sync.
+*/
+enum class SyncEncoding { dense, sparse, fp16, int8 };
+
+// from the option's argument: dense, sparse, fp16 or int8
+SyncEncoding parse_sync_encoding(const std::string& name);
+
+namespace allreduce_compress
+{
+// appends the nonzero entries of values[0, length) to message, as encoding keeps them, and leaves
+// in values what the encoding lost (all zero for sparse)
+void encode(SyncEncoding encoding, float* values, size_t length, std::vector<char>& message);
+
+// adds the vector message encodes to values[0, length)
+void decode_add(const std::vector<char>& message, float* values, size_t length);
+
+// IEEE half precision, rounding to nearest; out of range magnitudes become the largest finite half
+uint16_t to_half(float f);
+float from_half(uint16_t h);
+}
@@ -99,6 +99,16 @@ socket_t getsock()
   return sock;
 }
 
+// the tail of a stretch of the buffer is sent as soon as it is there rather than held back until
+// what went before is acknowledged; with reduction and broadcast pipelined that wait would stall
+// the tree at every step
+void no_delay(socket_t sock)
+{
+  int on = 1;
+  if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&on, sizeof(on)) < 0)
+    cerr << "setsockopt TCP_NODELAY: " << strerror(errno) << endl;
+}
+
 void AllReduceSockets::all_reduce_init()
 {
 #ifdef _WIN32
@@ -212,6 +222,7 @@ void AllReduceSockets::all_reduce_init()
   if(parent_ip != (uint32_t)-1)
   {
     socks.parent = sock_connect(parent_ip, parent_port);
+    no_delay(socks.parent);
   }
   else
     socks.parent = -1;
@@ -224,6 +235,7 @@ void AllReduceSockets::all_reduce_init()
     socket_t f = accept(sock,(sockaddr*)&child_address,&size);
     if (f < 0)
       THROWERRNO("accept");
+    no_delay(f);
 
     // char hostname[NI_MAXHOST];
     // char servInfo[NI_MAXSERV];
@@ -290,3 +302,120 @@ void AllReduceSockets::broadcast(char* buffer, const size_t n)
     }
   }
 }
+
+// Windows sockets have no MSG_DONTWAIT, so those of the tree are made non-blocking while pipelining
+#ifdef _WIN32
+const int dont_wait = 0;
+#else
+const int dont_wait = MSG_DONTWAIT;
+#endif
+
+void AllReduceSockets::set_nonblocking(bool on)
+{
+#ifdef _WIN32
+  socket_t tree[3] = { socks.parent, socks.children[0], socks.children[1] };
+  for (socket_t sock : tree)
+  {
+    u_long mode = on ? 1 : 0;
+    if (sock != -1 && ioctlsocket(sock, FIONBIO, &mode) != 0)
+      THROWERRNO("ioctlsocket");
+  }
+#endif
+}
+
+bool would_block()
+{
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+size_t AllReduceSockets::send_some(socket_t sock, const char* buffer, size_t length, const char* peer)
+{
+  int sent = send(sock, buffer, (int)length, dont_wait);
+  if (sent < 0)
+  {
+    if (would_block())
+      return 0;
+    THROWERRNO("send to " << peer);
+  }
+  return sent;
+}
+
+size_t AllReduceSockets::recv_some(socket_t sock, char* buffer, size_t length, const char* peer)
+{
+  int read_size = recv(sock, buffer, (int)length, dont_wait);
+  if (read_size == 0)
+    THROW("recv from " << peer << ": connection closed");
+  if (read_size < 0)
+  {
+    if (would_block())
+      return 0;
+    THROWERRNO("recv from " << peer);
+  }
+  return read_size;
+}
+
+void AllReduceSockets::send_message(socket_t sock, const vector<char>& message, const char* peer)
+{
+  uint64_t length = message.size();
+  const char* parts[2] = { (const char*)&length, message.data() };
+  size_t sizes[2] = { sizeof(length), message.size() };
+  for (int p = 0; p < 2; p++)
+    for (size_t sent = 0; sent < sizes[p];)
+    {
+      int count = send(sock, parts[p] + sent, (int)(min)(sizes[p] - sent, (size_t)1 << 30), 0);
+      if (count < 0)
+        THROWERRNO("send to " << peer);
+      sent += count;
+    }
+}
+
+void AllReduceSockets::recv_message(socket_t sock, vector<char>& message, const char* peer)
+{
+  uint64_t length;
+  char* parts[2] = { (char*)&length, nullptr };
+  size_t sizes[2] = { sizeof(length), 0 };
+  for (int p = 0; p < 2; p++)
+  {
+    if (p == 1)
+    {
+      message.resize(length);
+      parts[1] = message.data();
+      sizes[1] = length;
+    }
+    for (size_t read_size = 0; read_size < sizes[p];)
+    {
+      int count = recv(sock, parts[p] + read_size, (int)(min)(sizes[p] - read_size, (size_t)1 << 30), 0);
+      if (count == 0)
+        THROW("recv from " << peer << ": connection closed");
+      if (count < 0)
+        THROWERRNO("recv from " << peer);
+      read_size += count;
+    }
+  }
+}
+
+void AllReduceSockets::all_reduce_messages(vector<char>& message, const combiner& combine)
+{
+  if (span_server != socks.current_master)
+    all_reduce_init();
+
+  vector<char> children[2];
+  size_t count = 0;
+  for (int i = 0; i < 2; i++)
+    if (socks.children[i] != -1)
+      recv_message(socks.children[i], children[count++], "child");
+  combine(children, count, message);
+
+  if (socks.parent != -1)
+  {
+    send_message(socks.parent, message, "parent");
+    recv_message(socks.parent, message, "parent");
+  }
+  for (int i = 0; i < 2; i++)
+    if (socks.children[i] != -1)
+      send_message(socks.children[i], message, "child");
+}
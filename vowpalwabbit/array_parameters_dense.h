@@ -2,6 +2,14 @@
 
 #include <cstdint>
 #include "memory.h"
+#include "huge_pages.h"
+
+#ifdef _WIN32
+#include <xmmintrin.h>
+#define VW_PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define VW_PREFETCH(p) __builtin_prefetch(p)
+#endif
 
 typedef float weight;
 
@@ -45,24 +53,48 @@ private:
   uint64_t _weight_mask;  // (stride*(1 << num_bits) -1)
   uint32_t _stride_shift;
   bool _seeded; // whether the instance is sharing model state with others
+  uint32_t _prefetch_distance; // how many features ahead the feature loops request weights, 0 for not at all
+  weight_pages _pages;
+  size_t _mapped; // bytes mapped at _begin, 0 when it came from calloc
+
+  void release()
+  {
+    if (_mapped != 0)
+      unmap_weights(_begin, _mapped);
+    else
+      free(_begin);
+    _begin = nullptr;
+    _mapped = 0;
+  }
 
 public:
   typedef dense_iterator<weight> iterator;
   typedef dense_iterator<const weight> const_iterator;
-  dense_parameters(size_t length, uint32_t stride_shift = 0)
-    : _begin(calloc_mergable_or_throw<weight>(length << stride_shift)),
+  dense_parameters(size_t length, uint32_t stride_shift = 0, weight_pages pages = small_pages)
+    : _begin(nullptr),
     _weight_mask((length << stride_shift) - 1),
     _stride_shift(stride_shift),
-    _seeded(false)
-  { }
+    _seeded(false),
+    _prefetch_distance(0),
+    _pages(pages),
+    _mapped(0)
+  {
+    if (_pages != small_pages)
+      _begin = (weight*)map_weights((length << stride_shift) * sizeof(weight), _pages, _mapped);
+    if (_begin == nullptr)
+    {
+      _mapped = 0; // release() frees a calloc'd array
+      _begin = calloc_mergable_or_throw<weight>(length << stride_shift);
+    }
+  }
 
   dense_parameters()
-    : _begin(nullptr), _weight_mask(0), _stride_shift(0), _seeded(false)
+    : _begin(nullptr), _weight_mask(0), _stride_shift(0), _seeded(false), _prefetch_distance(0), _pages(small_pages), _mapped(0)
   {}
 
   bool not_null() { return (_weight_mask > 0 && _begin != nullptr); }
 
-  dense_parameters(const dense_parameters &other) { shallow_copy(other); }
+  dense_parameters(const dense_parameters &other) : dense_parameters() { shallow_copy(other); }
   dense_parameters(dense_parameters &&) = delete;
 
   weight* first() { return _begin; } //TODO: Temporary fix for allreduce.
@@ -76,13 +108,16 @@ public:
   const_iterator cend() { return const_iterator(_begin + _weight_mask + 1, _begin, stride()); }
 
   inline weight& operator[](size_t i) const { return _begin[i & _weight_mask]; }
+  inline void prefetch(size_t i) const { VW_PREFETCH(_begin + (i & _weight_mask)); }
   void shallow_copy(const dense_parameters& input)
   {
     if (!_seeded)
-      free(_begin);
+      release();
     _begin = input._begin;
     _weight_mask = input._weight_mask;
     _stride_shift = input._stride_shift;
+    _prefetch_distance = input._prefetch_distance;
+    _pages = input._pages;
     _seeded = true;
   }
 
@@ -118,6 +153,13 @@ public:
 
   void stride_shift(uint32_t stride_shift) { _stride_shift = stride_shift; }
 
+  uint32_t prefetch_distance() const { return _prefetch_distance; }
+
+  void prefetch_distance(uint32_t distance) { _prefetch_distance = distance; }
+
+  // what the weights ended up on, which may be less than was asked of the constructor
+  weight_pages pages() const { return _pages; }
+
 #ifndef _WIN32
 #ifndef DISABLE_SHARED_WEIGHTS
   void share(size_t length)
@@ -127,8 +169,10 @@ public:
     size_t float_count = length << _stride_shift;
     weight* dest = shared_weights;
     memcpy(dest, _begin, float_count * sizeof(float));
-    free(_begin);
+    release();
     _begin = dest;
+    _mapped = float_count * sizeof(float);
+    _pages = small_pages;
   }
 #endif
 #endif
@@ -136,9 +180,10 @@ public:
   ~dense_parameters()
   {
     if (_begin != nullptr && !_seeded)  // don't free weight vector if it is shared with another instance
-    {
-      free(_begin);
-      _begin = nullptr;
-    }
+      release();
   }
 };
+
+// the weight lookahead hooks of interactions_predict.h, found by argument dependent lookup
+inline uint32_t prefetch_distance(const dense_parameters& weights) { return weights.prefetch_distance(); }
+inline void prefetch_weight(const dense_parameters& weights, uint64_t index) { weights.prefetch(index); }
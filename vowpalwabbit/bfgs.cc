@@ -19,7 +19,9 @@ Implementation by Miro Dudik.
 #include "accumulate.h"
 #include "reductions.h"
 #include "gd.h"
+#include "vw.h"
 #include "vw_exception.h"
+#include "worker_pool.h"
 
 using namespace std;
 using namespace LEARNER;
@@ -99,16 +101,94 @@ struct bfgs
   bool first_pass;
   bool gradient_pass;
   bool preconditioner_pass;
+
+  // --bfgs_threads
+  size_t threads;
+  worker_pool* pool;             // nullptr with one thread
+  v_array<double> block_sums;    // max_sums for each thread
+  example* batch;                // copies of gradient pass examples whose gradients are yet to be added
+  v_array<float> batch_grads;    // and their loss gradients
+  v_array<float*> gradients;     // what threads 1.. add up over a gradient pass; thread 0 adds to W_GT
 };
 
+/* --bfgs_threads: each pass over the dense weights is cut into a block of weights for each thread,
+** and what a pass adds up is added up block by block, the blocks' sums in block order.  Examples of
+** a gradient pass are predicted as they come, and copied into a batch; the gradients of a full batch
+** are added up by the threads, each taking a contiguous share of it into a gradient vector of its
+** own, and the vectors are added into W_GT at the end of the pass.  So a given number of threads
+** always gives the same model, and one thread the model it always did.
+*/
+const size_t gradient_batch = 1024;
+
 const char* curv_message = "Zero or negative curvature detected.\n"
                            "To increase curvature you can increase regularization or rescale features.\n"
                            "It is also possible that you have reached numerical accuracy\n"
                            "and further decrease in the objective cannot be reliably detected.\n";
 
-void zero_derivative(vw& all) { all.weights.set_zero(W_GT); }
+// what a sweep's blocks add up, at most this many sums
+const size_t max_sums = 4;
+
+// a sweep runs f(begin, end, sums) over all the weights, f adding what it adds up to sums[0, count)
+template<class F>
+void sweep(bfgs&, sparse_parameters& weights, F f, double* sums = nullptr, size_t = 0, bool = false)
+{
+  f(weights.begin(), weights.end(), sums);
+}
 
-void zero_preconditioner(vw& all) { all.weights.set_zero(W_COND);}
+// the dense weights are cut into a block for each thread; the blocks' sums are added up (or their
+// maximum taken) in block order
+template<class F>
+void sweep(bfgs& b, dense_parameters& weights, F f, double* sums = nullptr, size_t count = 0, bool take_max = false)
+{
+  if (b.pool == nullptr)
+  {
+    f(weights.begin(), weights.end(), sums);
+    return;
+  }
+
+  size_t threads = b.pool->threads();
+  uint64_t length = (weights.mask() + 1) >> weights.stride_shift();
+  uint32_t shift = weights.stride_shift();
+  weight* first = weights.first();
+  double* block_sums = b.block_sums.begin();
+  memset(block_sums, 0, threads * max_sums * sizeof(double));
+  b.pool->run([&](size_t t)
+  {
+    uint64_t lo = length * t / threads;
+    uint64_t hi = length * (t + 1) / threads;
+    f(dense_parameters::iterator(first + (lo << shift), first, weights.stride()),
+      dense_parameters::iterator(first + (hi << shift), first, weights.stride()), block_sums + t * max_sums);
+  });
+  for (size_t t = 0; t < threads; t++)
+    for (size_t i = 0; i < count; i++)
+      if (!take_max)
+        sums[i] += block_sums[t * max_sums + i];
+      else if (block_sums[t * max_sums + i] > sums[i])
+        sums[i] = block_sums[t * max_sums + i];
+}
+
+void zero_weights(bfgs& b, sparse_parameters& weights, size_t offset) { weights.set_zero(offset); }
+
+void zero_weights(bfgs& b, dense_parameters& weights, size_t offset)
+{
+  sweep(b, weights, [offset](dense_parameters::iterator begin, dense_parameters::iterator end, double*)
+  {
+    for (dense_parameters::iterator w = begin; w != end; ++w)
+      (&(*w))[offset] = 0;
+  });
+}
+
+void zero_weights(vw& all, bfgs& b, size_t offset)
+{
+  if (all.weights.sparse)
+    zero_weights(b, all.weights.sparse_weights, offset);
+  else
+    zero_weights(b, all.weights.dense_weights, offset);
+}
+
+void zero_derivative(vw& all, bfgs& b) { zero_weights(all, b, W_GT); }
+
+void zero_preconditioner(vw& all, bfgs& b) { zero_weights(all, b, W_COND); }
 
 void reset_state(vw& all, bfgs& b, bool zero)
 {
@@ -121,8 +201,8 @@ void reset_state(vw& all, bfgs& b, bool zero)
   b.preconditioner_pass = true;
   if (zero)
   {
-    zero_derivative(all);
-    zero_preconditioner(all);
+    zero_derivative(all, b);
+    zero_preconditioner(all, b);
   }
 }
 
@@ -144,14 +224,84 @@ float bfgs_predict(vw& all, example& ec)
 
 inline void add_grad(float& d, float f, float& fw) { (&fw)[W_GT] += d * f; }
 
-float predict_and_gradient(vw& all, example &ec)
+struct thread_gradient
+{
+  float loss_grad;
+  float* gradients;
+  uint64_t mask;
+  uint32_t stride_shift;
+};
+
+inline void add_thread_grad(thread_gradient& g, float f, uint64_t index)
+{ g.gradients[(index & g.mask) >> g.stride_shift] += g.loss_grad * f; }
+
+void add_batch_gradients(vw& all, bfgs& b)
+{
+  example* batch = b.batch;
+  float* loss_grads = b.batch_grads.begin();
+  size_t count = b.batch_grads.size();
+  size_t threads = b.pool->threads();
+  b.pool->run([&all, &b, batch, loss_grads, count, threads](size_t t)
+  {
+    size_t first = count * t / threads;
+    size_t last = count * (t + 1) / threads;
+    if (t == 0)
+      for (size_t i = first; i < last; i++)
+        GD::foreach_feature<float,add_grad>(all, batch[i], loss_grads[i]);
+    else
+    {
+      dense_parameters& weights = all.weights.dense_weights;
+      thread_gradient g = { 0.f, b.gradients[t - 1], weights.mask(), weights.stride_shift() };
+      for (size_t i = first; i < last; i++)
+      {
+        g.loss_grad = loss_grads[i];
+        GD::foreach_feature<thread_gradient, uint64_t, add_thread_grad>(all, batch[i], g);
+      }
+    }
+  });
+  b.batch_grads.clear();
+}
+
+void batch_gradient(vw& all, bfgs& b, example& ec, float loss_grad)
+{
+  VW::copy_example_data(false, &b.batch[b.batch_grads.size()], &ec);
+  b.batch_grads.push_back(loss_grad);
+  if (b.batch_grads.size() == gradient_batch)
+    add_batch_gradients(all, b);
+}
+
+// the end of a gradient pass: what is left of the batch, then the threads' gradients into W_GT
+void add_thread_gradients(vw& all, bfgs& b)
+{
+  if (b.batch_grads.size() > 0)
+    add_batch_gradients(all, b);
+
+  dense_parameters& weights = all.weights.dense_weights;
+  sweep(b, weights, [&b, &weights](dense_parameters::iterator begin, dense_parameters::iterator end, double*)
+  {
+    for (dense_parameters::iterator w = begin; w != end; ++w)
+    {
+      uint64_t i = w.index() >> weights.stride_shift();
+      for (float* gradients : b.gradients)
+      {
+        (&(*w))[W_GT] += gradients[i];
+        gradients[i] = 0.f;
+      }
+    }
+  });
+}
+
+float predict_and_gradient(vw& all, bfgs& b, example &ec)
 {
   float fp = bfgs_predict(all, ec);
   label_data& ld = ec.l.simple;
   all.set_minmax(all.sd, ld.label);
 
   float loss_grad = all.loss->first_derivative(all.sd, fp,ld.label)*ec.weight;
-  GD::foreach_feature<float,add_grad>(all, ec, loss_grad);
+  if (b.pool == nullptr)
+    GD::foreach_feature<float,add_grad>(all, ec, loss_grad);
+  else
+    batch_gradient(all, b, ec, loss_grad);
 
   return fp;
 }
@@ -178,13 +328,23 @@ double regularizer_direction_magnitude(vw& all, bfgs& b, double regularizer, T&
 {
   double ret = 0.;
   if (b.regularizers == nullptr)
-    for (typename T::iterator iter = weights.begin(); iter != weights.end(); ++iter)
-      ret += regularizer* (&(*iter))[W_DIR] * (&(*iter))[W_DIR];
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* sums)
+    {
+      double s = 0.;
+      for (typename T::iterator iter = begin; iter != end; ++iter)
+        s += regularizer* (&(*iter))[W_DIR] * (&(*iter))[W_DIR];
+      sums[0] += s;
+    }, &ret, 1);
 
   else
   {
-    for (typename T::iterator iter = weights.begin(); iter != weights.end(); ++iter)
-      ret += ((double)b.regularizers[2 * (iter.index() >> weights.stride_shift())]) * (&(*iter))[W_DIR] * (&(*iter))[W_DIR];
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* sums)
+    {
+      double s = 0.;
+      for (typename T::iterator iter = begin; iter != end; ++iter)
+        s += ((double)b.regularizers[2 * (iter.index() >> weights.stride_shift())]) * (&(*iter))[W_DIR] * (&(*iter))[W_DIR];
+      sums[0] += s;
+    }, &ret, 1);
   }
   return ret;
 }
@@ -204,48 +364,59 @@ double regularizer_direction_magnitude(vw& all, bfgs& b, float regularizer)
 }
 
 template<class T>
-float direction_magnitude(vw& all, T& weights)
+float direction_magnitude(vw& all, bfgs& b, T& weights)
 {
   //compute direction magnitude
   double ret = 0.;
-  for (typename T::iterator iter = weights.begin(); iter != weights.end(); ++iter)
-    ret += ((double)(&(*iter))[W_DIR]) * (&(*iter))[W_DIR];
+  sweep(b, weights, [](typename T::iterator begin, typename T::iterator end, double* sums)
+  {
+    double s = 0.;
+    for (typename T::iterator iter = begin; iter != end; ++iter)
+      s += ((double)(&(*iter))[W_DIR]) * (&(*iter))[W_DIR];
+    sums[0] += s;
+  }, &ret, 1);
 
   return (float)ret;
 }
 
-float direction_magnitude(vw& all)
+float direction_magnitude(vw& all, bfgs& b)
 {
   //compute direction magnitude
   if (all.weights.sparse)
-    return direction_magnitude(all, all.weights.sparse_weights);
+    return direction_magnitude(all, b, all.weights.sparse_weights);
   else
-    return direction_magnitude(all, all.weights.dense_weights);
+    return direction_magnitude(all, b, all.weights.dense_weights);
 }
 
 template<class T>
 void bfgs_iter_start(vw& all, bfgs& b, float* mem, int& lastj, double importance_weight_sum, int&origin, T& weights)
 {
-  double g1_Hg1 = 0.;
-  double g1_g1 = 0.;
+  double sums[2] = { 0., 0. }; // g1_Hg1, g1_g1
 
   origin = 0;
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+  sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
   {
-    float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    if (b.m>0)
-      mem1[(MEM_XT + origin) % b.mem_stride] = (&(*w))[W_XT];
-    mem1[(MEM_GT + origin) % b.mem_stride] = (&(*w))[W_GT];
-    g1_Hg1 += ((double)(&(*w))[W_GT]) * ((&(*w))[W_GT]) * ((&(*w))[W_COND]);
-    g1_g1 += ((double)((&(*w))[W_GT])) * ((&(*w))[W_GT]);
-    (&(*w))[W_DIR] = -(&(*w))[W_COND] * ((&(*w))[W_GT]);
-    ((&(*w))[W_GT]) = 0;
-  }
+    double g1_Hg1 = 0.;
+    double g1_g1 = 0.;
+    for (typename T::iterator w = begin; w != end; ++w)
+    {
+      float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
+      if (b.m>0)
+        mem1[(MEM_XT + origin) % b.mem_stride] = (&(*w))[W_XT];
+      mem1[(MEM_GT + origin) % b.mem_stride] = (&(*w))[W_GT];
+      g1_Hg1 += ((double)(&(*w))[W_GT]) * ((&(*w))[W_GT]) * ((&(*w))[W_COND]);
+      g1_g1 += ((double)((&(*w))[W_GT])) * ((&(*w))[W_GT]);
+      (&(*w))[W_DIR] = -(&(*w))[W_COND] * ((&(*w))[W_GT]);
+      ((&(*w))[W_GT]) = 0;
+    }
+    s[0] += g1_Hg1;
+    s[1] += g1_g1;
+  }, sums, 2);
   lastj = 0;
   if (!all.quiet)
     fprintf(stderr, "%-10.5f\t%-10.5f\t%-10s\t%-10s\t%-10s\t",
-            g1_g1 / (importance_weight_sum*importance_weight_sum),
-            g1_Hg1 / importance_weight_sum, "", "", "");
+            sums[1] / (importance_weight_sum*importance_weight_sum),
+            sums[0] / importance_weight_sum, "", "", "");
 }
 
 void bfgs_iter_start(vw& all, bfgs& b, float* mem, int& lastj, double importance_weight_sum, int&origin)
@@ -264,33 +435,41 @@ void bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha,
   // implement conjugate gradient
   if (b.m == 0)
   {
-    double g_Hy = 0.;
-    double g_Hg = 0.;
-    double y = 0.;
-
+    double sums[2] = { 0., 0. }; // g_Hy, g_Hg
 
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
     {
-      mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-      y = (&(*w))[W_GT] - mem[(MEM_GT + origin) % b.mem_stride];
-      g_Hy += ((double)(&(*w))[W_GT]) * ((&(*w))[W_COND]) * y;
-      g_Hg += ((double)mem[(MEM_GT + origin) % b.mem_stride]) * ((&(*w))[W_COND]) * mem[(MEM_GT + origin) % b.mem_stride];
-    }
+      double g_Hy = 0.;
+      double g_Hg = 0.;
+      double y = 0.;
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        float* mem1 = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
+        y = (&(*w))[W_GT] - mem1[(MEM_GT + origin) % b.mem_stride];
+        g_Hy += ((double)(&(*w))[W_GT]) * ((&(*w))[W_COND]) * y;
+        g_Hg += ((double)mem1[(MEM_GT + origin) % b.mem_stride]) * ((&(*w))[W_COND]) * mem1[(MEM_GT + origin) % b.mem_stride];
+      }
+      s[0] += g_Hy;
+      s[1] += g_Hg;
+    }, sums, 2);
 
-    float beta = (float)(g_Hy / g_Hg);
+    float beta = (float)(sums[0] / sums[1]);
 
     if (beta<0.f || nanpattern(beta))
       beta = 0.f;
 
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double*)
     {
-      mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-      mem[(MEM_GT + origin) % b.mem_stride] = (&(*w))[W_GT];
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        float* mem1 = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
+        mem1[(MEM_GT + origin) % b.mem_stride] = (&(*w))[W_GT];
 
-      (&(*w))[W_DIR] *= beta;
-      (&(*w))[W_DIR] -= ((&(*w))[W_COND])*((&(*w))[W_GT]);
-      (&(*w))[W_GT] = 0;
-    }
+        (&(*w))[W_DIR] *= beta;
+        (&(*w))[W_DIR] -= ((&(*w))[W_COND])*((&(*w))[W_GT]);
+        (&(*w))[W_GT] = 0;
+      }
+    });
     if (!all.quiet)
       fprintf(stderr, "%f\t", beta);
     return;
@@ -304,20 +483,30 @@ void bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha,
   }
 
   // implement bfgs
-  double y_s = 0.;
-  double y_Hy = 0.;
-  double s_q = 0.;
+  double sums[3] = { 0., 0., 0. }; // y_s, y_Hy, s_q
 
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+  sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
   {
-    float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    mem1[(MEM_YT + origin) % b.mem_stride] = (&(*w))[W_GT] - mem1[(MEM_GT + origin) % b.mem_stride];
-    mem1[(MEM_ST + origin) % b.mem_stride] = (&(*w))[W_XT] - mem1[(MEM_XT + origin) % b.mem_stride];
-    (&(*w))[W_DIR] = (&(*w))[W_GT];
-    y_s += ((double)mem1[(MEM_YT + origin) % b.mem_stride]) * mem1[(MEM_ST + origin) % b.mem_stride];
-    y_Hy += ((double)mem1[(MEM_YT + origin) % b.mem_stride]) * mem1[(MEM_YT + origin) % b.mem_stride] * ((&(*w))[W_COND]);
-    s_q += ((double)mem1[(MEM_ST + origin) % b.mem_stride]) * ((&(*w))[W_GT]);
-  }
+    double y_s = 0.;
+    double y_Hy = 0.;
+    double s_q = 0.;
+    for (typename T::iterator w = begin; w != end; ++w)
+    {
+      float* mem1 = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
+      mem1[(MEM_YT + origin) % b.mem_stride] = (&(*w))[W_GT] - mem1[(MEM_GT + origin) % b.mem_stride];
+      mem1[(MEM_ST + origin) % b.mem_stride] = (&(*w))[W_XT] - mem1[(MEM_XT + origin) % b.mem_stride];
+      (&(*w))[W_DIR] = (&(*w))[W_GT];
+      y_s += ((double)mem1[(MEM_YT + origin) % b.mem_stride]) * mem1[(MEM_ST + origin) % b.mem_stride];
+      y_Hy += ((double)mem1[(MEM_YT + origin) % b.mem_stride]) * mem1[(MEM_YT + origin) % b.mem_stride] * ((&(*w))[W_COND]);
+      s_q += ((double)mem1[(MEM_ST + origin) % b.mem_stride]) * ((&(*w))[W_GT]);
+    }
+    s[0] += y_s;
+    s[1] += y_Hy;
+    s[2] += s_q;
+  }, sums, 3);
+  double y_s = sums[0];
+  double y_Hy = sums[1];
+  double s_q = sums[2];
 
   if (y_s <= 0. || y_Hy <= 0.)
     throw curv_ex;
@@ -329,24 +518,34 @@ void bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha,
   {
     alpha[j] = rho[j] * s_q;
     s_q = 0.;
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
     {
-      mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-      (&(*w))[W_DIR] -= (float)alpha[j] * mem[(2 * j + MEM_YT + origin) % b.mem_stride];
-      s_q += ((double)mem[(2 * j + 2 + MEM_ST + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
-    }
+      double s_q = 0.;
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        float* mem1 = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
+        (&(*w))[W_DIR] -= (float)alpha[j] * mem1[(2 * j + MEM_YT + origin) % b.mem_stride];
+        s_q += ((double)mem1[(2 * j + 2 + MEM_ST + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
+      }
+      s[0] += s_q;
+    }, &s_q, 1);
   }
 
   alpha[lastj] = rho[lastj] * s_q;
   double y_r = 0.;
 
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+  sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
   {
-    mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    (&(*w))[W_DIR] -= (float)alpha[lastj] * mem[(2 * lastj + MEM_YT + origin) % b.mem_stride];
-    (&(*w))[W_DIR] *= gamma*((&(*w))[W_COND]);
-    y_r += ((double)mem[(2 * lastj + MEM_YT + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
-  }
+    double y_r = 0.;
+    for (typename T::iterator w = begin; w != end; ++w)
+    {
+      float* mem1 = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
+      (&(*w))[W_DIR] -= (float)alpha[lastj] * mem1[(2 * lastj + MEM_YT + origin) % b.mem_stride];
+      (&(*w))[W_DIR] *= gamma*((&(*w))[W_COND]);
+      y_r += ((double)mem1[(2 * lastj + MEM_YT + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
+    }
+    s[0] += y_r;
+  }, &y_r, 1);
 
   double coef_j;
 
@@ -354,21 +553,29 @@ void bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha,
   {
     coef_j = alpha[j] - rho[j] * y_r;
     y_r = 0.;
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
     {
-      mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-      (&(*w))[W_DIR] += (float)coef_j*mem[(2 * j + MEM_ST + origin) % b.mem_stride];
-      y_r += ((double)mem[(2 * j - 2 + MEM_YT + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
-    }
+      double y_r = 0.;
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        float* mem1 = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
+        (&(*w))[W_DIR] += (float)coef_j*mem1[(2 * j + MEM_ST + origin) % b.mem_stride];
+        y_r += ((double)mem1[(2 * j - 2 + MEM_YT + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
+      }
+      s[0] += y_r;
+    }, &y_r, 1);
   }
 
 
   coef_j = alpha[0] - rho[0] * y_r;
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+  sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double*)
   {
-    mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    (&(*w))[W_DIR] = -(&(*w))[W_DIR] - (float)coef_j*mem[(MEM_ST + origin) % b.mem_stride];
-  }
+    for (typename T::iterator w = begin; w != end; ++w)
+    {
+      float* mem1 = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
+      (&(*w))[W_DIR] = -(&(*w))[W_DIR] - (float)coef_j*mem1[(MEM_ST + origin) % b.mem_stride];
+    }
+  });
 
   /*********************
   ** shift
@@ -377,13 +584,16 @@ void bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha,
   lastj = (lastj<b.m - 1) ? lastj + 1 : b.m - 1;
   origin = (origin + b.mem_stride - 2) % b.mem_stride;
 
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+  sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double*)
   {
-    mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    mem[(MEM_GT + origin) % b.mem_stride] = (&(*w))[W_GT];
-    mem[(MEM_XT + origin) % b.mem_stride] = (&(*w))[W_XT];
-    (&(*w))[W_GT] = 0;
-  }
+    for (typename T::iterator w = begin; w != end; ++w)
+    {
+      float* mem1 = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
+      mem1[(MEM_GT + origin) % b.mem_stride] = (&(*w))[W_GT];
+      mem1[(MEM_XT + origin) % b.mem_stride] = (&(*w))[W_XT];
+      (&(*w))[W_GT] = 0;
+    }
+  });
   for (int j = lastj; j>0; j--)
     rho[j] = rho[j - 1];
 }
@@ -399,20 +609,31 @@ void bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha,
 template<class T>
 double wolfe_eval(vw& all, bfgs& b, float* mem, double loss_sum, double previous_loss_sum, double step_size, double importance_weight_sum, int &origin, double& wolfe1, T& weights)
 {
-  double g0_d = 0.;
-  double g1_d = 0.;
-  double g1_Hg1 = 0.;
-  double g1_g1 = 0.;
-
+  double sums[4] = { 0., 0., 0., 0. }; // g0_d, g1_d, g1_Hg1, g1_g1
 
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+  sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
   {
-    float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    g0_d += ((double)mem1[(MEM_GT + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
-    g1_d += ((double)(&(*w))[W_GT]) * (&(*w))[W_DIR];
-    g1_Hg1 += ((double)(&(*w))[W_GT]) * (&(*w))[W_GT] * ((&(*w))[W_COND]);
-    g1_g1 += ((double)(&(*w))[W_GT]) * (&(*w))[W_GT];
-  }
+    double g0_d = 0.;
+    double g1_d = 0.;
+    double g1_Hg1 = 0.;
+    double g1_g1 = 0.;
+    for (typename T::iterator w = begin; w != end; ++w)
+    {
+      float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
+      g0_d += ((double)mem1[(MEM_GT + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
+      g1_d += ((double)(&(*w))[W_GT]) * (&(*w))[W_DIR];
+      g1_Hg1 += ((double)(&(*w))[W_GT]) * (&(*w))[W_GT] * ((&(*w))[W_COND]);
+      g1_g1 += ((double)(&(*w))[W_GT]) * (&(*w))[W_GT];
+    }
+    s[0] += g0_d;
+    s[1] += g1_d;
+    s[2] += g1_Hg1;
+    s[3] += g1_g1;
+  }, sums, 4);
+  double g0_d = sums[0];
+  double g1_d = sums[1];
+  double g1_Hg1 = sums[2];
+  double g1_g1 = sums[3];
 
   wolfe1 = (loss_sum - previous_loss_sum) / (step_size*g0_d);
   double wolfe2 = g1_d / g0_d;
@@ -437,19 +658,29 @@ template <class T> double add_regularization(vw& all, bfgs& b, float regularizat
   double ret = 0.;
 
   if (b.regularizers == nullptr)
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
     {
-      (&(*w))[W_GT] += regularization*(*w);
-      ret += 0.5*regularization*(*w)*(*w);
-    }
+      double ret = 0.;
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        (&(*w))[W_GT] += regularization*(*w);
+        ret += 0.5*regularization*(*w)*(*w);
+      }
+      s[0] += ret;
+    }, &ret, 1);
   else
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
     {
-      uint64_t i = w.index() >> weights.stride_shift();
-      weight delta_weight = *w - b.regularizers[2 * i + 1];
-      (&(*w))[W_GT] += b.regularizers[2 * i] * delta_weight;
-      ret += 0.5*b.regularizers[2 * i] * delta_weight*delta_weight;
-    }
+      double ret = 0.;
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        uint64_t i = w.index() >> weights.stride_shift();
+        weight delta_weight = *w - b.regularizers[2 * i + 1];
+        (&(*w))[W_GT] += b.regularizers[2 * i] * delta_weight;
+        ret += 0.5*b.regularizers[2 * i] * delta_weight*delta_weight;
+      }
+      s[0] += ret;
+    }, &ret, 1);
 
   // if we're not regularizing the intercept term, then subtract it off from the result above
   if (all.no_bias)
@@ -482,34 +713,49 @@ double add_regularization(vw& all, bfgs& b, float regularization)
 template <class T>
 void finalize_preconditioner(vw& all, bfgs& b, float regularization, T& weights)
 {
-  float max_hessian = 0.f;
+  double max_hessian = 0.;
 
   if (b.regularizers == nullptr)
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
     {
-      (&(*w))[W_COND] += regularization;
-      if ((&(*w))[W_COND] > max_hessian)
-        max_hessian = (&(*w))[W_COND];
-      if ((&(*w))[W_COND] > 0)
-        (&(*w))[W_COND] = 1.f / (&(*w))[W_COND];
-    }
+      float max_hessian = 0.f;
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        (&(*w))[W_COND] += regularization;
+        if ((&(*w))[W_COND] > max_hessian)
+          max_hessian = (&(*w))[W_COND];
+        if ((&(*w))[W_COND] > 0)
+          (&(*w))[W_COND] = 1.f / (&(*w))[W_COND];
+      }
+      if (max_hessian > s[0])
+        s[0] = max_hessian;
+    }, &max_hessian, 1, true);
   else
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
     {
-      (&(*w))[W_COND] += b.regularizers[2 * (w.index()>> weights.stride_shift())];
-      if ((&(*w))[W_COND] > max_hessian)
-        max_hessian = (&(*w))[W_COND];
-      if ((&(*w))[W_COND] > 0)
-        (&(*w))[W_COND] = 1.f / (&(*w))[W_COND];
-    }
+      float max_hessian = 0.f;
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        (&(*w))[W_COND] += b.regularizers[2 * (w.index()>> weights.stride_shift())];
+        if ((&(*w))[W_COND] > max_hessian)
+          max_hessian = (&(*w))[W_COND];
+        if ((&(*w))[W_COND] > 0)
+          (&(*w))[W_COND] = 1.f / (&(*w))[W_COND];
+      }
+      if (max_hessian > s[0])
+        s[0] = max_hessian;
+    }, &max_hessian, 1, true);
 
-  float max_precond = (max_hessian == 0.f) ? 0.f : max_precond_ratio / max_hessian;
+  float max_precond = (max_hessian == 0.) ? 0.f : max_precond_ratio / (float)max_hessian;
 
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+  sweep(b, weights, [max_precond](typename T::iterator begin, typename T::iterator end, double*)
   {
-    if (infpattern(*w) || *w >max_precond)
-      (&(*w))[W_COND] = max_precond;
-  }
+    for (typename T::iterator w = begin; w != end; ++w)
+    {
+      if (infpattern(*w) || *w >max_precond)
+        (&(*w))[W_COND] = max_precond;
+    }
+  });
 }
 void finalize_preconditioner(vw& all, bfgs& b, float regularization)
 {
@@ -531,23 +777,32 @@ void preconditioner_to_regularizer(vw& all, bfgs& b, float regularization, T& we
     if (b.regularizers == nullptr)
       THROW("Failed to allocate weight array: try decreasing -b <bits>");
 
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double*)
     {
-      uint64_t i = w.index() >> weights.stride_shift();
-      b.regularizers[2 * i] = regularization;
-      if ((&(*w))[W_COND] > 0.f)
-        b.regularizers[2 * i] += 1.f / (&(*w))[W_COND];
-    }
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        uint64_t i = w.index() >> weights.stride_shift();
+        b.regularizers[2 * i] = regularization;
+        if ((&(*w))[W_COND] > 0.f)
+          b.regularizers[2 * i] += 1.f / (&(*w))[W_COND];
+      }
+    });
   }
   else
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double*)
     {
-      if ((&(*w))[W_COND] > 0.f)
-        b.regularizers[2 * (w.index() >> weights.stride_shift())] += 1.f / (&(*w))[W_COND];
-    }
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        if ((&(*w))[W_COND] > 0.f)
+          b.regularizers[2 * (w.index() >> weights.stride_shift())] += 1.f / (&(*w))[W_COND];
+      }
+    });
 
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-    b.regularizers[2 * (w.index()>> weights.stride_shift()) + 1] = *w;
+  sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double*)
+  {
+    for (typename T::iterator w = begin; w != end; ++w)
+      b.regularizers[2 * (w.index()>> weights.stride_shift()) + 1] = *w;
+  });
 }
 void preconditioner_to_regularizer(vw& all, bfgs& b, float regularization)
 {
@@ -562,12 +817,15 @@ void regularizer_to_weight(vw& all, bfgs& b, T& weights)
 {
   if (b.regularizers != nullptr)
   {
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double*)
     {
-      uint64_t i = w.index() >> weights.stride_shift();
-      (&(*w))[W_COND] = b.regularizers[2 * i];
-      *w = b.regularizers[2 * i + 1];
-    }
+      for (typename T::iterator w = begin; w != end; ++w)
+      {
+        uint64_t i = w.index() >> weights.stride_shift();
+        (&(*w))[W_COND] = b.regularizers[2 * i];
+        *w = b.regularizers[2 * i + 1];
+      }
+    });
   }
 }
 
@@ -579,22 +837,27 @@ void regularizer_to_weight(vw& all, bfgs& b)
     regularizer_to_weight(all, b, all.weights.dense_weights);
 }
 
-void zero_state(vw& all)
+void zero_state(vw& all, bfgs& b)
 {
-  all.weights.set_zero(W_GT);
-  all.weights.set_zero(W_DIR);
-  all.weights.set_zero(W_COND);
+  zero_weights(all, b, W_GT);
+  zero_weights(all, b, W_DIR);
+  zero_weights(all, b, W_COND);
 }
 
 template<class T>
 double derivative_in_direction(vw& all, bfgs& b, float* mem, int &origin, T& weights)
 {
   double ret = 0.;
-  for (typename T::iterator w = weights.begin(); w != weights.end();  ++w)
+  sweep(b, weights, [&](typename T::iterator begin, typename T::iterator end, double* s)
   {
-    float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    ret += ((double)mem1[(MEM_GT + origin) % b.mem_stride]) * (&(*w))[W_DIR];
-  }
+    double ret = 0.;
+    for (typename T::iterator w = begin; w != end;  ++w)
+    {
+      float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
+      ret += ((double)mem1[(MEM_GT + origin) % b.mem_stride]) * (&(*w))[W_DIR];
+    }
+    s[0] += ret;
+  }, &ret, 1);
   return ret;
 }
 
@@ -608,18 +871,21 @@ double derivative_in_direction(vw& all, bfgs& b, float* mem, int &origin)
 }
 
 template<class T>
-void update_weight(vw& all, float step_size, T& w)
+void update_weight(vw& all, bfgs& b, float step_size, T& w)
 {
-  for (typename T::iterator iter = w.begin(); iter != w.end(); ++iter)
-    (&(*iter))[W_XT] += step_size * (&(*iter))[W_DIR];
+  sweep(b, w, [step_size](typename T::iterator begin, typename T::iterator end, double*)
+  {
+    for (typename T::iterator iter = begin; iter != end; ++iter)
+      (&(*iter))[W_XT] += step_size * (&(*iter))[W_DIR];
+  });
 }
 
-void update_weight(vw& all, float step_size)
+void update_weight(vw& all, bfgs& b, float step_size)
 {
   if (all.weights.sparse)
-    update_weight(all, step_size, all.weights.sparse_weights);
+    update_weight(all, b, step_size, all.weights.sparse_weights);
   else
-    update_weight(all, step_size, all.weights.dense_weights);
+    update_weight(all, b, step_size, all.weights.dense_weights);
 }
 
 
@@ -663,13 +929,13 @@ int process_pass(vw& all, bfgs& b)
     else
     {
       b.step_size = 0.5;
-      float d_mag = direction_magnitude(all);
+      float d_mag = direction_magnitude(all, b);
       ftime(&b.t_end_global);
       b.net_time = (int) (1000.0 * (b.t_end_global.time - b.t_start_global.time) + (b.t_end_global.millitm - b.t_start_global.millitm));
       if (!all.quiet)
         fprintf(stderr, "%-10s\t%-10.5f\t%-.5f\n", "", d_mag, b.step_size);
       b.predictions.clear();
-      update_weight(all, b.step_size);
+      update_weight(all, b, b.step_size);
     }
   }
   else
@@ -728,9 +994,9 @@ int process_pass(vw& all, bfgs& b)
                   "","",ratio,
                   new_step);
         b.predictions.clear();
-        update_weight(all, (float)(-b.step_size+new_step));
+        update_weight(all, b, (float)(-b.step_size+new_step));
         b.step_size = (float)new_step;
-        zero_derivative(all);
+        zero_derivative(all, b);
         b.loss_sum = 0.;
       }
 
@@ -770,13 +1036,13 @@ int process_pass(vw& all, bfgs& b)
         }
         else
         {
-          float d_mag = direction_magnitude(all);
+          float d_mag = direction_magnitude(all, b);
           ftime(&b.t_end_global);
           b.net_time = (int) (1000.0 * (b.t_end_global.time - b.t_start_global.time) + (b.t_end_global.millitm - b.t_start_global.millitm));
           if (!all.quiet)
             fprintf(stderr, "%-10s\t%-10.5f\t%-.5f\n", "", d_mag, b.step_size);
           b.predictions.clear();
-          update_weight(all, b.step_size);
+          update_weight(all, b, b.step_size);
         }
       }
     }
@@ -809,10 +1075,10 @@ int process_pass(vw& all, bfgs& b)
       else
         b.step_size = - dd/(float)b.curvature;
 
-      float d_mag = direction_magnitude(all);
+      float d_mag = direction_magnitude(all, b);
 
       b.predictions.clear();
-      update_weight(all, b.step_size);
+      update_weight(all, b, b.step_size);
       ftime(&b.t_end_global);
       b.net_time = (int) (1000.0 * (b.t_end_global.time - b.t_start_global.time) + (b.t_end_global.millitm - b.t_start_global.millitm));
 
@@ -849,7 +1115,7 @@ void process_example(vw& all, bfgs& b, example& ec)
   /********************************************************************/
   if (b.gradient_pass)
   {
-    ec.pred.scalar = predict_and_gradient(all, ec);//w[0] & w[1]
+    ec.pred.scalar = predict_and_gradient(all, b, ec);//w[0] & w[1]
     ec.loss = all.loss->getLoss(all.sd, ec.pred.scalar, ld.label) * ec.weight;
     b.loss_sum += ec.loss;
     b.predictions.push_back(ec.pred.scalar);
@@ -878,6 +1144,9 @@ void end_pass(bfgs& b)
 {
   vw* all = b.all;
 
+  if (b.pool != nullptr && b.gradient_pass)
+    add_thread_gradients(*all, b);
+
   if (b.current_pass <= b.final_pass)
   {
     if(b.current_pass < b.final_pass)
@@ -907,7 +1176,7 @@ void end_pass(bfgs& b)
       {
         // Not converged yet.
         // Reset preconditioner to zero so that it is correctly recomputed in the next pass
-        zero_preconditioner(*all);
+        zero_preconditioner(*all, b);
       }
       if(!all->holdout_set_off)
       {
@@ -957,6 +1226,19 @@ void finish(bfgs& b)
   free(b.mem);
   free(b.rho);
   free(b.alpha);
+
+  if (b.pool != nullptr)
+  {
+    delete b.pool;
+    b.block_sums.delete_v();
+    for (size_t i = 0; i < gradient_batch; i++)
+      VW::dealloc_example(nullptr, b.batch[i]);
+    free(b.batch);
+    b.batch_grads.delete_v();
+    for (float* gradients : b.gradients)
+      free(gradients);
+    b.gradients.delete_v();
+  }
 }
 
 void save_load_regularizer(vw& all, bfgs& b, io_buf& model_file, bool read, bool text)
@@ -1031,6 +1313,9 @@ void save_load(bfgs& b, io_buf& model_file, bool read, bool text)
     b.mem = calloc_or_throw<float>(all->length()*b.mem_stride);
     b.rho = calloc_or_throw<double>(m);
     b.alpha = calloc_or_throw<double>(m);
+    if (b.pool != nullptr)
+      for (size_t t = 1; t < b.pool->threads(); t++)
+        b.gradients.push_back(calloc_or_throw<float>(all->length()));
 
     uint32_t stride_shift = all->weights.stride_shift();
 
@@ -1087,6 +1372,8 @@ base_learner* bfgs_setup(arguments& arg)
         ("mem", b->m, 15, "memory in bfgs")
         ("termination", b->rel_threshold, 0.001f,"Termination threshold").missing())
       return nullptr;
+  arg.new_options("")
+  ("bfgs_threads", b->threads, (size_t)1, "threads for the passes over the weights and the gradients of the examples").missing();
   b->all = arg.all;
   b->wolfe1_bound = 0.01;
   b->first_hessian_on=true;
@@ -1121,6 +1408,16 @@ base_learner* bfgs_setup(arguments& arg)
   if (arg.all->numpasses < 2 && arg.all->training)
     THROW("you must make at least 2 passes to use BFGS");
 
+  if (b->threads > 1)
+  {
+    if (arg.all->weights.sparse)
+      THROW("--bfgs_threads needs dense weights");
+    b->pool = new worker_pool;
+    b->pool->start(b->threads);
+    b->block_sums.resize(b->threads * max_sums);
+    b->batch = VW::alloc_examples(0, gradient_batch);
+  }
+
   arg.all->bfgs = true;
   arg.all->weights.stride_shift(2);
 
@@ -62,11 +62,9 @@ __attribute__((packed))
 #endif
 ;
 
-int read_cached_features(vw* all, v_array<example*>& examples)
+static int read_cached_example(vw* all, io_buf* input, example* ae)
 {
-  example* ae = examples[0];
   ae->sorted = all->p->sorted_cache;
-  io_buf* input = all->p->input;
 
   size_t total = all->p->lp.read_cached_label(all->sd, &ae->l, *input);
   if (total == 0)
@@ -80,7 +78,7 @@ int read_cached_features(vw* all, v_array<example*>& examples)
   num_indices = *(unsigned char*)c;
   c += sizeof(num_indices);
 
-  all->p->input->set(c);
+  input->set(c);
   for (; num_indices > 0; num_indices--)
   {
     size_t temp;
@@ -97,7 +95,7 @@ int read_cached_features(vw* all, v_array<example*>& examples)
     features& ours = ae->feature_space[index];
     size_t storage = *(size_t *)c;
     c += sizeof(size_t);
-    all->p->input->set(c);
+    input->set(c);
     total += storage;
     if (buf_read(*input,c,storage) < storage)
     {
@@ -129,12 +127,17 @@ int read_cached_features(vw* all, v_array<example*>& examples)
       last = i;
       ours.push_back(v,i);
     }
-    all->p->input->set(c);
+    input->set(c);
   }
 
   return (int)total;
 }
 
+int read_cached_features(vw* all, v_array<example*>& examples)
+{
+  return read_cached_example(all, all->p->input, examples[0]);
+}
+
 inline uint64_t ZigZagEncode(int64_t n)
 {
   uint64_t ret = (n << 1) ^ (n >> 63);
@@ -208,3 +211,287 @@ void cache_features(io_buf& cache, example* ae, uint64_t mask)
   for (namespace_index ns : ae->indices)
     output_features(cache, ns, ae->feature_space[ns], mask);
 }
+
+/* Cache files use a columnar encoding, one block per namespace:
+**   index (1 byte) | kind (1 byte) | count (uint32_t) | index bytes (uint32_t)
+**   controls: 2 bits per feature choosing 1, 2, 4 or 8 bytes for its index delta
+**   index data: the deltas between consecutive indices, ZigZag encoded only when unsorted
+**   values: count floats, present only when some value differs from 1
+** Keeping the lengths apart from the deltas (as stream-vbyte does) means one control byte
+** locates four deltas, which the decoder then extracts with a single shuffle.
+*/
+const unsigned char has_values = 1;
+const unsigned char unsorted = 2;
+const size_t columns_header = 2*sizeof(unsigned char) + 2*sizeof(uint32_t);
+
+static const size_t delta_length[4] = { 1, 2, 4, 8 };
+static const uint64_t delta_mask[4] = { 0xff, 0xffff, 0xffffffff, 0xffffffffffffffff };
+
+// decodes the delta of feature i at data into out[i], returns the data past it
+inline char* decode_delta(unsigned char* controls, char* data, char* end, size_t i, uint64_t* out)
+{
+  size_t key = (controls[i >> 2] >> 2*(i & 3)) & 3;
+  uint64_t delta = 0;
+  if (data + sizeof(delta) <= end)
+  {
+    memcpy(&delta, data, sizeof(delta));
+    delta &= delta_mask[key];
+  }
+  else
+    memcpy(&delta, data, delta_length[key]);
+  out[i] = delta;
+  return data + delta_length[key];
+}
+
+// decodes count deltas from [data, end) into out
+static void decode_deltas_scalar(unsigned char* controls, char* data, char* end, size_t count, uint64_t* out)
+{
+  for (size_t i = 0; i < count; i++)
+    data = decode_delta(controls, data, end, i, out);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VW_CACHE_SIMD
+#include <immintrin.h>
+
+// for every control byte, the shuffle spreading its four deltas over 32 bit lanes
+struct delta_shuffles
+{
+  __m128i shuffle[256];
+  unsigned char length[256];
+
+  delta_shuffles()
+  {
+    for (size_t control = 0; control < 256; control++)
+    {
+      unsigned char bytes[16];
+      size_t in = 0;
+      for (size_t k = 0; k < 4; k++)
+      {
+        size_t len = delta_length[(control >> 2*k) & 3];
+        for (size_t b = 0; b < 4; b++)
+          bytes[4*k + b] = b < len ? (unsigned char)(in + b) : 0x80;
+        in += len;
+      }
+      shuffle[control] = _mm_loadu_si128((__m128i*)bytes);
+      length[control] = (unsigned char)in;
+    }
+  }
+};
+static delta_shuffles shuffles;
+
+// as decode_deltas_scalar, four deltas per shuffle
+__attribute__((target("ssse3")))
+static void decode_deltas_ssse3(unsigned char* controls, char* data, char* end, size_t count, uint64_t* out)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    unsigned char control = controls[i >> 2];
+    // a whole group of four, none of them 8 bytes long, and 16 readable bytes
+    if ((i & 3) == 0 && i + 4 <= count && data + 16 <= end && !(control & (control >> 1) & 0x55))
+    {
+      __m128i deltas = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)data), shuffles.shuffle[control]);
+      _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi32(deltas, _mm_setzero_si128()));
+      _mm_storeu_si128((__m128i*)(out + i + 2), _mm_unpackhi_epi32(deltas, _mm_setzero_si128()));
+      data += shuffles.length[control];
+      i += 3;
+      continue;
+    }
+    data = decode_delta(controls, data, end, i, out);
+  }
+}
+#endif
+
+std::vector<named_decoder> delta_decoders()
+{
+  std::vector<named_decoder> available = { { "scalar", decode_deltas_scalar } };
+#ifdef VW_CACHE_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("ssse3"))
+    available.push_back({ "ssse3", decode_deltas_ssse3 });
+#endif
+  return available;
+}
+
+static delta_decoder pick_decoder() { return delta_decoders().back().decode; }
+
+delta_decoder decode_deltas = pick_decoder();
+
+static int read_cached_columns(vw* all, io_buf* input, example* ae)
+{
+  ae->sorted = all->p->sorted_cache;
+
+  size_t total = all->p->lp.read_cached_label(all->sd, &ae->l, *input);
+  if (total == 0)
+    return 0;
+  if (read_cached_tag(*input,ae) == 0)
+    return 0;
+  char* c;
+  unsigned char num_indices = 0;
+  if (buf_read(*input, c, sizeof(num_indices)) < sizeof(num_indices))
+    return 0;
+  num_indices = *(unsigned char*)c;
+  c += sizeof(num_indices);
+
+  input->set(c);
+  for (; num_indices > 0; num_indices--)
+  {
+    size_t temp;
+    if((temp = buf_read(*input,c,columns_header)) < columns_header)
+    {
+      all->opts_n_args.trace_message << "truncated example! " << temp << " " << columns_header << endl;
+      return 0;
+    }
+
+    unsigned char index = *(unsigned char*)c;
+    unsigned char kind = *(unsigned char*)(c + 1);
+    uint32_t count, index_bytes;
+    memcpy(&count, c + 2, sizeof(count));
+    memcpy(&index_bytes, c + 2 + sizeof(count), sizeof(index_bytes));
+    c += columns_header;
+    input->set(c);
+
+    size_t num_controls = (count + 3) / 4;
+    size_t value_bytes = (kind & has_values) ? count * sizeof(feature_value) : 0;
+    size_t storage = num_controls + index_bytes + value_bytes;
+    total += columns_header + storage;
+    if (buf_read(*input,c,storage) < storage)
+    {
+      all->opts_n_args.trace_message << "truncated example! wanted: " << storage << " bytes" << endl;
+      return 0;
+    }
+
+    ae->indices.push_back((size_t)index);
+    features& ours = ae->feature_space[index];
+    size_t old_size = ours.size();
+    if ((size_t)(ours.indicies.end_array - ours.indicies.begin()) < old_size + count)
+      ours.indicies.resize(old_size + count);
+    if ((size_t)(ours.values.end_array - ours.values.begin()) < old_size + count)
+      ours.values.resize(old_size + count);
+
+    char* data = c + num_controls;
+    char* values = data + index_bytes;
+    feature_index* indices = ours.indicies.begin() + old_size;
+    decode_deltas((unsigned char*)c, data, values, count, indices);
+
+    uint64_t last = 0;
+    if (kind & unsorted)
+    {
+      ae->sorted = false;
+      for (size_t i = 0; i < count; i++)
+      {
+        last += ZigZagDecode(indices[i]);
+        indices[i] = last;
+      }
+    }
+    else
+      for (size_t i = 0; i < count; i++)
+      {
+        last += indices[i];
+        indices[i] = last;
+      }
+    ours.indicies.end() = indices + count;
+
+    feature_value* vs = ours.values.begin() + old_size;
+    if (kind & has_values)
+    {
+      memcpy(vs, values, value_bytes);
+      for (size_t i = 0; i < count; i++)
+        ours.sum_feat_sq += vs[i] * vs[i];
+    }
+    else
+    {
+      for (size_t i = 0; i < count; i++)
+        vs[i] = 1.f;
+      ours.sum_feat_sq += (float)count;
+    }
+    ours.values.end() = vs + count;
+
+    input->set(values + value_bytes);
+  }
+
+  return (int)total;
+}
+
+int read_cached_columns(vw* all, v_array<example*>& examples)
+{
+  return read_cached_columns(all, all->p->input, examples[0]);
+}
+
+void output_columns(io_buf& cache, unsigned char index, features& fs, uint64_t mask)
+{
+  size_t count = fs.size();
+  unsigned char kind = 0;
+  uint64_t last = 0;
+  for (features::iterator& f : fs)
+  {
+    feature_index fi = f.index() & mask;
+    if (fi < last)
+      kind |= unsorted;
+    if (f.value() != 1.)
+      kind |= has_values;
+    last = fi;
+  }
+
+  size_t num_controls = (count + 3) / 4;
+  size_t value_bytes = (kind & has_values) ? count * sizeof(feature_value) : 0;
+  char* c;
+  buf_write(cache, c, columns_header + num_controls + count * sizeof(uint64_t) + value_bytes);
+  *reinterpret_cast<unsigned char*>(c) = index;
+  *reinterpret_cast<unsigned char*>(c + 1) = kind;
+  uint32_t count32 = (uint32_t)count;
+  memcpy(c + 2, &count32, sizeof(count32));
+  char* index_bytes_loc = c + 2 + sizeof(count32);
+
+  unsigned char* controls = (unsigned char*)(c + columns_header);
+  memset(controls, 0, num_controls);
+  char* data = (char*)controls + num_controls;
+  char* data_begin = data;
+
+  last = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    feature_index fi = fs.indicies[i] & mask;
+    uint64_t delta = (kind & unsorted) ? ZigZagEncode(fi - last) : fi - last;
+    last = fi;
+    size_t key = delta <= delta_mask[0] ? 0 : delta <= delta_mask[1] ? 1 : delta <= delta_mask[2] ? 2 : 3;
+    controls[i >> 2] |= (unsigned char)(key << 2*(i & 3));
+    memcpy(data, &delta, delta_length[key]);
+    data += delta_length[key];
+  }
+  uint32_t index_bytes = (uint32_t)(data - data_begin);
+  memcpy(index_bytes_loc, &index_bytes, sizeof(index_bytes));
+
+  if (kind & has_values)
+  {
+    memcpy(data, fs.values.begin(), value_bytes);
+    data += value_bytes;
+  }
+  cache.set(data);
+}
+
+void cache_columns(io_buf& cache, example* ae, uint64_t mask)
+{
+  cache_tag(cache,ae->tag);
+  output_byte(cache, (unsigned char) ae->indices.size());
+
+  for (namespace_index ns : ae->indices)
+    output_columns(cache, ns, ae->feature_space[ns], mask);
+}
+
+void convert_cache(vw& all, io_buf& from, io_buf& to)
+{
+  example* ae = VW::alloc_examples(all.p->lp.label_size, 1);
+  while (true)
+  {
+    all.p->lp.default_label(&ae->l);
+    if (read_cached_example(&all, &from, ae) == 0)
+      break;
+    all.p->lp.cache_label(&ae->l, to);
+    cache_columns(to, ae, (uint64_t)-1);
+    VW::empty_example(all, *ae);
+  }
+  to.flush();
+  VW::dealloc_example(all.p->lp.delete_label, *ae);
+  free(ae);
+}
@@ -7,6 +7,11 @@ license as described in the file LICENSE.
 #include "v_array.h"
 #include "io_buf.h"
 #include "example.h"
+#include <vector>
+
+// The byte following the version in a cache file header names the encoding of its examples.
+const char cache_varint_format = 'c';   // per feature varints, still used to send examples to a daemon
+const char cache_columns_format = 'C';  // per namespace columns, written to cache files
 
 char* run_len_decode(char *p, size_t& i);
 char* run_len_encode(char *p, size_t i);
@@ -17,3 +22,22 @@ void cache_features(io_buf& cache, example* ae, uint64_t mask);
 void output_byte(io_buf& cache, unsigned char s);
 void output_features(io_buf& cache, unsigned char index, features& fs, uint64_t mask);
 
+
+int read_cached_columns(vw* all, v_array<example*>& examples);
+void cache_columns(io_buf& cache, example* ae, uint64_t mask);
+void output_columns(io_buf& cache, unsigned char index, features& fs, uint64_t mask);
+
+// rewrites the examples of a varint cache (positioned after its header) as columns
+void convert_cache(vw& all, io_buf& from, io_buf& to);
+
+// decodes the count index deltas of a column, sized by the 2 bit controls, from [data, end) into out
+typedef void (*delta_decoder)(unsigned char* controls, char* data, char* end, size_t count, uint64_t* out);
+extern delta_decoder decode_deltas;
+
+struct named_decoder
+{ const char* name;
+  delta_decoder decode;
+};
+
+// the decoders of this build this CPU can run, the plain loop first; decode_deltas is the last
+std::vector<named_decoder> delta_decoders();
@@ -74,6 +74,8 @@ struct cb_explore_adf
 
   v_array<COST_SENSITIVE::label> prepped_cs_labels;
 
+  v_array<polyprediction> policy_preds; // the ranked action scores under each policy, see multipredict_policies
+
   // for RegCB
   std::vector<float> min_costs;
   std::vector<float> max_costs;
@@ -228,6 +230,22 @@ size_t fill_tied(cb_explore_adf& data, v_array<action_score>& preds)
   return ret;
 }
 
+/* Predictions of the csoaa_ldf learner's policies 0, stride, ..., (count-1)*stride in data.policy_preds,
+** each action's features walked once for all of them, rather than once per policy as a predict per
+** policy does.  Policy i of cb_adf is the csoaa_ldf learner's policy i times the ratio of their increments.
+*/
+void multipredict_policies(cb_explore_adf& data, multi_ex& examples, COST_SENSITIVE::label& cs_labels, size_t count,
+                           size_t stride = 1)
+{
+  if (data.policy_preds.size() < count)
+  {
+    data.policy_preds.resize(count);
+    data.policy_preds.end() = data.policy_preds.end_array;
+  }
+  GEN_CS::call_cs_ldf_multipredict(*data.cs_ldf_learner, examples, data.cb_labels, cs_labels, data.prepped_cs_labels,
+                                   data.offset, 0, count, stride, data.policy_preds.begin());
+}
+
 template <bool is_learn>
 void predict_or_learn_first(cb_explore_adf& data, multi_learner& base, multi_ex& examples)
 {
@@ -399,6 +417,12 @@ void predict_or_learn_bag(cb_explore_adf& data, multi_learner& base, multi_ex& e
   vector<float>& top_actions = data.top_actions;
   top_actions.assign(num_actions, 0);
   bool test_sequence = test_adf_sequence(examples) == nullptr;
+  // without learning the policies only predict, all of them at once
+  if (!is_learn)
+  {
+    GEN_CS::gen_cs_test_example(examples, data.cs_labels);
+    multipredict_policies(data, examples, data.cs_labels, data.bag_size, base.increment / data.cs_ldf_learner->increment);
+  }
   for (uint32_t i = 0; i < data.bag_size; i++)
   {
     // avoid updates to the random num generator
@@ -409,21 +433,22 @@ void predict_or_learn_bag(cb_explore_adf& data, multi_learner& base, multi_ex& e
 
     if (is_learn && count > 0 && !test_sequence)
       multiline_learn_or_predict<true>(base, examples, data.offset, i);
-    else
+    else if (is_learn)
       multiline_learn_or_predict<false>(base, examples, data.offset, i);
+    v_array<action_score>& policy = is_learn ? preds : data.policy_preds[i].a_s;
 
-    assert(preds.size() == num_actions);
-    for (auto e : preds)
+    assert(policy.size() == num_actions);
+    for (auto e : policy)
       data.scores[e.action] += e.score;
 
     if (!data.first_only)
     {
-      size_t tied_actions = fill_tied(data, preds);
+      size_t tied_actions = fill_tied(data, policy);
       for (size_t i = 0; i < tied_actions; ++i)
-        top_actions[preds[i].action] += 1.f / tied_actions;
+        top_actions[policy[i].action] += 1.f / tied_actions;
     }
     else
-      top_actions[preds[0].action] += 1.f;
+      top_actions[policy[0].action] += 1.f;
     if (is_learn && !test_sequence)
       for (uint32_t j = 1; j < count; j++)
         multiline_learn_or_predict<true>(base, examples, data.offset, i);
@@ -440,8 +465,9 @@ void predict_or_learn_bag(cb_explore_adf& data, multi_learner& base, multi_ex& e
 
   do_sort(data);
 
+  preds.clear();
   for (size_t i = 0; i < num_actions; i++)
-    preds[i] = data.action_probs[i];
+    preds.push_back(data.action_probs[i]);
 }
 
 template <bool is_learn>
@@ -460,8 +486,11 @@ void predict_or_learn_cover(cb_explore_adf& data, multi_learner& base, multi_ex&
   }
   else
   {
+    // the policies only predict, all of them at once: the first is base's, the others the
+    // csoaa_ldf learner's 2 to cover_size as below
     GEN_CS::gen_cs_example_ips(examples, data.cs_labels);
-    multiline_learn_or_predict<false>(base, examples, data.offset);
+    multipredict_policies(data, examples, data.cs_labels, data.cover_size + 1);
+    copy_array(examples[0]->pred.a_s, data.policy_preds[0].a_s);
   }
 
   v_array<action_score>& preds = examples[0]->pred.a_s;
@@ -504,27 +533,26 @@ void predict_or_learn_cover(cb_explore_adf& data, multi_learner& base, multi_ex&
       }
       GEN_CS::call_cs_ldf<true>(*(data.cs_ldf_learner), examples, data.cb_labels, data.cs_labels_2, data.prepped_cs_labels, data.offset, i+1);
     }
-    else
-      GEN_CS::call_cs_ldf<false>(*(data.cs_ldf_learner), examples, data.cb_labels, data.cs_labels, data.prepped_cs_labels, data.offset, i+1);
+    v_array<action_score>& policy = is_learn ? preds : data.policy_preds[i+1].a_s;
 
     for (uint32_t i = 0; i < num_actions; i++)
-      data.scores[i] += preds[i].score;
+      data.scores[i] += policy[i].score;
     if (!data.first_only)
     {
-      size_t tied_actions = fill_tied(data, preds);
+      size_t tied_actions = fill_tied(data, policy);
       const float add_prob = additive_probability / tied_actions;
       for (size_t i = 0; i < tied_actions; ++i)
         {
-          if (probs[preds[i].action].score < min_prob)
-            norm += max(0, add_prob - (min_prob - probs[preds[i].action].score));
+          if (probs[policy[i].action].score < min_prob)
+            norm += max(0, add_prob - (min_prob - probs[policy[i].action].score));
           else
             norm += add_prob;
-          probs[preds[i].action].score += add_prob;
+          probs[policy[i].action].score += add_prob;
         }
     }
     else
       {
-        uint32_t action = preds[0].action;
+        uint32_t action = policy[0].action;
         if (probs[action].score < min_prob)
           norm += max(0, additive_probability - (min_prob - probs[action].score));
         else
@@ -571,6 +599,9 @@ void finish(cb_explore_adf& data)
   for(size_t i = 0; i < data.prepped_cs_labels.size(); i++)
     data.prepped_cs_labels[i].costs.delete_v();
   data.prepped_cs_labels.delete_v();
+  for (size_t i = 0; i < data.policy_preds.size(); i++)
+    data.policy_preds[i].a_s.delete_v();
+  data.policy_preds.delete_v();
   data.gen_cs.pred_scores.costs.delete_v();
 }
 
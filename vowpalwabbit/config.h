@@ -0,0 +1 @@
+#define PACKAGE_VERSION "8.6.1"
@@ -162,6 +162,13 @@ struct ldf
   uint64_t ft_offset;
 
   v_array<action_scores > stored_preds;
+
+  bool linear;            // the base is gd scoring linearly, see score_shared
+  bool raw_multipredict;  // and base.multipredict gives the raw scores under many policies, see multipredict
+  v_array<polyprediction> shared_scores; // scratch for multipredict
+  v_array<polyprediction> scores;
+  bool interacting[256];  // namespaces appearing in an interaction
+  bool interacting_known;
 };
 
 bool ec_is_label_definition(example& ec) // label defs look like "0:___" or just "label:___"
@@ -240,7 +247,70 @@ void unsubtract_example(example *ec)
   ec->indices.decr();
 }
 
-void make_single_prediction(ldf& data, single_learner& base, example& ec)
+// the shared example's own namespaces reach the actions' scores only through single features
+bool shared_is_linear(ldf& data, example& shared)
+{
+  if (!data.linear)
+    return false;
+  if (!data.interacting_known)
+  {
+    memset(data.interacting, 0, sizeof(data.interacting));
+    for (string& inter : data.all->interactions)
+      for (unsigned char ns : inter)
+        data.interacting[ns] = true;
+    data.interacting_known = true;
+  }
+
+  if (shared.indices.size() > 0 && find(shared.indices.begin(), shared.indices.end() - 1, constant_namespace) != shared.indices.end() - 1)
+    return false; // the constant must come last to be left out below
+  for (namespace_index ns : shared.indices)
+    if (ns != constant_namespace && data.interacting[ns])
+      return false;
+  return true;
+}
+
+/* The score of the shared features, which every action's score would otherwise recompute from a
+** copy of them (add_example_namespaces_from_example).  The actions are then scored on their own
+** features and this is added, as a sum over all the features would have it when shared_is_linear.
+** The shared example's constant is left out, as the copy leaves it out.
+*/
+void score_shared(ldf& data, single_learner& base, example& shared, size_t count, size_t stride, polyprediction* scores)
+{
+  COST_SENSITIVE::label ld = shared.l.cs;
+  polyprediction pred = shared.pred;
+  float partial_prediction = shared.partial_prediction;
+  uint64_t old_offset = shared.ft_offset;
+  bool constant = shared.indices.size() > 0 && shared.indices.last() == constant_namespace;
+  if (constant)
+    shared.indices.decr();
+
+  shared.l.simple.initial = 0.;
+  shared.l.simple.label = FLT_MAX;
+  shared.ft_offset = data.ft_offset;
+  if (count == 1)
+  {
+    base.predict(shared);
+    scores[0].scalar = shared.partial_prediction;
+  }
+  else
+    base.multipredict(shared, 0, count, scores, false, stride);
+
+  if (constant)
+    shared.indices.push_back(constant_namespace);
+  shared.ft_offset = old_offset;
+  shared.partial_prediction = partial_prediction;
+  shared.pred = pred;
+  shared.l.cs = ld;
+}
+
+float score_shared(ldf& data, single_learner& base, example& shared)
+{
+  polyprediction score;
+  score_shared(data, base, shared, 1, 1, &score);
+  return score.scalar;
+}
+
+void make_single_prediction(ldf& data, single_learner& base, example& ec, float shared_score = 0.)
 {
   COST_SENSITIVE::label ld = ec.l.cs;
   label_data simple_label;
@@ -254,12 +324,33 @@ void make_single_prediction(ldf& data, single_learner& base, example& ec)
   ec.ft_offset = data.ft_offset;
   base.predict(ec); // make a prediction
   ec.ft_offset = old_offset;
+  ec.partial_prediction += shared_score;
   ld.costs[0].partial_prediction = ec.partial_prediction;
 
   LabelDict::del_example_namespace_from_memory(data.label_features, ec, ld.costs[0].class_index);
   ec.l.cs = ld;
 }
 
+// make_single_prediction under the policies 0, stride, ..., (count-1)*stride at once, the raw scores in scores
+void make_multi_prediction(ldf& data, single_learner& base, example& ec, size_t count, size_t stride, polyprediction* scores)
+{
+  COST_SENSITIVE::label ld = ec.l.cs;
+  label_data simple_label;
+  simple_label.initial = 0.;
+  simple_label.label = FLT_MAX;
+
+  LabelDict::add_example_namespace_from_memory(data.label_features, ec, ld.costs[0].class_index);
+
+  ec.l.simple = simple_label;
+  uint64_t old_offset = ec.ft_offset;
+  ec.ft_offset = data.ft_offset;
+  base.multipredict(ec, 0, count, scores, false, stride);
+  ec.ft_offset = old_offset;
+
+  LabelDict::del_example_namespace_from_memory(data.label_features, ec, ld.costs[0].class_index);
+  ec.l.cs = ld;
+}
+
 bool test_ldf_sequence(ldf& data, size_t start_K, multi_ex& ec_seq)
 {
   bool isTest;
@@ -434,14 +525,20 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
   /////////////////////// add headers
   uint32_t K = (uint32_t)ec_seq.size();
   uint32_t start_K = 0;
+  bool shared_apart = false; // scored once by score_shared instead of copied into every action
+  float shared_score = 0.;
 
   if (ec_is_example_header(*ec_seq[0]))
   {
     start_K = 1;
-    for (uint32_t k=1; k<K; k++)
-      LabelDict::add_example_namespaces_from_example(*ec_seq[k], *ec_seq[0]);
+    shared_apart = shared_is_linear(data, *ec_seq[0]);
+    if (!shared_apart)
+      for (uint32_t k=1; k<K; k++)
+        LabelDict::add_example_namespaces_from_example(*ec_seq[k], *ec_seq[0]);
   }
   bool isTest = test_ldf_sequence(data, start_K, ec_seq);
+  if (shared_apart)
+    shared_score = score_shared(data, base, *ec_seq[0]);
   /////////////////////// do prediction
   uint32_t predicted_K = start_K;
   if(data.rank)
@@ -454,7 +551,7 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
     {
       data.stored_preds.push_back(ec_seq[k]->pred.a_s);
       example *ec = ec_seq[k];
-      make_single_prediction(data, base, *ec);
+      make_single_prediction(data, base, *ec, shared_score);
       action_score s;
       s.score = ec->partial_prediction;
       s.action = k - start_K;
@@ -469,7 +566,7 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
     for (uint32_t k=start_K; k<K; k++)
     {
       example *ec = ec_seq[k];
-      make_single_prediction(data, base, *ec);
+      make_single_prediction(data, base, *ec, shared_score);
       if (ec->partial_prediction < min_score)
       {
         min_score = ec->partial_prediction;
@@ -481,6 +578,13 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
   /////////////////////// learn
   if (is_learn && !isTest)
   {
+    // learning updates the shared weights from every action, which takes the copies after all
+    if (shared_apart)
+    {
+      for (uint32_t k=1; k<K; k++)
+        LabelDict::add_example_namespaces_from_example(*ec_seq[k], *ec_seq[0]);
+      shared_apart = false;
+    }
     if (data.is_wap) do_actual_learning_wap(data, base, start_K, ec_seq);
     else             do_actual_learning_oaa(data, base, start_K, ec_seq);
   }
@@ -510,7 +614,7 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
     }
   }
   /////////////////////// remove header
-  if (start_K > 0)
+  if (start_K > 0 && !shared_apart)
     for (size_t k=1; k<K; k++)
       LabelDict::del_example_namespaces_from_example(*ec_seq[k], *ec_seq[0]);
 
@@ -536,6 +640,77 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
   }
 }
 
+/* --csoaa_rank predictions under count policies step apart, the ranked action scores under the c-th in
+** pred[c].a_s.  When the scores are raw linear sums each action's features are walked once by
+** base.multipredict, which accumulates the scores under all the policies together, and the shared
+** features once more if shared_is_linear.  Otherwise this predicts with one policy after another.
+*/
+void multipredict(ldf& data, single_learner& base, multi_ex& ec_seq_all, size_t count, size_t step,
+                  polyprediction* pred, bool)
+{
+  for (size_t c = 0; c < count; c++)
+    pred[c].a_s.clear();
+  if (ec_seq_all.size() == 0) return;
+
+  if (!data.raw_multipredict)
+  {
+    for (size_t c = 0; c < count; c++)
+    {
+      do_actual_learning<false>(data, base, ec_seq_all);
+      copy_array(pred[c].a_s, data.a_s);
+      increment_offset(ec_seq_all, step, 1);
+    }
+    decrement_offset(ec_seq_all, step, count);
+    return;
+  }
+
+  data.ft_offset = ec_seq_all[0]->ft_offset;
+  auto ec_seq = process_labels(data, ec_seq_all);
+  if (ec_seq.size() == 0) return;
+  if (ec_seq_has_label_definition(ec_seq))
+    THROW("error: label definition encountered in data block");
+
+  uint32_t K = (uint32_t)ec_seq.size();
+  uint32_t start_K = 0;
+  bool shared_apart = false;
+  size_t stride = step / base.increment;
+  if (data.scores.size() < count)
+  {
+    data.shared_scores.resize(count);
+    data.shared_scores.end() = data.shared_scores.end_array;
+    data.scores.resize(count);
+    data.scores.end() = data.scores.end_array;
+  }
+  polyprediction* shared_scores = data.shared_scores.begin();
+  polyprediction* scores = data.scores.begin();
+  for (size_t c = 0; c < count; c++)
+    shared_scores[c].scalar = 0.;
+
+  if (ec_is_example_header(*ec_seq[0]))
+  {
+    start_K = 1;
+    shared_apart = shared_is_linear(data, *ec_seq[0]);
+    if (shared_apart)
+      score_shared(data, base, *ec_seq[0], count, stride, shared_scores);
+    else
+      for (uint32_t k=1; k<K; k++)
+        LabelDict::add_example_namespaces_from_example(*ec_seq[k], *ec_seq[0]);
+  }
+
+  for (uint32_t k=start_K; k<K; k++)
+  {
+    make_multi_prediction(data, base, *ec_seq[k], count, stride, scores);
+    for (size_t c = 0; c < count; c++)
+      pred[c].a_s.push_back({k - start_K, scores[c].scalar + shared_scores[c].scalar});
+  }
+  for (size_t c = 0; c < count; c++)
+    qsort((void*) pred[c].a_s.begin(), pred[c].a_s.size(), sizeof(action_score), score_comp);
+
+  if (start_K > 0 && !shared_apart)
+    for (size_t k=1; k<K; k++)
+      LabelDict::del_example_namespaces_from_example(*ec_seq[k], *ec_seq[0]);
+}
+
 void global_print_newline(vw& all)
 {
   char temp[1];
@@ -756,6 +931,8 @@ void finish(ldf& data)
   LabelDict::free_label_features(data.label_features);
   data.a_s.delete_v();
   data.stored_preds.delete_v();
+  data.shared_scores.delete_v();
+  data.scores.delete_v();
 }
 
 /*
@@ -877,7 +1054,12 @@ base_learner* csldf_setup(arguments& arg)
     pred_type = prediction_type::multiclass;
 
   ld->read_example_this_loop = 0;
-  learner<ldf,multi_ex>& l = init_learner(ld, as_singleline(setup_base(arg)), do_actual_learning<true>, do_actual_learning<false>, 1, pred_type);
+  single_learner* base = as_singleline(setup_base(arg));
+  ld->linear = base == arg.all->scorer && GD::is_linear(*base->get_base());
+  ld->raw_multipredict = ld->linear && (arg.vm.count("link") == 0 || arg.vm["link"].as<string>() == "identity");
+  learner<ldf,multi_ex>& l = init_learner(ld, base, do_actual_learning<true>, do_actual_learning<false>, 1, pred_type);
+  if (pred_type == prediction_type::action_scores)
+    l.set_multipredict(multipredict);
   l.set_finish_example(finish_multiline_example);
   l.set_finish(finish);
   l.set_end_pass(end_pass);
@@ -0,0 +1,449 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+ */
+#include <string.h>
+#include <errno.h>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+#include "daemon_server.h"
+#include "weight_snapshot.h"
+#include "vw.h"
+#include "vw_exception.h"
+
+using namespace std;
+
+latency_histogram::latency_histogram()
+{
+  memset(_counts, 0, sizeof(_counts));
+  _count = 0;
+  _max = 0;
+}
+
+static size_t bucket(uint64_t v)
+{
+  if (v < 8)
+    return (size_t)v;
+  size_t msb = 3;
+  while (v >> (msb + 1))
+    msb++;
+  return (msb - 2) * 8 + (size_t)((v >> (msb - 3)) & 7);
+}
+
+static uint64_t bucket_low(size_t i)
+{
+  if (i < 8)
+    return i;
+  return (uint64_t)(8 + i % 8) << (i / 8 - 1);
+}
+
+static uint64_t bucket_width(size_t i) { return i < 16 ? 1 : (uint64_t)1 << (i / 8 - 1); }
+
+void latency_histogram::add(uint64_t nanoseconds)
+{
+  _counts[bucket(nanoseconds)]++;
+  _count++;
+  if (nanoseconds > _max)
+    _max = nanoseconds;
+}
+
+void latency_histogram::merge(const latency_histogram& other)
+{
+  for (size_t i = 0; i < buckets; i++)
+    _counts[i] += other._counts[i];
+  _count += other._count;
+  if (other._max > _max)
+    _max = other._max;
+}
+
+uint64_t latency_histogram::percentile(double p) const
+{
+  if (_count == 0)
+    return 0;
+  uint64_t rank = (uint64_t)(p * _count + 0.5);
+  if (rank < 1)
+    rank = 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets; i++)
+  {
+    seen += _counts[i];
+    if (seen >= rank)
+    {
+      uint64_t mid = bucket_low(i) + bucket_width(i) / 2;
+      return mid < _max ? mid : _max;
+    }
+  }
+  return _max;
+}
+
+#ifdef __linux__
+/* Every thread has its own reduction stack (VW::seed_learner) over all's weights and waits on one
+** epoll instance for a connection with input.  Connections are registered one shot, so a connection
+** is served by one thread at a time and its requests are answered in order: the thread reads what
+** is there, answers every whole request (a line, or for multiline reductions the lines up to an
+** empty one) and rearms the connection.  The predictions are written to the connection as
+** finish_example prints them.  A request's latency runs from reading its last byte to answering it.
+**
+** With --snapshot_interval, a request with a label is learned from, one at a time, on all's weights
+** and the others are predicted on the weight snapshot published last; every snapshot_interval
+** requests learned the weights are published again.
+*/
+
+static volatile sig_atomic_t stop_serving = 0;
+
+static void handle_stop(int) { stop_serving = 1; }
+
+// a connection whose input has no end of request within this many bytes is closed
+const size_t max_pending = 4 << 20;
+
+struct connection
+{
+  int fd;
+  size_t id;
+  string pending; // input not yet making up a whole request
+  latency_histogram latency;
+};
+
+struct daemon_server
+{
+  vw* all;
+  int epoll_fd;
+  int listen_fd;
+
+  weight_snapshots* snapshots; // nullptr when predicting only, on all's weights
+  mutex learn_lock; // protects learning on all's weights and publishing them
+  size_t learned;
+
+  mutex lock; // protects everything below, all's trace_message and the shared_data every learner reports to
+  size_t accepted;
+  set<connection*> open;
+  latency_histogram total;
+};
+
+static uint64_t now_ns()
+{
+  return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void arm(daemon_server& s, int op, int fd, void* data)
+{
+  epoll_event ev;
+  ev.events = EPOLLIN | EPOLLONESHOT;
+  ev.data.ptr = data;
+  if (epoll_ctl(s.epoll_fd, op, fd, &ev) < 0)
+    THROWERRNO("epoll_ctl");
+}
+
+static void report(ostream& out, const latency_histogram& h)
+{
+  out << h.count() << " requests, latency us p50 " << h.percentile(0.5) / 1000. << " p90 " << h.percentile(0.9) / 1000.
+      << " p99 " << h.percentile(0.99) / 1000. << " max " << h.max() / 1000. << endl;
+}
+
+static void accept_connections(daemon_server& s)
+{
+  while (true)
+  {
+    int fd = accept4(s.listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0)
+    {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && !s.all->quiet)
+      {
+        lock_guard<mutex> guard(s.lock);
+        s.all->opts_n_args.trace_message << "accept: " << strerror(errno) << endl;
+      }
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (char*)&on, sizeof(on));
+    connection* c = new connection;
+    c->fd = fd;
+    {
+      lock_guard<mutex> guard(s.lock);
+      c->id = s.accepted++;
+      s.open.insert(c);
+    }
+    arm(s, EPOLL_CTL_ADD, fd, c);
+  }
+  arm(s, EPOLL_CTL_MOD, s.listen_fd, nullptr);
+}
+
+static void close_connection(daemon_server& s, connection* c)
+{
+  epoll_ctl(s.epoll_fd, EPOLL_CTL_DEL, c->fd, nullptr);
+  close(c->fd);
+  {
+    lock_guard<mutex> guard(s.lock);
+    s.open.erase(c);
+    s.total.merge(c->latency);
+    if (!s.all->quiet)
+    {
+      s.all->opts_n_args.trace_message << "connection " << c->id << ": ";
+      report(s.all->opts_n_args.trace_message, c->latency);
+    }
+  }
+  delete c;
+}
+
+static bool labeled(vw& learner, example& ec) { return !learner.p->lp.test_label(&ec.l); }
+
+static bool labeled(vw& learner, multi_ex& ec_seq)
+{
+  for (example* ec : ec_seq)
+    if (labeled(learner, *ec))
+      return true;
+  return false;
+}
+
+// the seeded learners share all's sd: the loss sums and progress lines finish_example updates
+template <class E>
+static void finish(daemon_server& s, vw& learner, E& ec)
+{
+  lock_guard<mutex> guard(s.lock);
+  learner.finish_example(ec);
+}
+
+// predicts, or learns with --snapshot_interval, and writes the prediction out
+template <class E>
+static void respond(daemon_server& s, vw& learner, E& ec)
+{
+  if (s.snapshots == nullptr)
+  {
+    learner.predict(ec);
+    finish(s, learner, ec);
+    return;
+  }
+
+  if (labeled(learner, ec))
+  {
+    lock_guard<mutex> guard(s.learn_lock);
+    learner.weights.dense_weights.shallow_copy(s.all->weights.dense_weights);
+    learner.learn(ec);
+    if (++s.learned % s.all->snapshot_interval == 0)
+      s.snapshots->publish(s.all->weights.dense_weights);
+  }
+  else
+  {
+    weight_snapshots::generation weights = s.snapshots->acquire();
+    learner.weights.dense_weights.shallow_copy(*weights);
+    learner.predict(ec);
+  }
+  finish(s, learner, ec);
+}
+
+// the lines from begin up to the empty line at end, one example each
+static void answer_multiline(daemon_server& s, vw& learner, string& pending, size_t begin, size_t end)
+{
+  multi_ex ec_seq;
+  try
+  {
+    while (begin < end)
+    {
+      size_t line_end = pending.find('\n', begin);
+      pending[line_end] = '\0';
+      if (ec_seq.size() + 2 >= learner.p->ring_size)
+        THROW("a multiline request of more examples than --ring_size holds");
+      ec_seq.push_back(VW::read_example(learner, &pending[begin]));
+      begin = line_end + 1;
+    }
+    respond(s, learner, ec_seq);
+  }
+  catch (...)
+  {
+    VW::finish_example(learner, ec_seq);
+    throw;
+  }
+  VW::finish_example(learner, ec_seq);
+}
+
+// answers the whole requests in c.pending and drops them from it
+static void answer(daemon_server& s, vw& learner, connection& c, uint64_t received)
+{
+  string& pending = c.pending;
+  size_t begin = 0;
+  size_t line = 0;
+  size_t end;
+  while ((end = pending.find('\n', line)) != string::npos)
+  {
+    if (end > line && pending[end - 1] == '\r')
+      pending[end - 1] = ' ';
+    if (!learner.l->is_multiline)
+    {
+      if (end > line)
+      {
+        pending[end] = '\0';
+        example* ec = VW::read_example(learner, &pending[line]);
+        respond(s, learner, *ec);
+        c.latency.add(now_ns() - received);
+      }
+      begin = end + 1;
+    }
+    else if (end == line)
+    {
+      if (line > begin)
+      {
+        answer_multiline(s, learner, pending, begin, line);
+        c.latency.add(now_ns() - received);
+      }
+      begin = end + 1;
+    }
+    line = end + 1;
+  }
+  pending.erase(0, begin);
+}
+
+// false once the connection is to be closed
+static bool serve_connection(daemon_server& s, vw& learner, connection& c)
+{
+  char buffer[1 << 16];
+  learner.final_prediction_sink.push_back(c.fd);
+  bool open = true;
+  try
+  {
+    while (true)
+    {
+      ssize_t n = recv(c.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+      if (n > 0)
+      {
+        c.pending.append(buffer, n);
+        answer(s, learner, c, now_ns());
+        if (c.pending.size() > max_pending)
+          THROW("no end of request within " << max_pending << " bytes");
+        continue;
+      }
+      if (n < 0 && errno == EINTR)
+        continue;
+      open = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+      break;
+    }
+  }
+  catch (exception& e)
+  {
+    string error = string("error: ") + e.what() + "\n";
+    send(c.fd, error.data(), error.size(), MSG_NOSIGNAL | MSG_DONTWAIT); // best effort, closed either way
+    lock_guard<mutex> guard(s.lock);
+    s.all->opts_n_args.trace_message << "connection " << c.id << ": " << e.what() << endl;
+    open = false;
+  }
+  learner.final_prediction_sink.clear();
+  return open;
+}
+
+static void serve(daemon_server& s, vw& learner)
+{
+  while (!stop_serving)
+  {
+    epoll_event ev;
+    int n = epoll_wait(s.epoll_fd, &ev, 1, 100);
+    if (n <= 0)
+      continue;
+    if (ev.data.ptr == nullptr)
+      accept_connections(s);
+    else
+    {
+      connection* c = (connection*)ev.data.ptr;
+      if (serve_connection(s, learner, *c))
+        arm(s, EPOLL_CTL_MOD, c->fd, c);
+      else
+        close_connection(s, c);
+    }
+  }
+}
+
+void serve_daemon_threads(vw& all)
+{
+  daemon_server s;
+  s.all = &all;
+  s.listen_fd = all.p->bound_sock;
+  s.accepted = 0;
+  s.learned = 0;
+  s.snapshots = nullptr;
+  if (all.snapshot_interval > 0 && all.training)
+  {
+    if (all.weights.sparse)
+      THROW("--snapshot_interval works on dense weights only, not with --sparse_weights");
+    s.snapshots = new weight_snapshots(all.weights.dense_weights, all.snapshot_generations);
+  }
+
+  int flags = fcntl(s.listen_fd, F_GETFL, 0);
+  if (flags < 0 || fcntl(s.listen_fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    THROWERRNO("fcntl");
+  s.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (s.epoll_fd < 0)
+    THROWERRNO("epoll_create1");
+  arm(s, EPOLL_CTL_ADD, s.listen_fd, nullptr);
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = handle_stop;
+  sigaction(SIGTERM, &sa, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  vector<vw*> learners;
+  for (size_t i = 0; i < all.daemon_threads; i++)
+  {
+    vw* learner = VW::seed_learner(all);
+    learner->final_prediction_sink.clear();
+    learner->raw_prediction = -1;
+    learners.push_back(learner);
+  }
+  if (!all.quiet)
+  {
+    all.opts_n_args.trace_message << "serving connections from " << all.daemon_threads << " threads";
+    if (s.snapshots != nullptr)
+      all.opts_n_args.trace_message << ", publishing the weights every " << all.snapshot_interval
+                                    << " examples learned";
+    all.opts_n_args.trace_message << endl;
+  }
+
+  vector<thread> threads;
+  for (vw* learner : learners)
+    threads.push_back(thread(serve, ref(s), ref(*learner)));
+  for (thread& t : threads)
+    t.join();
+
+  while (!s.open.empty())
+    close_connection(s, *s.open.begin());
+  close(s.epoll_fd);
+  if (!all.quiet)
+  {
+    all.opts_n_args.trace_message << "served " << s.accepted << " connections, ";
+    report(all.opts_n_args.trace_message, s.total);
+    if (s.snapshots != nullptr)
+      all.opts_n_args.trace_message << "learned from " << s.learned << " requests, published the weights "
+                                    << s.snapshots->published() << " times (" << s.snapshots->skipped()
+                                    << " skipped while every snapshot was read) into "
+                                    << s.snapshots->generations() << " snapshots" << endl;
+  }
+  for (vw* learner : learners)
+  {
+    // back on all's weights, which outlive the snapshots
+    if (s.snapshots != nullptr)
+      learner->weights.dense_weights.shallow_copy(all.weights.dense_weights);
+    VW::finish_learner(*learner);
+  }
+  delete s.snapshots;
+}
+#else
+void serve_daemon_threads(vw&)
+{
+  THROW("--daemon_threads is only supported on Linux");
+}
+#endif
@@ -0,0 +1,35 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "global_data.h"
+
+// Request latencies in log-linear buckets, 8 to a power of two, so within 12.5% of the true value.
+class latency_histogram
+{
+public:
+  latency_histogram();
+
+  void add(uint64_t nanoseconds);
+  void merge(const latency_histogram& other);
+
+  uint64_t count() const { return _count; }
+  uint64_t max() const { return _max; }
+  // the latency p (in [0,1]) of the requests took at most, in nanoseconds
+  uint64_t percentile(double p) const;
+
+  static const size_t buckets = 496;
+
+private:
+  uint64_t _counts[buckets];
+  uint64_t _count;
+  uint64_t _max;
+};
+
+// --daemon_threads: serves the daemon's connections from threads of this process instead of
+// forked children, until SIGTERM.
+void serve_daemon_threads(vw& all);
@@ -0,0 +1,105 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#include <string.h>
+#include "delimiter_scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VW_SCAN_SIMD
+#include <immintrin.h>
+#endif
+
+namespace delimiter_scan
+{
+inline bool is_delimiter(char c) { return c == ' ' || c == '\t' || c == '|' || c == ':' || c == '\r'; }
+
+static uint64_t scan_scalar(const char* p, const char* end)
+{
+  size_t n = end - p < 64 ? end - p : 64;
+  uint64_t bits = 0;
+  for (size_t i = 0; i < n; i++)
+    if (is_delimiter(p[i]))
+      bits |= 1ULL << i;
+  return bits;
+}
+
+#ifdef VW_SCAN_SIMD
+// the last block of a line is copied out, so the loads never reach past the end of the buffer;
+// zero bytes are not delimiters
+inline const char* whole_block(const char* p, const char* end, char* copy)
+{
+  if (end - p >= 64)
+    return p;
+  memset(copy, 0, 64);
+  memcpy(copy, p, end - p);
+  return copy;
+}
+
+static uint64_t scan_sse2(const char* p, const char* end)
+{
+  char copy[64];
+  p = whole_block(p, end, copy);
+  uint64_t bits = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    __m128i c = _mm_loadu_si128((const __m128i*)(p + 16 * i));
+    __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\t'))),
+                                 _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('|')), _mm_cmpeq_epi8(c, _mm_set1_epi8(':'))));
+    found = _mm_or_si128(found, _mm_cmpeq_epi8(c, _mm_set1_epi8('\r')));
+    bits |= (uint64_t)(uint16_t)_mm_movemask_epi8(found) << (16 * i);
+  }
+  return bits;
+}
+
+__attribute__((target("avx2")))
+static uint64_t scan_avx2(const char* p, const char* end)
+{
+  char copy[64];
+  p = whole_block(p, end, copy);
+  uint64_t bits = 0;
+  for (int i = 0; i < 2; i++)
+  {
+    __m256i c = _mm256_loadu_si256((const __m256i*)(p + 32 * i));
+    __m256i found = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\t'))),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('|')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8(':'))));
+    found = _mm256_or_si256(found, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\r')));
+    bits |= (uint64_t)(uint32_t)_mm256_movemask_epi8(found) << (32 * i);
+  }
+  return bits;
+}
+
+// a masked load does not fault on the bytes it leaves out, so the last block needs no copy
+__attribute__((target("avx512f,avx512bw")))
+static uint64_t scan_avx512(const char* p, const char* end)
+{
+  __mmask64 valid = end - p >= 64 ? ~0ULL : (1ULL << (end - p)) - 1;
+  __m512i c = _mm512_maskz_loadu_epi8(valid, p);
+  __mmask64 found = _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8(' ')) | _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('\t'))
+                    | _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('|')) | _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8(':'))
+                    | _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('\r'));
+  return found & valid;
+}
+#endif
+
+std::vector<named_kernel> kernels()
+{
+  std::vector<named_kernel> available = { { "scalar", scan_scalar } };
+#ifdef VW_SCAN_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2"))
+    available.push_back({ "sse2", scan_sse2 });
+  if (__builtin_cpu_supports("avx2"))
+    available.push_back({ "avx2", scan_avx2 });
+  if (__builtin_cpu_supports("avx512bw"))
+    available.push_back({ "avx512bw", scan_avx512 });
+#endif
+  return available;
+}
+
+// the widest
+static scan_kernel pick_scan() { return kernels().back().scan; }
+
+scan_kernel scan_block = pick_scan();
+}
@@ -0,0 +1,80 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/* Finds the ends of names in a line of the text format: the first ' ', '\t', '|', ':' or '\r'.
+** Lines are scanned 64 bytes at a time into a bitmask of the delimiters among them, so a name
+** costs a count of trailing zeros rather than a comparison per byte.  The instruction set is
+** chosen once, at startup: AVX-512BW, AVX2, SSE2 or a plain loop.
+*/
+namespace delimiter_scan
+{
+typedef uint64_t (*scan_kernel)(const char* p, const char* end);
+
+// bit i set when p[i] (p + i < end) is a delimiter, for i < 64; never reads at or past end
+extern scan_kernel scan_block;
+
+struct named_kernel
+{ const char* name;
+  scan_kernel scan;
+};
+
+// the kernels of this build this CPU can run, the plain loop first; scan_block is one of them
+std::vector<named_kernel> kernels();
+
+inline size_t lowest_bit(uint64_t bits)
+{
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanForward64(&i, bits);
+  return i;
+#else
+  return __builtin_ctzll(bits);
+#endif
+}
+
+class scanner
+{
+  const char* block; // what bits describes: the delimiters of [block, block + 64)
+  uint64_t bits;
+  const char* end;
+
+public:
+  scanner() : block(nullptr), bits(0), end(nullptr) {}
+
+  void start(const char* begin, const char* end)
+  {
+    this->end = end;
+    block = begin;
+    bits = begin < end ? scan_block(begin, end) : 0;
+  }
+
+  // the first delimiter at or after from, or the end of the line
+  inline char* next(char* from)
+  {
+    while (true)
+    {
+      if (from >= block && from < block + 64)
+      {
+        uint64_t rest = bits & (~0ULL << (from - block));
+        if (rest != 0)
+          return (char*)block + lowest_bit(rest);
+        from = (char*)block + 64;
+      }
+      if (from >= end)
+        return (char*)end;
+      block = from;
+      bits = scan_block(from, end);
+    }
+  }
+};
+}
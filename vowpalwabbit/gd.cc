@@ -136,7 +136,20 @@ void train(gd& g, example& ec, float update)
 {
   if (normalized)
     update *= g.update_multiplier;
-  foreach_feature<float, update_feature<sqrt_rate, feature_mask_off, adaptive, normalized, spare> >(*g.all, ec, update);
+
+  vw& all = *g.all;
+  if (all.weights.sparse)
+  {
+    foreach_feature<float, update_feature<sqrt_rate, feature_mask_off, adaptive, normalized, spare> >(all, ec, update);
+    return;
+  }
+
+  // dense weights update the linear terms a namespace at a time
+  dense_parameters& weights = all.weights.dense_weights;
+  for (example_predict::iterator i = ec.begin(); i != ec.end(); ++i)
+    if (!all.ignore_some_linear || !all.ignore_linear[i.index()])
+      dense_update(weights, *i, ec.ft_offset, update, spare, feature_mask_off);
+  generate_interactions<float, float&, update_feature<sqrt_rate, feature_mask_off, adaptive, normalized, spare>, dense_parameters>(all.interactions, all.permutations, ec, update, weights);
 }
 
 void end_pass(gd& g)
@@ -388,6 +401,11 @@ void predict(gd& g, base_learner&, example& ec)
     print_audit_features(all, ec);
 }
 
+bool is_linear(base_learner& l)
+{
+  return l.predicts_with(predict<false, false>) || l.predicts_with(predict<true, false>);
+}
+
 template <class T> inline void vec_add_trunc_multipredict(multipredict_info<T>& mp, const float fx, uint64_t fi)
 {
   size_t index = fi;
@@ -24,6 +24,9 @@ float finalize_prediction(shared_data* sd, float ret);
 void print_audit_features(vw&, example& ec);
 void save_load_regressor(vw& all, io_buf& model_file, bool read, bool text);
 void save_load_online_state(vw& all, io_buf& model_file, bool read, bool text, GD::gd *g = nullptr);
+// true when l is a gd learner predicting without audit: its partial prediction is a sum over the
+// features of the example, so the namespaces of an example may be scored apart and added up
+bool is_linear(LEARNER::base_learner& l);
 
  template <class T>
    struct multipredict_info { size_t count; size_t step; polyprediction* pred; const T& weights; /* & for l1: */ float gravity; };
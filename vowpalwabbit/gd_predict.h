@@ -7,6 +7,7 @@ license as described in the file LICENSE.
 
 #include "interactions_predict.h"
 #include "v_array.h"
+#include "gd_simd.h"
 
 namespace GD
 {
@@ -18,22 +19,61 @@ namespace GD
       T(dat, mult*f.value(), f.index() + offset);
   }
 
+  using INTERACTIONS::prefetch_distance;
+  using INTERACTIONS::prefetch_weight;
+
   // iterate through one namespace (or its part), callback function T(some_data_R, feature_value_x, feature_weight)
   template <class R, void(*T)(R&, const float, float&), class W>
   inline void foreach_feature(W& weights, features& fs, R& dat, uint64_t offset = 0, float mult = 1.)
   {
-    for (features::iterator& f : fs)
-      T(dat, mult*f.value(), weights[(f.index() + offset)]);
+    const uint32_t distance = prefetch_distance(weights);
+    if (distance == 0)
+    {
+      for (features::iterator& f : fs)
+        T(dat, mult*f.value(), weights[(f.index() + offset)]);
+      return;
+    }
+
+    const feature_index* indices = fs.indicies.begin();
+    const size_t n = fs.size();
+    size_t i = 0;
+    for (; i + distance < n; ++i)
+    {
+      prefetch_weight(weights, indices[i + distance] + offset);
+      T(dat, mult*fs.values[i], weights[(indices[i] + offset)]);
+    }
+    for (; i < n; ++i)
+      T(dat, mult*fs.values[i], weights[(indices[i] + offset)]);
   }
 
   // iterate through one namespace (or its part), callback function T(some_data_R, feature_value_x, feature_weight)
   template <class R, void(*T)(R&, const float, const float&), class W>
   inline void foreach_feature(const W& weights, features& fs, R& dat, uint64_t offset = 0, float mult = 1.)
   {
-    for (features::iterator& f : fs)
+    const uint32_t distance = prefetch_distance(weights);
+    if (distance == 0)
+    {
+      for (features::iterator& f : fs)
+      {
+        const weight& w = weights[(f.index() + offset)];
+        T(dat, mult*f.value(), w);
+      }
+      return;
+    }
+
+    const feature_index* indices = fs.indicies.begin();
+    const size_t n = fs.size();
+    size_t i = 0;
+    for (; i + distance < n; ++i)
+    {
+      prefetch_weight(weights, indices[i + distance] + offset);
+      const weight& w = weights[(indices[i] + offset)];
+      T(dat, mult*fs.values[i], w);
+    }
+    for (; i < n; ++i)
     {
-      const weight& w = weights[(f.index() + offset)];
-      T(dat, mult*f.value(), w);
+      const weight& w = weights[(indices[i] + offset)];
+      T(dat, mult*fs.values[i], w);
     }
   }
 
@@ -70,10 +110,27 @@ namespace GD
 
   inline void vec_add(float& p, const float fx, const float& fw) { p += fw * fx; }
 
+  template <class W>
+  inline void linear_predict(W& weights, features& fs, uint64_t offset, float& p)
+  {
+    foreach_feature<float, vec_add, W>(weights, fs, p, offset);
+  }
+
+  // dense weights take a whole namespace at a time
+  inline void linear_predict(dense_parameters& weights, features& fs, uint64_t offset, float& p)
+  {
+    dense_dot(weights, fs, offset, p);
+  }
+
   template <class W>
   inline float inline_predict(W& weights, bool ignore_some_linear, bool ignore_linear[256], std::vector<std::string>& interactions, bool permutations, example_predict& ec, float initial = 0.f)
   {
-    foreach_feature<float, const float&, vec_add, W>(weights, ignore_some_linear, ignore_linear, interactions, permutations, ec, initial);
+    uint64_t offset = ec.ft_offset;
+    for (example_predict::iterator i = ec.begin(); i != ec.end(); ++i)
+      if (!ignore_some_linear || !ignore_linear[i.index()])
+        linear_predict(weights, *i, offset, initial);
+
+    generate_interactions<float, const float&, vec_add, W>(interactions, permutations, ec, initial, weights);
     return initial;
   }
 }
@@ -0,0 +1,217 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#include "gd_simd.h"
+#include "array_parameters.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VW_GD_SIMD
+#include <immintrin.h>
+#endif
+
+namespace GD
+{
+// requests the weights of features [i + distance, i + distance + count), see --prefetch_distance
+inline void prefetch_ahead(dense_parameters& weights, const uint64_t* indices, size_t n, uint64_t offset, size_t distance, size_t i, size_t count)
+{
+  if (distance == 0)
+    return;
+  size_t end = i + distance + count < n ? i + distance + count : n;
+  for (size_t j = i + distance; j < end; j++)
+    weights.prefetch(indices[j] + offset);
+}
+
+static void dot_scalar(dense_parameters& weights, features& fs, uint64_t offset, float& p)
+{
+  const uint64_t* indices = fs.indicies.begin();
+  const float* values = fs.values.begin();
+  size_t n = fs.size();
+  size_t distance = weights.prefetch_distance();
+  for (size_t i = 0; i < n; i++)
+  {
+    prefetch_ahead(weights, indices, n, offset, distance, i, 1);
+    p += weights[indices[i] + offset] * values[i];
+  }
+}
+
+// update_feature for a single feature
+inline void update_one(dense_parameters& weights, uint64_t index, float x, float update, size_t spare, bool feature_mask_off)
+{
+  weight* w = &weights[index];
+  if (feature_mask_off || *w != 0.)
+  {
+    if (spare != 0)
+      x *= w[spare];
+    w[0] += update * x;
+  }
+}
+
+static void update_scalar(dense_parameters& weights, features& fs, uint64_t offset, float update, size_t spare, bool feature_mask_off)
+{
+  const uint64_t* indices = fs.indicies.begin();
+  const float* values = fs.values.begin();
+  size_t n = fs.size();
+  size_t distance = weights.prefetch_distance();
+  for (size_t i = 0; i < n; i++)
+  {
+    prefetch_ahead(weights, indices, n, offset, distance, i, 1);
+    update_one(weights, indices[i] + offset, values[i], update, spare, feature_mask_off);
+  }
+}
+
+#ifdef VW_GD_SIMD
+__attribute__((target("avx2")))
+static void dot_avx2(dense_parameters& weights, features& fs, uint64_t offset, float& p)
+{
+  const float* base = weights.first();
+  const uint64_t* indices = fs.indicies.begin();
+  const float* values = fs.values.begin();
+  size_t n = fs.size();
+  __m256i off = _mm256_set1_epi64x((int64_t)offset);
+  __m256i mask = _mm256_set1_epi64x((int64_t)weights.mask());
+
+  size_t distance = weights.prefetch_distance();
+
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    prefetch_ahead(weights, indices, n, offset, distance, i, 8);
+    __m256i idx0 = _mm256_and_si256(_mm256_add_epi64(_mm256_loadu_si256((const __m256i*)(indices + i)), off), mask);
+    __m256i idx1 = _mm256_and_si256(_mm256_add_epi64(_mm256_loadu_si256((const __m256i*)(indices + i + 4)), off), mask);
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm256_i64gather_ps(base, idx0, 4), _mm_loadu_ps(values + i)));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm256_i64gather_ps(base, idx1, 4), _mm_loadu_ps(values + i + 4)));
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+  float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < n; i++)
+    sum += weights[indices[i] + offset] * values[i];
+  p += sum;
+}
+
+// all eight lanes gathered over zeros, not over the undefined vector of _mm512_i64gather_ps that -Wall flags
+__attribute__((target("avx512f")))
+static inline __m256 gather8(const float* base, __m512i idx)
+{
+  return _mm512_mask_i64gather_ps(_mm256_setzero_ps(), 0xff, idx, base, 4);
+}
+
+__attribute__((target("avx512f")))
+static void dot_avx512(dense_parameters& weights, features& fs, uint64_t offset, float& p)
+{
+  const float* base = weights.first();
+  const uint64_t* indices = fs.indicies.begin();
+  const float* values = fs.values.begin();
+  size_t n = fs.size();
+  __m512i off = _mm512_set1_epi64((int64_t)offset);
+  __m512i mask = _mm512_set1_epi64((int64_t)weights.mask());
+
+  size_t distance = weights.prefetch_distance();
+
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    prefetch_ahead(weights, indices, n, offset, distance, i, 16);
+    __m512i idx0 = _mm512_and_si512(_mm512_add_epi64(_mm512_loadu_si512(indices + i), off), mask);
+    __m512i idx1 = _mm512_and_si512(_mm512_add_epi64(_mm512_loadu_si512(indices + i + 8), off), mask);
+    acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(gather8(base, idx0), _mm256_loadu_ps(values + i)));
+    acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(gather8(base, idx1), _mm256_loadu_ps(values + i + 8)));
+  }
+  float lanes[8];
+  _mm256_storeu_ps(lanes, _mm256_add_ps(acc0, acc1));
+  float sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+  for (; i < n; i++)
+    sum += weights[indices[i] + offset] * values[i];
+  p += sum;
+}
+
+// no fused multiply-add: the weights must round exactly as update_one would leave them
+__attribute__((target("avx512f,avx512cd"), optimize("fp-contract=off")))
+static void update_avx512(dense_parameters& weights, features& fs, uint64_t offset, float update, size_t spare, bool feature_mask_off)
+{
+  float* base = weights.first();
+  const uint64_t* indices = fs.indicies.begin();
+  const float* values = fs.values.begin();
+  size_t n = fs.size();
+  __m512i off = _mm512_set1_epi64((int64_t)offset);
+  __m512i mask = _mm512_set1_epi64((int64_t)weights.mask());
+  __m512i spare_off = _mm512_set1_epi64((int64_t)spare);
+  __m256 u = _mm256_set1_ps(update);
+  size_t distance = weights.prefetch_distance();
+
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    prefetch_ahead(weights, indices, n, offset, distance, i, 8);
+    __m512i idx = _mm512_and_si512(_mm512_add_epi64(_mm512_loadu_si512(indices + i), off), mask);
+    __m512i conflicts = _mm512_conflict_epi64(idx);
+    if (_mm512_test_epi64_mask(conflicts, conflicts) != 0)
+    { // a weight appears twice among these features, the updates must be applied in order
+      for (size_t j = i; j < i + 8; j++)
+        update_one(weights, indices[j] + offset, values[j], update, spare, feature_mask_off);
+      continue;
+    }
+
+    __m256 w = gather8(base, idx);
+    __m256 x = _mm256_loadu_ps(values + i);
+    if (spare != 0)
+      x = _mm256_mul_ps(x, gather8(base, _mm512_add_epi64(idx, spare_off)));
+    __mmask8 live = 0xff;
+    if (!feature_mask_off)
+      live = (__mmask8)_mm256_movemask_ps(_mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_NEQ_UQ));
+    w = _mm256_add_ps(w, _mm256_mul_ps(u, x));
+    _mm512_mask_i64scatter_ps(base, live, idx, w, 4);
+  }
+  for (; i < n; i++)
+    update_one(weights, indices[i] + offset, values[i], update, spare, feature_mask_off);
+}
+#endif
+
+std::vector<named_dot_kernel> dot_kernels()
+{
+  std::vector<named_dot_kernel> available = { { "scalar", dot_scalar } };
+#ifdef VW_GD_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    available.push_back({ "avx2", dot_avx2 });
+  if (__builtin_cpu_supports("avx512f"))
+    available.push_back({ "avx512", dot_avx512 });
+#endif
+  return available;
+}
+
+std::vector<named_update_kernel> update_kernels()
+{
+  std::vector<named_update_kernel> available = { { "scalar", update_scalar } };
+#ifdef VW_GD_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd"))
+    available.push_back({ "avx512", update_avx512 });
+#endif
+  return available;
+}
+
+// the widest
+static dot_kernel pick_dot() { return dot_kernels().back().dot; }
+
+static update_kernel pick_update() { return update_kernels().back().update; }
+
+static dot_kernel dot = pick_dot();
+static update_kernel update_features = pick_update();
+
+void dense_dot(dense_parameters& weights, features& fs, uint64_t offset, float& p)
+{
+  dot(weights, fs, offset, p);
+}
+
+void dense_update(dense_parameters& weights, features& fs, uint64_t offset, float update, size_t spare, bool feature_mask_off)
+{
+  update_features(weights, fs, offset, update, spare, feature_mask_off);
+}
+}
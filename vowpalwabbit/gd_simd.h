@@ -0,0 +1,45 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#pragma once
+#include <vector>
+#include "feature_group.h"
+
+class dense_parameters;
+
+/* Namespace-at-a-time kernels for dense weights.  The instruction set is chosen once, at
+** startup: AVX-512 (with conflict detection for the update), AVX2 (dot product only) or scalar.
+** The update leaves the weights bit for bit as the scalar loop does.  The vector dot products add
+** up lanes of partial sums and only then add the sum to p, so they round differently from the
+** scalar loop.  Both are within n * FLT_EPSILON * (|p| + sum of |w * x|) of the exact result over
+** n features, so they agree within twice that.
+*/
+namespace GD
+{
+  // p += sum of w * x over fs
+  void dense_dot(dense_parameters& weights, features& fs, uint64_t offset, float& p);
+
+  // w += update * x * w[spare] (the last factor only when spare != 0) over fs, skipping zero
+  // weights unless feature_mask_off; the same arithmetic as update_feature, lane by lane.
+  void dense_update(dense_parameters& weights, features& fs, uint64_t offset, float update, size_t spare, bool feature_mask_off);
+
+  typedef void (*dot_kernel)(dense_parameters& weights, features& fs, uint64_t offset, float& p);
+  typedef void (*update_kernel)(dense_parameters& weights, features& fs, uint64_t offset, float update, size_t spare, bool feature_mask_off);
+
+  struct named_dot_kernel
+  { const char* name;
+    dot_kernel dot;
+  };
+
+  struct named_update_kernel
+  { const char* name;
+    update_kernel update;
+  };
+
+  // the kernels of this build this CPU can run, the scalar loop first; dense_dot and dense_update
+  // use the last
+  std::vector<named_dot_kernel> dot_kernels();
+  std::vector<named_update_kernel> update_kernels();
+}
@@ -236,17 +236,15 @@ void gen_cs_example(cb_to_cs_adf& c, multi_ex& ec_seq, COST_SENSITIVE::label& cs
   }
 }
 
-template<bool is_learn>
-void call_cs_ldf(LEARNER::multi_learner& base, multi_ex& examples, v_array<CB::label>& cb_labels,
-                 COST_SENSITIVE::label& cs_labels, v_array<COST_SENSITIVE::label>& prepped_cs_labels, uint64_t offset, size_t id = 0)
+// stores each example's cb label in cb_labels and hands it its cost sensitive label and offset
+inline uint64_t prep_cs_ldf(multi_ex& examples, v_array<CB::label>& cb_labels, COST_SENSITIVE::label& cs_labels,
+                            v_array<COST_SENSITIVE::label>& prepped_cs_labels, uint64_t offset)
 { cb_labels.clear();
   if (prepped_cs_labels.size() < cs_labels.costs.size()+1)
   { prepped_cs_labels.resize(cs_labels.costs.size()+1);
     prepped_cs_labels.end() = prepped_cs_labels.end_array;
   }
 
-  // 1st: save cb_label (into mydata) and store cs_label for each example, which will be passed into base.learn.
-  // also save offsets
   uint64_t saved_offset = examples[0]->ft_offset;
   size_t index = 0;
   for (auto ec : examples)
@@ -256,20 +254,36 @@ void call_cs_ldf(LEARNER::multi_learner& base, multi_ex& examples, v_array<CB::l
     ec->l.cs = prepped_cs_labels[index++];
     ec->ft_offset = offset;
   }
+  return saved_offset;
+}
+
+inline void restore_cb_labels(multi_ex& examples, v_array<CB::label>& cb_labels, uint64_t saved_offset)
+{ for (size_t i = 0; i < examples.size(); ++i)
+  { examples[i]->l.cb = cb_labels[i];
+    examples[i]->ft_offset = saved_offset;
+  }
+}
+
+template<bool is_learn>
+void call_cs_ldf(LEARNER::multi_learner& base, multi_ex& examples, v_array<CB::label>& cb_labels,
+                 COST_SENSITIVE::label& cs_labels, v_array<COST_SENSITIVE::label>& prepped_cs_labels, uint64_t offset, size_t id = 0)
+{ uint64_t saved_offset = prep_cs_ldf(examples, cb_labels, cs_labels, prepped_cs_labels, offset);
 
-  // 2nd: predict for each ex
-  // // call base.predict for all examples
   if(is_learn)
     base.learn(examples, (int32_t)id);
   else
     base.predict(examples, (int32_t)id);
 
-  // 3rd: restore cb_label for each example
-  // (**ec).l.cb = array.element.
-  // and restore offsets
-  for (size_t i = 0; i < examples.size(); ++i)
-  { examples[i]->l.cb = cb_labels[i];
-    examples[i]->ft_offset = saved_offset;
-  }
+  restore_cb_labels(examples, cb_labels, saved_offset);
+}
+
+// predicts with the policies lo, lo+stride, ..., lo+(count-1)*stride of the csoaa_ldf learner base at
+// once, the ranked action scores under each in pred[c].a_s
+inline void call_cs_ldf_multipredict(LEARNER::multi_learner& base, multi_ex& examples, v_array<CB::label>& cb_labels,
+                                     COST_SENSITIVE::label& cs_labels, v_array<COST_SENSITIVE::label>& prepped_cs_labels,
+                                     uint64_t offset, size_t lo, size_t count, size_t stride, polyprediction* pred)
+{ uint64_t saved_offset = prep_cs_ldf(examples, cb_labels, cs_labels, prepped_cs_labels, offset);
+  base.multipredict(examples, lo, count, pred, false, stride);
+  restore_cb_labels(examples, cb_labels, saved_offset);
 }
 }
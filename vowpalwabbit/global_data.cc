@@ -144,9 +144,15 @@ void vw::learn(example& ec)
     THROW("This reduction does not support single-line examples.");
 
   if (ec.test_only || !training)
+  {
+    perf_timer timer(perf, perf_predict);
     LEARNER::as_singleline(l)->predict(ec);
+  }
   else
+  {
+    perf_timer timer(perf, perf_learn);
     LEARNER::as_singleline(l)->learn(ec);
+  }
 }
 
 void vw::learn(multi_ex& ec)
@@ -155,9 +161,15 @@ void vw::learn(multi_ex& ec)
     THROW("This reduction does not support multi-line example.");
 
   if (!training)
+  {
+    perf_timer timer(perf, perf_predict);
     LEARNER::as_multiline(l)->predict(ec);
+  }
   else
+  {
+    perf_timer timer(perf, perf_learn);
     LEARNER::as_multiline(l)->learn(ec);
+  }
 }
 
 void vw::predict(example& ec)
@@ -165,6 +177,7 @@ void vw::predict(example& ec)
   if (l->is_multiline)
     THROW("This reduction does not support single-line examples.");
 
+  perf_timer timer(perf, perf_predict);
   LEARNER::as_singleline(l)->predict(ec);
 }
 
@@ -173,6 +186,7 @@ void vw::predict(multi_ex& ec)
   if (!l->is_multiline)
     THROW("This reduction does not support multi-line example.");
 
+  perf_timer timer(perf, perf_predict);
   LEARNER::as_multiline(l)->predict(ec);
 }
 
@@ -301,6 +315,9 @@ vw::vw()
   default_bits = true;
   daemon = false;
   num_children = 10;
+  daemon_threads = 0;
+  snapshot_interval = 0;
+  snapshot_generations = 2;
   save_resume = false;
   preserve_performance_counters = false;
 
@@ -323,6 +340,8 @@ vw::vw()
   random_weights = false;
   normal_weights = false;
   tnormal_weights = false;
+  prefetch_distance = 0;
+  pages = small_pages;
   per_feature_regularizer_input = "";
   per_feature_regularizer_output = "";
   per_feature_regularizer_text = "";
@@ -344,6 +363,9 @@ vw::vw()
   initial_constant = 0.0;
 
   all_reduce = nullptr;
+  sync_encoding = SyncEncoding::dense;
+  sync = nullptr;
+  learn_threads = 1;
 
   for (size_t i = 0; i < 256; i++)
   {
@@ -362,6 +384,7 @@ vw::vw()
 
   add_constant = true;
   audit = false;
+  perf = nullptr;
 
   pass_length = (size_t)-1;
   passes_complete = 0;
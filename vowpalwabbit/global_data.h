@@ -30,6 +30,8 @@ namespace po = boost::program_options;
 #include "crossplat_compat.h"
 #include "error_reporting.h"
 #include "parser_helper.h"
+#include "perf_stats.h"
+#include "allreduce_compress.h"
 
 struct version_struct
 { int32_t major;
@@ -417,6 +419,7 @@ enum AllReduceType
 };
 
 class AllReduce;
+struct sync_state;
 
 // avoid name clash
 namespace label_type
@@ -441,6 +444,9 @@ struct vw
 #endif
   AllReduceType all_reduce_type;
   AllReduce* all_reduce;
+  SyncEncoding sync_encoding; // of the weight syncs over a span_server, see accumulate.cc
+  sync_state* sync;
+  size_t learn_threads; // threads learning into the same weights, see LEARNER::generic_driver_learn_threads
 
   LEARNER::base_learner* l;//the top level learner
   LEARNER::single_learner* scorer;//a scoring function
@@ -466,6 +472,9 @@ struct vw
 
   bool daemon;
   size_t num_children;
+  size_t daemon_threads; // serve the daemon's connections from threads rather than children
+  size_t snapshot_interval; // with daemon_threads, examples learned between publishing weight snapshots, 0 for none
+  size_t snapshot_generations; // the most weight snapshots alive at once
 
   bool save_per_pass;
   float initial_weight;
@@ -530,6 +539,8 @@ struct vw
 
   void(*delete_prediction)(void*); bool audit; //should I print lots of debugging information?
   bool quiet;//Should I suppress progress-printing of updates?
+  perf_stats* perf; // per stage timers, null unless --perf_stats
+  std::string perf_stats_json; // where to write them as JSON at the end, if anywhere
   bool training;//Should I train if lable data is available?
   bool active;
   bool adaptive;//Should I use adaptive individual learning rates?
@@ -541,6 +552,8 @@ struct vw
   bool random_positive_weights; // for initialize_regressor w/ new_mf
   bool normal_weights;
   bool tnormal_weights;
+  uint32_t prefetch_distance; // of dense weights, see dense_parameters
+  weight_pages pages; // requested for dense weights, see --huge_pages
   bool add_constant;
   bool nonormalize;
   bool do_reset_source;
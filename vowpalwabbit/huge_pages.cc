@@ -0,0 +1,125 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <stdint.h>
+#endif
+#include "huge_pages.h"
+#include "vw_exception.h"
+
+using namespace std;
+
+weight_pages parse_weight_pages(const string& name)
+{
+  if (name == "transparent")
+    return transparent_pages;
+  if (name == "2M" || name == "2m")
+    return huge_pages_2m;
+  if (name == "1G" || name == "1g")
+    return huge_pages_1g;
+  THROW("huge_pages must be transparent, 2M or 1G, not " << name);
+}
+
+const char* weight_pages_description(weight_pages pages)
+{
+  switch (pages)
+  {
+    case transparent_pages:
+      return "transparent huge pages";
+    case huge_pages_2m:
+      return "2MB huge pages";
+    case huge_pages_1g:
+      return "1GB huge pages";
+    default:
+      return "4KB pages";
+  }
+}
+
+#if defined(__linux__)
+static const size_t two_megabytes = (size_t)1 << 21;
+static const size_t one_gigabyte = (size_t)1 << 30;
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+static size_t round_up(size_t bytes, size_t page) { return (bytes + page - 1) / page * page; }
+
+// mapped is only set on success
+static void* map_hugetlb(size_t bytes, size_t page, int log_page, size_t& mapped)
+{
+  size_t length = round_up(bytes, page);
+  void* data = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log_page << MAP_HUGE_SHIFT), -1, 0);
+  if (data == MAP_FAILED)
+    return nullptr;
+  mapped = length;
+  return data;
+}
+
+// a 2MB aligned mapping the kernel may back with huge pages as they are touched
+static void* map_transparent(size_t bytes, size_t& mapped)
+{
+  size_t length = round_up(bytes, two_megabytes);
+  size_t padded = length + two_megabytes;
+  void* region = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED)
+    return nullptr;
+
+  char* begin = (char*)round_up((size_t)region, two_megabytes);
+  char* end = begin + length;
+  if (begin != region)
+    munmap(region, begin - (char*)region);
+  if (end != (char*)region + padded)
+    munmap(end, (char*)region + padded - end);
+
+#ifdef MADV_HUGEPAGE
+  if (madvise(begin, length, MADV_HUGEPAGE) == 0)
+  {
+    mapped = length;
+    return begin;
+  }
+#endif
+  munmap(begin, length);
+  return nullptr;
+}
+
+void* map_weights(size_t bytes, weight_pages& pages, size_t& mapped)
+{
+  void* data = nullptr;
+  mapped = 0;
+  if (pages == huge_pages_1g)
+  {
+    data = map_hugetlb(bytes, one_gigabyte, 30, mapped);
+    if (data == nullptr)
+      pages = huge_pages_2m;
+  }
+  if (pages == huge_pages_2m)
+  {
+    data = map_hugetlb(bytes, two_megabytes, 21, mapped);
+    if (data == nullptr)
+      pages = transparent_pages;
+  }
+  if (pages == transparent_pages)
+  {
+    data = map_transparent(bytes, mapped);
+    if (data == nullptr)
+      pages = small_pages;
+  }
+  return data;
+}
+
+void unmap_weights(void* data, size_t mapped) { munmap(data, mapped); }
+#else
+void* map_weights(size_t, weight_pages& pages, size_t& mapped)
+{
+  pages = small_pages;
+  mapped = 0;
+  return nullptr;
+}
+
+void unmap_weights(void*, size_t) {}
+#endif
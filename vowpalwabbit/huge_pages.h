@@ -0,0 +1,32 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#pragma once
+#include <stddef.h>
+#include <string>
+
+/* Huge page backing for the dense weight array (--huge_pages).  With 4KB pages every weight
+** touched at -b 28 and beyond is a likely TLB miss; 2MB and 1GB pages cover the table with far
+** fewer TLB entries.
+*/
+enum weight_pages
+{ small_pages,      // calloc, the default
+  transparent_pages, // 2MB aligned anonymous mapping, madvise(MADV_HUGEPAGE)
+  huge_pages_2m,    // MAP_HUGETLB from the 2MB hugetlbfs pool
+  huge_pages_1g     // MAP_HUGETLB from the 1GB hugetlbfs pool
+};
+
+// "transparent", "2M" or "1G"; throws on anything else
+weight_pages parse_weight_pages(const std::string& name);
+
+const char* weight_pages_description(weight_pages pages);
+
+/* Returns a zeroed, mapped array of bytes bytes or nullptr.  pages is the backing requested on
+** entry and the one obtained on return: a 1G request falls back to 2M, 2M to transparent.
+** mapped is the length to hand to unmap_weights, 0 when nullptr is returned.
+*/
+void* map_weights(size_t bytes, weight_pages& pages, size_t& mapped);
+
+void unmap_weights(void* data, size_t mapped);
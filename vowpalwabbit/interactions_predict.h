@@ -10,6 +10,7 @@ license as described in the file LICENSE.
 #include "feature_group.h"
 #include <vector>
 #include <string>
+#include <algorithm>
 
 namespace INTERACTIONS
 {
@@ -45,6 +46,15 @@ namespace INTERACTIONS
     T(dat, ft_value, ft_idx);
   }
 
+  // Weight lookahead: while a feature is processed the weight of the feature prefetch_distance(weights)
+  // positions further on is requested.  Only dense_parameters overload these (array_parameters_dense.h),
+  // for other weight containers the distance is 0 and nothing is prefetched.
+  template <class W>
+  inline uint32_t prefetch_distance(const W& /*weights*/) { return 0; }
+
+  template <class W>
+  inline void prefetch_weight(const W& /*weights*/, uint64_t /*ft_idx*/) {}
+
   // state data used in non-recursive feature generation algorithm
   // contains N feature_gen_data records (where N is length of interaction)
   struct feature_gen_data
@@ -70,25 +80,119 @@ namespace INTERACTIONS
 
   // #define GEN_INTER_LOOP
 
+  // interacts features [begin, end) of the last namespace with the hash and value accumulated so far
   template <class R, class S, void(*T)(R&, float, S), bool audit, void(*audit_func)(R&, const audit_strings*), class W>
-  inline void inner_kernel(R& dat, features::iterator_all& begin, features::iterator_all& end, const uint64_t offset, W& weights, feature_value ft_value, feature_index halfhash)
+  inline void inner_kernel(R& dat, features& fs, size_t begin, size_t end, const uint64_t offset, W& weights, feature_value ft_value, feature_index halfhash)
   {
     if (audit)
     {
-      for (; begin != end; ++begin)
+      for (size_t i = begin; i < end; ++i)
       {
-        audit_func(dat, begin.audit().get());
-        call_T<R, T>(dat, weights, INTERACTION_VALUE(ft_value, begin.value()), (begin.index() ^ halfhash) + offset);
+        audit_func(dat, fs.space_names[i].get());
+        call_T<R, T>(dat, weights, INTERACTION_VALUE(ft_value, fs.values[i]), (fs.indicies[i] ^ halfhash) + offset);
         audit_func(dat, nullptr);
       }
     }
     else
+    { // unrolled by four so that the four weight loads are independent of each other
+      const feature_value* values = fs.values.begin();
+      const feature_index* indices = fs.indicies.begin();
+      const size_t distance = prefetch_distance(weights);
+      size_t i = begin;
+      for (; i + 4 <= end; i += 4)
+      {
+        if (distance > 0 && i + distance + 4 <= end)
+          for (size_t j = i + distance; j < i + distance + 4; ++j)
+            prefetch_weight(weights, (indices[j] ^ halfhash) + offset);
+        const uint64_t idx0 = (indices[i] ^ halfhash) + offset;
+        const uint64_t idx1 = (indices[i + 1] ^ halfhash) + offset;
+        const uint64_t idx2 = (indices[i + 2] ^ halfhash) + offset;
+        const uint64_t idx3 = (indices[i + 3] ^ halfhash) + offset;
+        call_T<R, T>(dat, weights, INTERACTION_VALUE(ft_value, values[i]), idx0);
+        call_T<R, T>(dat, weights, INTERACTION_VALUE(ft_value, values[i + 1]), idx1);
+        call_T<R, T>(dat, weights, INTERACTION_VALUE(ft_value, values[i + 2]), idx2);
+        call_T<R, T>(dat, weights, INTERACTION_VALUE(ft_value, values[i + 3]), idx3);
+      }
+      for (; i < end; ++i)
+        call_T<R, T>(dat, weights, INTERACTION_VALUE(ft_value, values[i]), (indices[i] ^ halfhash) + offset);
+    }
+  }
+
+  // where the inner loop of outer feature i starts: next index differs for permutations and simple combinations
+  inline size_t inner_begin(bool same_namespace, size_t i, feature_value ft_value)
+  {
+    if (!same_namespace) return 0;
+    return (PROCESS_SELF_INTERACTIONS(ft_value)) ? i : i + 1;
+  }
+
+  // The lookahead of inner_kernel stays within its loop, so the first distance weights of each inner
+  // loop are requested by the kernels below while the inner loop before it runs.
+  template <class W>
+  inline void prefetch_inner(W& weights, features& fs, size_t begin, size_t distance, feature_index halfhash, const uint64_t offset)
+  {
+    const size_t end = std::min(begin + distance, fs.indicies.size());
+    for (size_t j = begin; j < end; ++j)
+      prefetch_weight(weights, (fs.indicies[j] ^ halfhash) + offset);
+  }
+
+  // -q ab: the hash of each feature of a is computed once for the whole inner loop over b
+  template <class R, class S, void(*T)(R&, float, S), bool audit, void(*audit_func)(R&, const audit_strings*), class W>
+  inline void quadratic_kernel(R& dat, features& first, features& second, bool same_namespace, const uint64_t offset, W& weights)
+  {
+    const size_t second_end = second.indicies.size();
+    const size_t distance = audit ? 0 : prefetch_distance(weights);
+    if (distance > 0)
+      prefetch_inner(weights, second, inner_begin(same_namespace, 0, first.values[0]), distance,
+                     FNV_prime * (uint64_t)first.indicies[0], offset);
+    for (size_t i = 0; i < first.indicies.size(); ++i)
     {
-      for (; begin != end; ++begin)
-        call_T<R, T>(dat, weights, INTERACTION_VALUE(ft_value, begin.value()), (begin.index() ^ halfhash) + offset);
+      feature_index halfhash = FNV_prime * (uint64_t)first.indicies[i];
+      if (audit) audit_func(dat, first.space_names[i].get());
+      feature_value ft_value = first.values[i];
+      size_t begin = inner_begin(same_namespace, i, ft_value);
+      if (distance > 0 && i + 1 < first.indicies.size())
+        prefetch_inner(weights, second, inner_begin(same_namespace, i + 1, first.values[i + 1]), distance,
+                       FNV_prime * (uint64_t)first.indicies[i + 1], offset);
+
+      inner_kernel<R, S, T, audit, audit_func>(dat, second, begin, second_end, offset, weights, ft_value, halfhash);
+
+      if (audit) audit_func(dat, nullptr);
     }
   }
 
+  // --cubic abc: the hash of a is hoisted out of the loop over b, that of a and b out of the loop over c
+  template <class R, class S, void(*T)(R&, float, S), bool audit, void(*audit_func)(R&, const audit_strings*), class W>
+  inline void cubic_kernel(R& dat, features& first, features& second, features& third, bool same_namespace1, bool same_namespace2, const uint64_t offset, W& weights)
+  {
+    const size_t third_end = third.indicies.size();
+    const size_t distance = audit ? 0 : prefetch_distance(weights);
+    for (size_t i = 0; i < first.indicies.size(); ++i)
+    {
+      if (audit) audit_func(dat, first.space_names[i].get());
+      const uint64_t halfhash1 = FNV_prime * (uint64_t)first.indicies[i];
+      const float first_ft_value = first.values[i];
+      size_t j = inner_begin(same_namespace1, i, first_ft_value);
+      if (distance > 0 && j < second.indicies.size())
+        prefetch_inner(weights, third, inner_begin(same_namespace2, j, INTERACTION_VALUE(first_ft_value, second.values[j])),
+                       distance, FNV_prime * (halfhash1 ^ (uint64_t)second.indicies[j]), offset);
+
+      for (; j < second.indicies.size(); ++j)
+      { //f3 x k*(f2 x k*f1)
+        if (audit) audit_func(dat, second.space_names[j].get());
+        feature_index halfhash = FNV_prime * (halfhash1 ^ (uint64_t)second.indicies[j]);
+        feature_value ft_value = INTERACTION_VALUE(first_ft_value, second.values[j]);
+        size_t begin = inner_begin(same_namespace2, j, ft_value);
+        if (distance > 0 && j + 1 < second.indicies.size())
+          prefetch_inner(weights, third, inner_begin(same_namespace2, j + 1, INTERACTION_VALUE(first_ft_value, second.values[j + 1])),
+                         distance, FNV_prime * (halfhash1 ^ (uint64_t)second.indicies[j + 1]), offset);
+
+        inner_kernel<R, S, T, audit, audit_func>(dat, third, begin, third_end, offset, weights, ft_value, halfhash);
+        if (audit) audit_func(dat, nullptr);
+      } // end for (snd)
+      if (audit) audit_func(dat, nullptr);
+    } // end for (fst)
+  }
+
 
   // this templated function generates new features for given example and set of interactions
   // and passes each of them to given function T()
@@ -132,23 +236,7 @@ namespace INTERACTIONS
           if (second.nonempty())
           {
             const bool same_namespace = (!permutations && (ns[0] == ns[1]));
-
-            for (size_t i = 0; i < first.indicies.size(); ++i)
-            {
-              feature_index halfhash = FNV_prime * (uint64_t)first.indicies[i];
-              if (audit) audit_func(dat, first.space_names[i].get());
-              // next index differs for permutations and simple combinations
-              feature_value ft_value = first.values[i];
-              features::features_value_index_audit_range range = second.values_indices_audit();
-              features::iterator_all begin = range.begin();
-              if (same_namespace)
-                begin += (PROCESS_SELF_INTERACTIONS(ft_value)) ? i : i + 1;
-
-              features::iterator_all end = range.end();
-              inner_kernel<R, S, T, audit, audit_func>(dat, begin, end, offset, weights, ft_value, halfhash);
-
-              if (audit) audit_func(dat, nullptr);
-            } // end for(fst)
+            quadratic_kernel<R, S, T, audit, audit_func>(dat, first, second, same_namespace, offset, weights);
           } // end if (data[snd] size > 0)
         } // end if (data[fst] size > 0)
       }
@@ -165,34 +253,7 @@ namespace INTERACTIONS
             { // don't compare 1 and 3 as interaction is sorted
               const bool same_namespace1 = (!permutations && (ns[0] == ns[1]));
               const bool same_namespace2 = (!permutations && (ns[1] == ns[2]));
-
-              for (size_t i = 0; i < first.indicies.size(); ++i)
-              {
-                if (audit) audit_func(dat, first.space_names[i].get());
-                const uint64_t halfhash1 = FNV_prime * (uint64_t)first.indicies[i];
-                const float& first_ft_value = first.values[i];
-                size_t j = 0;
-                if (same_namespace1) // next index differs for permutations and simple combinations
-                  j = (PROCESS_SELF_INTERACTIONS(first_ft_value)) ? i : i + 1;
-
-                for (; j < second.indicies.size(); ++j)
-                { //f3 x k*(f2 x k*f1)
-                  if (audit) audit_func(dat, second.space_names[j].get());
-                  feature_index halfhash = FNV_prime * (halfhash1 ^ (uint64_t)second.indicies[j]);
-                  feature_value ft_value = INTERACTION_VALUE(first_ft_value, second.values[j]);
-
-                  features::features_value_index_audit_range range = third.values_indices_audit();
-                  features::iterator_all begin = range.begin();
-                  if (same_namespace2) //next index differs for permutations and simple combinations
-                    begin += (PROCESS_SELF_INTERACTIONS(ft_value)) ? j : j + 1;
-
-                  features::iterator_all end = range.end();
-                  inner_kernel<R, S, T, audit, audit_func>(dat, begin, end, offset, weights, ft_value, halfhash);
-                  if (audit) audit_func(dat, nullptr);
-                } // end for (snd)
-                if (audit) audit_func(dat, nullptr);
-              } // end for (fst)
-
+              cubic_kernel<R, S, T, audit, audit_func>(dat, first, second, third, same_namespace1, same_namespace2, offset, weights);
             } // end if (data[thr] size > 0)
           } // end if (data[snd] size > 0)
         } // end if (data[fst] size > 0)
@@ -326,12 +387,7 @@ namespace INTERACTIONS
             feature_value ft_value = fgd2->x;
             feature_index halfhash = fgd2->hash;
 
-            features::features_value_index_audit_range range = fs.values_indices_audit();
-            features::iterator_all begin = range.begin();
-            begin += start_i;
-            features::iterator_all end = range.begin();
-            end += fgd2->loop_end + 1;
-            inner_kernel<R, S, T, audit, audit_func, W>(dat, begin, end, offset, weights, ft_value, halfhash);
+            inner_kernel<R, S, T, audit, audit_func, W>(dat, fs, start_i, fgd2->loop_end + 1, offset, weights, ft_value, halfhash);
 
             // trying to go back increasing loop_idx of each namespace by the way
 
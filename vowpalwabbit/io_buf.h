@@ -19,6 +19,7 @@ license as described in the file LICENSE.
 #include "hash.h"
 #include "vw_exception.h"
 #include "vw_validate.h"
+#include "perf_stats.h"
 
 #ifndef O_LARGEFILE //for OSX
 #define O_LARGEFILE 0
@@ -65,6 +66,8 @@ public:
   bool verify_hash;
   uint32_t hash;
 
+  perf_stats* perf; // times the refills as perf_read when not null, see --perf_stats
+
   static const int READ = 1;
   static const int WRITE = 2;
 
@@ -80,6 +83,7 @@ public:
     head = space.begin();
     verify_hash = false;
     hash = 0;
+    perf = nullptr;
   }
 
   virtual int open_file(const char* name, bool stdin_off, int flag=READ)
@@ -154,7 +158,7 @@ public:
 
   static ssize_t read_file_or_socket(int f, void* buf, size_t nbytes);
 
-  ssize_t fill(int f)
+  virtual ssize_t fill(int f)
   { // if the loaded values have reached the allocated space
     if (space.end_array - space.end() == 0)
     { // reallocate to twice as much space
@@ -163,7 +167,14 @@ public:
       head = space.begin()+head_loc;
     }
     // read more bytes from file up to the remaining allocated space
+    uint64_t start = perf == nullptr ? 0 : perf_stats::now();
     ssize_t num_read = read_file(f, space.end(), space.end_array - space.end());
+    if (perf != nullptr)
+    {
+      perf->add(perf_read, start);
+      if (num_read > 0)
+        perf->add_bytes(num_read);
+    }
     if (num_read >= 0)
     { // if some bytes were actually loaded, update the end of loaded values
       space.end() = space.end() + num_read;
@@ -173,6 +184,14 @@ public:
       return 0;
   }
 
+  // shift the unread values [head, space.end) down to space.begin to make room for fill
+  virtual void compact()
+  { size_t left = space.end() - head;
+    memmove(space.begin(), head, left);
+    head = space.begin();
+    space.end() = space.begin() + left;
+  }
+
   virtual ssize_t write_file(int f, const void* buf, size_t nbytes)
   { return write_file_or_socket(f, buf, nbytes); }
 
@@ -12,6 +12,7 @@ license as described in the file LICENSE.
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <atomic>
 #include "correctedMath.h"
 #include "vw_versions.h"
 #include "vw.h"
@@ -33,6 +34,8 @@ license as described in the file LICENSE.
 #include "rand48.h"
 #include "reductions.h"
 #include "array_parameters.h"
+#include "lda_simd.h"
+#include "worker_pool.h"
 #include <boost/version.hpp>
 
 #if BOOST_VERSION >= 105600
@@ -42,6 +45,23 @@ using namespace std;
 
 enum lda_math_mode { USE_SIMD, USE_PRECISE, USE_FAST_APPROX };
 
+// what each thread works in
+struct lda_scratch
+{
+  v_array<float> new_gamma;
+  v_array<float> old_gamma;
+  v_array<float> Elogtheta;
+  v_array<float> total_new; // its share of the minibatch's topic totals
+
+  void delete_v()
+  {
+    new_gamma.delete_v();
+    old_gamma.delete_v();
+    Elogtheta.delete_v();
+    total_new.delete_v();
+  }
+};
+
 class index_feature
 {
 public:
@@ -59,8 +79,8 @@ struct lda
   float lda_epsilon;
   size_t minibatch;
   lda_math_mode mmode;
+  const ldamath::lda_kernels* wide; // with --math-mode simd on AVX2 or AVX-512, else nullptr
 
-  v_array<float> Elogtheta;
   v_array<float> decay_levels;
   v_array<float> total_new;
   v_array<example *> examples;
@@ -70,6 +90,17 @@ struct lda
   v_array<float> v;
   std::vector<index_feature> sorted_features;
 
+  /* --lda_threads: the documents of a minibatch are independent in the E-step and the words are in
+  ** the topic updates, so both are split over the pool.  Each thread has its own scratch space; the
+  ** per document losses and the per thread topic totals are added up in a fixed order afterwards,
+  ** so a given number of threads always gives the same model.
+  */
+  size_t threads;
+  worker_pool* pool;
+  v_array<lda_scratch> scratch; // one for each thread
+  v_array<float> scores;        // lda_loop of each document of the minibatch
+  v_array<size_t> word_ranges;  // thread i updates the words in sorted_features[word_ranges[i], word_ranges[i+1])
+
   bool compute_coherence_metrics;
 
   // size by 1 << bits
@@ -110,59 +141,6 @@ inline bool is_aligned16(void *ptr)
 
 namespace ldamath
 {
-inline float fastlog2(float x)
-{
-  uint32_t mx;
-  memcpy(&mx, &x, sizeof(uint32_t));
-  mx = (mx & 0x007FFFFF) | (0x7e << 23);
-
-  float mx_f;
-  memcpy(&mx_f, &mx, sizeof(float));
-
-  uint32_t vx;
-  memcpy(&vx, &x, sizeof(uint32_t));
-
-  float y = static_cast<float>(vx);
-  y *= 1.0f / (float)(1 << 23);
-
-  return y - 124.22544637f - 1.498030302f * mx_f - 1.72587999f / (0.3520887068f + mx_f);
-}
-
-inline float fastlog(float x) { return 0.69314718f * fastlog2(x); }
-
-inline float fastpow2(float p)
-{
-  float offset = (p < 0) * 1.0f;
-  float clipp = (p < -126.0) ? -126.0f : p;
-  int w = (int)clipp;
-  float z = clipp - w + offset;
-  uint32_t approx = (uint32_t) ((1 << 23) * (clipp + 121.2740838f + 27.7280233f / (4.84252568f - z) - 1.49012907f * z));
-
-  float v;
-  memcpy(&v, &approx, sizeof(uint32_t));
-  return v;
-}
-
-inline float fastexp(float p) { return fastpow2(1.442695040f * p); }
-
-inline float fastpow(float x, float p) { return fastpow2(p * fastlog2(x)); }
-
-inline float fastlgamma(float x)
-{
-  float logterm = fastlog(x * (1.0f + x) * (2.0f + x));
-  float xp3 = 3.0f + x;
-
-  return -2.081061466f - x + 0.0833333f / xp3 - logterm + (2.5f + x) * fastlog(xp3);
-}
-
-inline float fastdigamma(float x)
-{
-  float twopx = 2.0f + x;
-  float logterm = fastlog(twopx);
-
-  return -(1.0f + 2.0f * x) / (x * (1.0f + x)) - (13.0f + 6.0f * x) / (12.0f * twopx * twopx) + logterm;
-}
-
 #if !defined(VW_NO_INLINE_SIMD)
 
 #if defined(__SSE2__) || defined(__SSE3__) || defined(__SSE4_1__)
@@ -292,12 +270,12 @@ inline v4sf vfastdigamma(v4sf x)
          logterm;
 }
 
-void vexpdigammify(vw &all, float *gamma, const float underflow_threshold)
+void vexpdigammify(float *gamma, size_t topics, const float underflow_threshold)
 {
   float extra_sum = 0.0f;
   v4sf sum = v4sfl(0.0f);
   float *fp;
-  const float *fpend = gamma + all.lda;
+  const float *fpend = gamma + topics;
 
   // Iterate through the initial part of the array that isn't 128-bit SIMD
   // aligned.
@@ -354,11 +332,11 @@ void vexpdigammify(vw &all, float *gamma, const float underflow_threshold)
   }
 }
 
-void vexpdigammify_2(vw &all, float* gamma, const float *norm, const float underflow_threshold)
+void vexpdigammify_2(float* gamma, const float *norm, size_t topics, const float underflow_threshold)
 {
   float *fp = gamma;
   const float *np;
-  const float *fpend = gamma + all.lda;
+  const float *fpend = gamma + topics;
 
   for (np = norm; fp < fpend && !is_aligned16(fp); ++fp, ++np)
     *fp = fmax(underflow_threshold, fastexp(fastdigamma(*fp) - *np));
@@ -453,7 +431,7 @@ template <typename T, const lda_math_mode mtype> inline void expdigammify(vw &al
 template <> inline void expdigammify<float, USE_SIMD>(vw &all, float *gamma, float threshold, float)
 {
 #if defined(HAVE_SIMD_MATHMODE)
-  vexpdigammify(all, gamma, threshold);
+  vexpdigammify(gamma, all.lda, threshold);
 #else
   // Do something sensible if SIMD math isn't available:
   expdigammify<float, USE_FAST_APPROX>(all, gamma, threshold, 0.0);
@@ -471,7 +449,7 @@ template <>
 inline void expdigammify_2<float, USE_SIMD>(vw &all, float* gamma, float *norm, const float threshold)
 {
 #if defined(HAVE_SIMD_MATHMODE)
-  vexpdigammify_2(all, gamma, norm, threshold);
+  vexpdigammify_2(gamma, norm, all.lda, threshold);
 #else
   // Do something sensible if SIMD math isn't available:
   expdigammify_2<float, USE_FAST_APPROX>(all, gamma, norm, threshold);
@@ -552,7 +530,10 @@ void lda::expdigammify(vw &all, float *gamma)
     ldamath::expdigammify<float, USE_PRECISE>(all, gamma, underflow_threshold(), 0.0f);
     break;
   case USE_SIMD:
-    ldamath::expdigammify<float, USE_SIMD>(all, gamma, underflow_threshold(), 0.0f);
+    if (wide != nullptr)
+      wide->expdigammify(gamma, topics, underflow_threshold());
+    else
+      ldamath::expdigammify<float, USE_SIMD>(all, gamma, underflow_threshold(), 0.0f);
     break;
   default:
     std::cerr << "lda::expdigammify: Trampled or invalid math mode, aborting" << std::endl;
@@ -571,7 +552,10 @@ void lda::expdigammify_2(vw &all, float* gamma, float *norm)
     ldamath::expdigammify_2<float, USE_PRECISE>(all, gamma, norm, underflow_threshold());
     break;
   case USE_SIMD:
-    ldamath::expdigammify_2<float, USE_SIMD>(all, gamma, norm, underflow_threshold());
+    if (wide != nullptr)
+      wide->expdigammify_2(gamma, norm, topics, underflow_threshold());
+    else
+      ldamath::expdigammify_2<float, USE_SIMD>(all, gamma, norm, underflow_threshold());
     break;
   default:
     std::cerr << "lda::expdigammify_2: Trampled or invalid math mode, aborting" << std::endl;
@@ -620,13 +604,10 @@ float theta_kl(lda &l, v_array<float> &Elogtheta, float *gamma)
 }
 
 static inline float find_cw(lda &l, float* u_for_w, float *v)
-{ return 1.0f / std::inner_product(u_for_w, u_for_w + l.topics, v, 0.0f); }
-
-namespace
 {
-// Effectively, these are static and not visible outside the compilation unit.
-v_array<float> new_gamma = v_init<float>();
-v_array<float> old_gamma = v_init<float>();
+  if (l.wide != nullptr)
+    return 1.0f / l.wide->dot(u_for_w, v, l.topics);
+  return 1.0f / std::inner_product(u_for_w, u_for_w + l.topics, v, 0.0f);
 }
 
 // Returns an estimate of the part of the variational bound that
@@ -634,9 +615,11 @@ v_array<float> old_gamma = v_init<float>();
 // setting of lambda based on the document passed in. The value is
 // divided by the total number of words in the document This can be
 // used as a (possibly very noisy) estimate of held-out likelihood.
-float lda_loop(lda &l, v_array<float> &Elogtheta, float *v, example *ec, float)
+float lda_loop(lda &l, lda_scratch &scratch, float *v, example *ec, float)
 {
   parameters& weights = l.all->weights;
+  v_array<float>& new_gamma = scratch.new_gamma;
+  v_array<float>& old_gamma = scratch.old_gamma;
   new_gamma.clear();
   old_gamma.clear();
 
@@ -668,12 +651,18 @@ float lda_loop(lda &l, v_array<float> &Elogtheta, float *v, example *ec, float)
       for (features::iterator& f : fs)
       {
         float* u_for_w = &(weights[f.index()]) + l.topics + 1;
-        float c_w = find_cw(l, u_for_w, v);
-        xc_w = c_w * f.value();
+        float c_w;
+        if (l.wide != nullptr)
+          c_w = l.wide->accumulate_word(u_for_w, v, new_gamma.begin(), l.topics, f.value());
+        else
+        {
+          c_w = find_cw(l, u_for_w, v);
+          xc_w = c_w * f.value();
+          size_t max_k = l.topics;
+          for (size_t k = 0; k < max_k; k++, ++u_for_w)
+            new_gamma[k] += xc_w * *u_for_w;
+        }
         score += -f.value() * log(c_w);
-        size_t max_k = l.topics;
-        for (size_t k = 0; k < max_k; k++, ++u_for_w)
-          new_gamma[k] += xc_w * *u_for_w;
         word_count++;
         doc_length += f.value();
       }
@@ -688,7 +677,7 @@ float lda_loop(lda &l, v_array<float> &Elogtheta, float *v, example *ec, float)
   memcpy(ec->pred.scalars.begin(), new_gamma.begin(), l.topics * sizeof(float));
   ec->pred.scalars.end() = ec->pred.scalars.begin() + l.topics;
 
-  score += theta_kl(l, Elogtheta, new_gamma.begin());
+  score += theta_kl(l, scratch.Elogtheta, new_gamma.begin());
 
   return score / doc_length;
 }
@@ -805,6 +794,23 @@ void return_example(vw& all, example& ec)
   VW::finish_example(all,ec);
 }
 
+// splits sorted_features into a range of whole words for each thread
+static void split_words(lda &l)
+{
+  size_t size = l.sorted_features.size();
+  size_t threads = l.pool->threads();
+  l.word_ranges.clear();
+  l.word_ranges.push_back(0);
+  for (size_t i = 1; i < threads; i++)
+  {
+    size_t b = max(i * size / threads, l.word_ranges.last());
+    while (b > 0 && b < size && l.sorted_features[b].f.weight_index == l.sorted_features[b - 1].f.weight_index)
+      b++;
+    l.word_ranges.push_back(b);
+  }
+  l.word_ranges.push_back(size);
+}
+
 void learn_batch(lda &l)
 {
   parameters& weights = l.all->weights;
@@ -865,32 +871,47 @@ void learn_batch(lda &l)
   for (size_t i = 0; i < l.all->lda; i++)
     l.digammas.push_back(l.digamma(l.total_lambda[i] + additional));
 
-  uint64_t last_weight_index = -1;
-  for (index_feature *s = &l.sorted_features[0]; s <= &l.sorted_features.back(); s++)
+  split_words(l);
+  l.pool->run([&l, &weights](size_t t)
   {
-    if (last_weight_index == s->f.weight_index)
-      continue;
-    last_weight_index = s->f.weight_index;
-    //float *weights_for_w = &(weights[s->f.weight_index]);
-    float* weights_for_w = &(weights[s->f.weight_index & weights.mask()]);
-    float decay_component =
-      l.decay_levels.end()[-2] - l.decay_levels.end()[(int)(-1 - l.example_t + *(weights_for_w + l.all->lda))];
-    float decay = fmin(1.0f, correctedExp(decay_component));
-    float* u_for_w = weights_for_w + l.all->lda + 1;
-
-    *(weights_for_w + l.all->lda) = (float)l.example_t;
-    for (size_t k = 0; k < l.all->lda; k++)
+    index_feature* end = l.sorted_features.data() + l.word_ranges[t + 1];
+    uint64_t last_weight_index = -1;
+    for (index_feature *s = l.sorted_features.data() + l.word_ranges[t]; s < end; s++)
     {
-      weights_for_w[k] *= decay;
-      u_for_w[k] = weights_for_w[k] + l.lda_rho;
+      if (last_weight_index == s->f.weight_index)
+        continue;
+      last_weight_index = s->f.weight_index;
+      //float *weights_for_w = &(weights[s->f.weight_index]);
+      float* weights_for_w = &(weights[s->f.weight_index & weights.mask()]);
+      float decay_component =
+        l.decay_levels.end()[-2] - l.decay_levels.end()[(int)(-1 - l.example_t + *(weights_for_w + l.all->lda))];
+      float decay = fmin(1.0f, correctedExp(decay_component));
+      float* u_for_w = weights_for_w + l.all->lda + 1;
+
+      *(weights_for_w + l.all->lda) = (float)l.example_t;
+      for (size_t k = 0; k < l.all->lda; k++)
+      {
+        weights_for_w[k] *= decay;
+        u_for_w[k] = weights_for_w[k] + l.lda_rho;
+      }
+
+      l.expdigammify_2(*l.all, u_for_w, l.digammas.begin());
     }
+  });
 
-    l.expdigammify_2(*l.all, u_for_w, l.digammas.begin());
-  }
+  l.scores.clear();
+  for (size_t d = 0; d < batch_size; d++)
+    l.scores.push_back(0.f);
+  std::atomic<size_t> next_document(0);
+  l.pool->run([&l, &next_document, batch_size](size_t t)
+  {
+    for (size_t d; (d = next_document++) < batch_size;)
+      l.scores[d] = lda_loop(l, l.scratch[t], &(l.v[d * l.all->lda]), l.examples[d], l.all->power_t);
+  });
 
   for (size_t d = 0; d < batch_size; d++)
   {
-    float score = lda_loop(l, l.Elogtheta, &(l.v[d * l.all->lda]), l.examples[d], l.all->power_t);
+    float score = l.scores[d];
     if (l.all->audit)
       GD::print_audit_features(*l.all, *l.examples[d]);
     // If the doc is empty, give it loss of 0.
@@ -905,33 +926,51 @@ void learn_batch(lda &l)
   // -t there's no need to update weights (especially since it's a noop)
   if (eta != 0)
   {
-    for (index_feature *s = &l.sorted_features[0]; s <= &l.sorted_features.back();)
+    l.pool->run([&l, &weights, eta, minuseta](size_t t)
     {
-      index_feature *next = s + 1;
-      while (next <= &l.sorted_features.back() && next->f.weight_index == s->f.weight_index)
-        next++;
+      v_array<float>& total_new = l.scratch[t].total_new;
+      total_new.clear();
+      for (size_t k = 0; k < l.all->lda; k++)
+        total_new.push_back(0.f);
 
-      float* word_weights = &(weights[s->f.weight_index]);
-      for (size_t k = 0; k < l.all->lda; k++, ++word_weights)
+      index_feature* end = l.sorted_features.data() + l.word_ranges[t + 1];
+      for (index_feature *s = l.sorted_features.data() + l.word_ranges[t]; s < end;)
       {
-        float new_value = minuseta * *word_weights;
-        *word_weights = new_value;
-      }
+        index_feature *next = s + 1;
+        while (next < end && next->f.weight_index == s->f.weight_index)
+          next++;
 
-      for (; s != next; s++)
-      {
-        float *v_s = &(l.v[s->document * l.all->lda]);
-        float* u_for_w = &(weights[s->f.weight_index]) + l.all->lda + 1;
-        float c_w = eta * find_cw(l, u_for_w, v_s) * s->f.x;
-        word_weights = &(weights[s->f.weight_index]);
-        for (size_t k = 0; k < l.all->lda; k++, ++u_for_w, ++word_weights)
+        float* word_weights = &(weights[s->f.weight_index]);
+        for (size_t k = 0; k < l.all->lda; k++, ++word_weights)
+        {
+          float new_value = minuseta * *word_weights;
+          *word_weights = new_value;
+        }
+
+        for (; s != next; s++)
         {
-          float new_value = *u_for_w * v_s[k] * c_w;
-          l.total_new[k] += new_value;
-          *word_weights += new_value;
+          float *v_s = &(l.v[s->document * l.all->lda]);
+          float* u_for_w = &(weights[s->f.weight_index]) + l.all->lda + 1;
+          float c_w = eta * find_cw(l, u_for_w, v_s) * s->f.x;
+          word_weights = &(weights[s->f.weight_index]);
+          if (l.wide != nullptr)
+          {
+            l.wide->update_word(word_weights, total_new.begin(), u_for_w, v_s, l.all->lda, c_w);
+            continue;
+          }
+          for (size_t k = 0; k < l.all->lda; k++, ++u_for_w, ++word_weights)
+          {
+            float new_value = *u_for_w * v_s[k] * c_w;
+            total_new[k] += new_value;
+            *word_weights += new_value;
+          }
         }
       }
-    }
+    });
+
+    for (size_t t = 0; t < l.pool->threads(); t++)
+      for (size_t k = 0; k < l.all->lda; k++)
+        l.total_new[k] += l.scratch[t].total_new[k];
 
     for (size_t k = 0; k < l.all->lda; k++)
     {
@@ -1232,7 +1271,12 @@ void finish_example(vw&, lda&, example &) {}
 void finish(lda &ld)
 {
   ld.sorted_features.~vector<index_feature>();
-  ld.Elogtheta.delete_v();
+  delete ld.pool;
+  for (lda_scratch& scratch : ld.scratch)
+    scratch.delete_v();
+  ld.scratch.delete_v();
+  ld.scores.delete_v();
+  ld.word_ranges.delete_v();
   ld.decay_levels.delete_v();
   ld.total_new.delete_v();
   ld.examples.delete_v();
@@ -1270,6 +1314,7 @@ LEARNER::base_learner *lda_setup(arguments& arg)
       ("lda_epsilon", ld->lda_epsilon, 0.001f, "Loop convergence threshold")
       ("minibatch", ld->minibatch, (size_t)1, "Minibatch size, for LDA")
       ("math-mode", ld->mmode, USE_SIMD, "Math mode: simd, accuracy, fast-approx")
+      ("lda_threads", ld->threads, (size_t)1, "Threads for the documents and the topic updates of each minibatch")
       ("metrics", ld->compute_coherence_metrics, false, "Compute metrics").missing())
     return nullptr;
 
@@ -1301,6 +1346,14 @@ LEARNER::base_learner *lda_setup(arguments& arg)
   arg.all->p->ring_size = arg.all->p->ring_size > minibatch2 ? arg.all->p->ring_size : minibatch2;
 
   ld->v.resize(arg.all->lda * ld->minibatch);
+  ld->wide = ld->mmode == USE_SIMD ? ldamath::wide_lda_kernels() : nullptr;
+
+  if (ld->threads < 1)
+    ld->threads = 1;
+  ld->pool = new worker_pool;
+  ld->pool->start(ld->threads);
+  for (size_t i = 0; i < ld->threads; i++)
+    ld->scratch.push_back(lda_scratch());
 
   ld->decay_levels.push_back(0.f);
 
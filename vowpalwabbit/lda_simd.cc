@@ -0,0 +1,359 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#include "lda_simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VW_LDA_SIMD
+#include <immintrin.h>
+#endif
+
+namespace ldamath
+{
+#ifdef VW_LDA_SIMD
+// The approximations round as the SSE2 ones do: no multiply-add is contracted in them.
+
+/* AVX2, 8 lanes.  The last topics are read and written with maskload and maskstore. */
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static inline __m256i tail_mask8(size_t left)
+{
+  return _mm256_cmpgt_epi32(_mm256_set1_epi32((int)left), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static inline __m256 load8(const float* p, size_t left)
+{
+  return left >= 8 ? _mm256_loadu_ps(p) : _mm256_maskload_ps(p, tail_mask8(left));
+}
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static inline void store8(float* p, size_t left, __m256 x)
+{
+  if (left >= 8)
+    _mm256_storeu_ps(p, x);
+  else
+    _mm256_maskstore_ps(p, tail_mask8(left), x);
+}
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static inline float sum8(__m256 x)
+{
+  float lanes[8];
+  _mm256_storeu_ps(lanes, x);
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static inline __m256 fastpow2_8(__m256 p)
+{
+  __m256 ltzero = _mm256_cmp_ps(p, _mm256_setzero_ps(), _CMP_LT_OQ);
+  __m256 offset = _mm256_and_ps(ltzero, _mm256_set1_ps(1.0f));
+  __m256 lt126 = _mm256_cmp_ps(p, _mm256_set1_ps(-126.0f), _CMP_LT_OQ);
+  __m256 clipp = _mm256_add_ps(_mm256_andnot_ps(lt126, p), _mm256_and_ps(lt126, _mm256_set1_ps(-126.0f)));
+  __m256i w = _mm256_cvttps_epi32(clipp);
+  __m256 z = _mm256_add_ps(_mm256_sub_ps(clipp, _mm256_cvtepi32_ps(w)), offset);
+
+  __m256 v = _mm256_sub_ps(
+               _mm256_add_ps(_mm256_add_ps(clipp, _mm256_set1_ps(121.2740838f)),
+                             _mm256_div_ps(_mm256_set1_ps(27.7280233f), _mm256_sub_ps(_mm256_set1_ps(4.84252568f), z))),
+               _mm256_mul_ps(_mm256_set1_ps(1.49012907f), z));
+  v = _mm256_mul_ps(_mm256_set1_ps(1 << 23), v);
+  return _mm256_castsi256_ps(_mm256_cvttps_epi32(v));
+}
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static inline __m256 fastexp8(__m256 p)
+{
+  return fastpow2_8(_mm256_mul_ps(_mm256_set1_ps(1.442695040f), p));
+}
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static inline __m256 fastlog2_8(__m256 x)
+{
+  __m256i vx_i = _mm256_castps_si256(x);
+  __m256 mx_f = _mm256_castsi256_ps(
+                  _mm256_or_si256(_mm256_and_si256(vx_i, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3f000000)));
+  __m256 y = _mm256_mul_ps(_mm256_cvtepi32_ps(vx_i), _mm256_set1_ps(1.1920928955078125e-7f));
+
+  return _mm256_sub_ps(
+           _mm256_sub_ps(_mm256_sub_ps(y, _mm256_set1_ps(124.22551499f)), _mm256_mul_ps(_mm256_set1_ps(1.498030302f), mx_f)),
+           _mm256_div_ps(_mm256_set1_ps(1.72587999f), _mm256_add_ps(_mm256_set1_ps(0.3520887068f), mx_f)));
+}
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static inline __m256 fastdigamma8(__m256 x)
+{
+  __m256 twopx = _mm256_add_ps(_mm256_set1_ps(2.0f), x);
+  __m256 logterm = _mm256_mul_ps(_mm256_set1_ps(0.69314718f), fastlog2_8(twopx));
+
+  __m256 num = _mm256_add_ps(_mm256_set1_ps(-48.0f),
+                             _mm256_mul_ps(x, _mm256_add_ps(_mm256_set1_ps(-157.0f),
+                                           _mm256_mul_ps(x, _mm256_sub_ps(_mm256_set1_ps(-127.0f),
+                                                         _mm256_mul_ps(_mm256_set1_ps(30.0f), x))))));
+  __m256 den = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(12.0f), x),
+                             _mm256_add_ps(_mm256_set1_ps(1.0f), x)), twopx), twopx);
+  return _mm256_add_ps(_mm256_div_ps(num, den), logterm);
+}
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static void expdigammify_avx2(float* gamma, size_t topics, float threshold)
+{
+  __m256 sum = _mm256_setzero_ps();
+  for (size_t k = 0; k < topics; k += 8)
+  {
+    __m256 g = load8(gamma + k, topics - k);
+    sum = _mm256_add_ps(sum, g);
+    store8(gamma + k, topics - k, fastdigamma8(g));
+  }
+  __m256 norm = fastdigamma8(_mm256_set1_ps(sum8(sum)));
+
+  __m256 t = _mm256_set1_ps(threshold);
+  for (size_t k = 0; k < topics; k += 8)
+  {
+    __m256 g = load8(gamma + k, topics - k);
+    store8(gamma + k, topics - k, _mm256_max_ps(t, fastexp8(_mm256_sub_ps(g, norm))));
+  }
+}
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static void expdigammify_2_avx2(float* gamma, const float* norm, size_t topics, float threshold)
+{
+  __m256 t = _mm256_set1_ps(threshold);
+  for (size_t k = 0; k < topics; k += 8)
+  {
+    __m256 g = fastdigamma8(load8(gamma + k, topics - k));
+    store8(gamma + k, topics - k, _mm256_max_ps(t, fastexp8(_mm256_sub_ps(g, load8(norm + k, topics - k)))));
+  }
+}
+
+__attribute__((target("avx2,fma")))
+static float dot_avx2(const float* u, const float* v, size_t topics)
+{
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  size_t k = 0;
+  for (; k + 16 <= topics; k += 16)
+  {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(u + k), _mm256_loadu_ps(v + k), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(u + k + 8), _mm256_loadu_ps(v + k + 8), acc1);
+  }
+  for (; k < topics; k += 8)
+    acc0 = _mm256_fmadd_ps(load8(u + k, topics - k), load8(v + k, topics - k), acc0);
+  return sum8(_mm256_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx2,fma")))
+static float accumulate_word_avx2(const float* u, const float* v, float* gamma, size_t topics, float x)
+{
+  float c = 1.0f / dot_avx2(u, v, topics);
+  __m256 xc = _mm256_set1_ps(c * x);
+  size_t k = 0;
+  for (; k + 8 <= topics; k += 8)
+    _mm256_storeu_ps(gamma + k, _mm256_fmadd_ps(xc, _mm256_loadu_ps(u + k), _mm256_loadu_ps(gamma + k)));
+  if (k < topics)
+    store8(gamma + k, topics - k, _mm256_fmadd_ps(xc, load8(u + k, topics - k), load8(gamma + k, topics - k)));
+  return c;
+}
+
+__attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+static void update_word_avx2(float* w, float* total, const float* u, const float* v, size_t topics, float c)
+{
+  __m256 vc = _mm256_set1_ps(c);
+  for (size_t k = 0; k < topics; k += 8)
+  {
+    size_t left = topics - k;
+    __m256 d = _mm256_mul_ps(_mm256_mul_ps(load8(u + k, left), load8(v + k, left)), vc);
+    store8(w + k, left, _mm256_add_ps(load8(w + k, left), d));
+    store8(total + k, left, _mm256_add_ps(load8(total + k, left), d));
+  }
+}
+
+/* AVX-512, 16 lanes.  The last topics are read and written under a lane mask. */
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static inline __mmask16 tail_mask16(size_t left)
+{
+  return left >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << left) - 1);
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static inline float sum16(__m512 x)
+{
+  float lanes[16];
+  _mm512_storeu_ps(lanes, x);
+  float s = 0.f;
+  for (size_t i = 0; i < 16; i += 4)
+    s += (lanes[i] + lanes[i + 1]) + (lanes[i + 2] + lanes[i + 3]);
+  return s;
+}
+
+// every lane, for the zero masked conversions and max below: the unmasked intrinsics pass an
+// undefined source vector that GCC reports as maybe uninitialized
+static const __mmask16 all16 = 0xffff;
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static inline __m512 fastpow2_16(__m512 p)
+{
+  __mmask16 ltzero = _mm512_cmp_ps_mask(p, _mm512_setzero_ps(), _CMP_LT_OQ);
+  __m512 offset = _mm512_maskz_mov_ps(ltzero, _mm512_set1_ps(1.0f));
+  __mmask16 lt126 = _mm512_cmp_ps_mask(p, _mm512_set1_ps(-126.0f), _CMP_LT_OQ);
+  __m512 clipp = _mm512_add_ps(_mm512_maskz_mov_ps((__mmask16)~lt126, p), _mm512_maskz_mov_ps(lt126, _mm512_set1_ps(-126.0f)));
+  __m512i w = _mm512_maskz_cvttps_epi32(all16, clipp);
+  __m512 z = _mm512_add_ps(_mm512_sub_ps(clipp, _mm512_maskz_cvtepi32_ps(all16, w)), offset);
+
+  __m512 v = _mm512_sub_ps(
+               _mm512_add_ps(_mm512_add_ps(clipp, _mm512_set1_ps(121.2740838f)),
+                             _mm512_div_ps(_mm512_set1_ps(27.7280233f), _mm512_sub_ps(_mm512_set1_ps(4.84252568f), z))),
+               _mm512_mul_ps(_mm512_set1_ps(1.49012907f), z));
+  v = _mm512_mul_ps(_mm512_set1_ps(1 << 23), v);
+  return _mm512_castsi512_ps(_mm512_maskz_cvttps_epi32(all16, v));
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static inline __m512 fastexp16(__m512 p)
+{
+  return fastpow2_16(_mm512_mul_ps(_mm512_set1_ps(1.442695040f), p));
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static inline __m512 fastlog2_16(__m512 x)
+{
+  __m512i vx_i = _mm512_castps_si512(x);
+  __m512 mx_f = _mm512_castsi512_ps(
+                  _mm512_or_si512(_mm512_and_si512(vx_i, _mm512_set1_epi32(0x007FFFFF)), _mm512_set1_epi32(0x3f000000)));
+  __m512 y = _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(all16, vx_i), _mm512_set1_ps(1.1920928955078125e-7f));
+
+  return _mm512_sub_ps(
+           _mm512_sub_ps(_mm512_sub_ps(y, _mm512_set1_ps(124.22551499f)), _mm512_mul_ps(_mm512_set1_ps(1.498030302f), mx_f)),
+           _mm512_div_ps(_mm512_set1_ps(1.72587999f), _mm512_add_ps(_mm512_set1_ps(0.3520887068f), mx_f)));
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static inline __m512 fastdigamma16(__m512 x)
+{
+  __m512 twopx = _mm512_add_ps(_mm512_set1_ps(2.0f), x);
+  __m512 logterm = _mm512_mul_ps(_mm512_set1_ps(0.69314718f), fastlog2_16(twopx));
+
+  __m512 num = _mm512_add_ps(_mm512_set1_ps(-48.0f),
+                             _mm512_mul_ps(x, _mm512_add_ps(_mm512_set1_ps(-157.0f),
+                                           _mm512_mul_ps(x, _mm512_sub_ps(_mm512_set1_ps(-127.0f),
+                                                         _mm512_mul_ps(_mm512_set1_ps(30.0f), x))))));
+  __m512 den = _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(12.0f), x),
+                             _mm512_add_ps(_mm512_set1_ps(1.0f), x)), twopx), twopx);
+  return _mm512_add_ps(_mm512_div_ps(num, den), logterm);
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static void expdigammify_avx512(float* gamma, size_t topics, float threshold)
+{
+  __m512 sum = _mm512_setzero_ps();
+  for (size_t k = 0; k < topics; k += 16)
+  {
+    __mmask16 m = tail_mask16(topics - k);
+    __m512 g = _mm512_maskz_loadu_ps(m, gamma + k);
+    sum = _mm512_add_ps(sum, g);
+    _mm512_mask_storeu_ps(gamma + k, m, fastdigamma16(g));
+  }
+  __m512 norm = fastdigamma16(_mm512_set1_ps(sum16(sum)));
+
+  __m512 t = _mm512_set1_ps(threshold);
+  for (size_t k = 0; k < topics; k += 16)
+  {
+    __mmask16 m = tail_mask16(topics - k);
+    __m512 g = _mm512_maskz_loadu_ps(m, gamma + k);
+    _mm512_mask_storeu_ps(gamma + k, m, _mm512_maskz_max_ps(all16, t, fastexp16(_mm512_sub_ps(g, norm))));
+  }
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static void expdigammify_2_avx512(float* gamma, const float* norm, size_t topics, float threshold)
+{
+  __m512 t = _mm512_set1_ps(threshold);
+  for (size_t k = 0; k < topics; k += 16)
+  {
+    __mmask16 m = tail_mask16(topics - k);
+    __m512 g = fastdigamma16(_mm512_maskz_loadu_ps(m, gamma + k));
+    g = _mm512_sub_ps(g, _mm512_maskz_loadu_ps(m, norm + k));
+    _mm512_mask_storeu_ps(gamma + k, m, _mm512_maskz_max_ps(all16, t, fastexp16(g)));
+  }
+}
+
+__attribute__((target("avx512f")))
+static float dot_avx512(const float* u, const float* v, size_t topics)
+{
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  size_t k = 0;
+  for (; k + 32 <= topics; k += 32)
+  {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(u + k), _mm512_loadu_ps(v + k), acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(u + k + 16), _mm512_loadu_ps(v + k + 16), acc1);
+  }
+  for (; k < topics; k += 16)
+  {
+    __mmask16 m = tail_mask16(topics - k);
+    acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, u + k), _mm512_maskz_loadu_ps(m, v + k), acc0);
+  }
+  return sum16(_mm512_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+static float accumulate_word_avx512(const float* u, const float* v, float* gamma, size_t topics, float x)
+{
+  float c = 1.0f / dot_avx512(u, v, topics);
+  __m512 xc = _mm512_set1_ps(c * x);
+  for (size_t k = 0; k < topics; k += 16)
+  {
+    __mmask16 m = tail_mask16(topics - k);
+    __m512 g = _mm512_fmadd_ps(xc, _mm512_maskz_loadu_ps(m, u + k), _mm512_maskz_loadu_ps(m, gamma + k));
+    _mm512_mask_storeu_ps(gamma + k, m, g);
+  }
+  return c;
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static void update_word_avx512(float* w, float* total, const float* u, const float* v, size_t topics, float c)
+{
+  __m512 vc = _mm512_set1_ps(c);
+  for (size_t k = 0; k < topics; k += 16)
+  {
+    __mmask16 m = tail_mask16(topics - k);
+    __m512 d = _mm512_mul_ps(_mm512_mul_ps(_mm512_maskz_loadu_ps(m, u + k), _mm512_maskz_loadu_ps(m, v + k)), vc);
+    _mm512_mask_storeu_ps(w + k, m, _mm512_add_ps(_mm512_maskz_loadu_ps(m, w + k), d));
+    _mm512_mask_storeu_ps(total + k, m, _mm512_add_ps(_mm512_maskz_loadu_ps(m, total + k), d));
+  }
+}
+
+static const lda_kernels avx2_kernels =
+{ "avx2", expdigammify_avx2, expdigammify_2_avx2, dot_avx2, accumulate_word_avx2, update_word_avx2 };
+
+static const lda_kernels avx512_kernels =
+{ "avx512", expdigammify_avx512, expdigammify_2_avx512, dot_avx512, accumulate_word_avx512, update_word_avx512 };
+#endif
+
+std::vector<const lda_kernels*> all_wide_lda_kernels()
+{
+  std::vector<const lda_kernels*> available;
+#ifdef VW_LDA_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    available.push_back(&avx2_kernels);
+  if (__builtin_cpu_supports("avx512f"))
+    available.push_back(&avx512_kernels);
+#endif
+  return available;
+}
+
+static const lda_kernels* pick_kernels()
+{
+  std::vector<const lda_kernels*> available = all_wide_lda_kernels();
+  return available.empty() ? nullptr : available.back();
+}
+
+static const lda_kernels* kernels = pick_kernels();
+
+const lda_kernels* wide_lda_kernels() { return kernels; }
+}
@@ -0,0 +1,103 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+/* Topic-at-a-time kernels for --math-mode simd, 16 lanes wide with AVX-512 and 8 with AVX2.  The
+** instruction set is chosen once, at startup; without either lda_core.cc keeps to its SSE2 code.
+** The digamma, exp and log approximations are those of the SSE2 code, lane by lane.
+*/
+namespace ldamath
+{
+// The scalar approximations of --math-mode fast, which the SSE2 code also applies to the topics
+// left over from its vectors.
+
+inline float fastlog2(float x)
+{
+  uint32_t mx;
+  memcpy(&mx, &x, sizeof(uint32_t));
+  mx = (mx & 0x007FFFFF) | (0x7e << 23);
+
+  float mx_f;
+  memcpy(&mx_f, &mx, sizeof(float));
+
+  uint32_t vx;
+  memcpy(&vx, &x, sizeof(uint32_t));
+
+  float y = static_cast<float>(vx);
+  y *= 1.0f / (float)(1 << 23);
+
+  return y - 124.22544637f - 1.498030302f * mx_f - 1.72587999f / (0.3520887068f + mx_f);
+}
+
+inline float fastlog(float x) { return 0.69314718f * fastlog2(x); }
+
+inline float fastpow2(float p)
+{
+  float offset = (p < 0) * 1.0f;
+  float clipp = (p < -126.0) ? -126.0f : p;
+  int w = (int)clipp;
+  float z = clipp - w + offset;
+  uint32_t approx = (uint32_t) ((1 << 23) * (clipp + 121.2740838f + 27.7280233f / (4.84252568f - z) - 1.49012907f * z));
+
+  float v;
+  memcpy(&v, &approx, sizeof(uint32_t));
+  return v;
+}
+
+inline float fastexp(float p) { return fastpow2(1.442695040f * p); }
+
+inline float fastpow(float x, float p) { return fastpow2(p * fastlog2(x)); }
+
+inline float fastlgamma(float x)
+{
+  float logterm = fastlog(x * (1.0f + x) * (2.0f + x));
+  float xp3 = 3.0f + x;
+
+  return -2.081061466f - x + 0.0833333f / xp3 - logterm + (2.5f + x) * fastlog(xp3);
+}
+
+inline float fastdigamma(float x)
+{
+  float twopx = 2.0f + x;
+  float logterm = fastlog(twopx);
+
+  return -(1.0f + 2.0f * x) / (x * (1.0f + x)) - (13.0f + 6.0f * x) / (12.0f * twopx * twopx) + logterm;
+}
+
+// the SSE2 code of lda_core.cc, what --math-mode simd runs without AVX2 or AVX-512
+void vexpdigammify(float* gamma, size_t topics, float threshold);
+void vexpdigammify_2(float* gamma, const float* norm, size_t topics, float threshold);
+
+struct lda_kernels
+{
+  const char* name;
+
+  // gamma[k] = max(threshold, exp(digamma(gamma[k]) - digamma(sum of gamma)))
+  void (*expdigammify)(float* gamma, size_t topics, float threshold);
+
+  // gamma[k] = max(threshold, exp(digamma(gamma[k]) - norm[k]))
+  void (*expdigammify_2)(float* gamma, const float* norm, size_t topics, float threshold);
+
+  // sum of u[k] * v[k]
+  float (*dot)(const float* u, const float* v, size_t topics);
+
+  // the E-step for one word: c = 1 / dot(u, v), gamma[k] += c * x * u[k], returns c
+  float (*accumulate_word)(const float* u, const float* v, float* gamma, size_t topics, float x);
+
+  // the lambda update for one word of one document: d = u[k] * v[k] * c, w[k] += d, total[k] += d
+  void (*update_word)(float* w, float* total, const float* u, const float* v, size_t topics, float c);
+};
+
+// the kernels of this build the processor runs, the narrowest first
+std::vector<const lda_kernels*> all_wide_lda_kernels();
+
+// the widest kernels the processor runs, nullptr when it has neither AVX-512 nor AVX2
+const lda_kernels* wide_lda_kernels();
+}
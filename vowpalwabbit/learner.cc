@@ -1,3 +1,6 @@
+#include <thread>
+#include <mutex>
+#include <atomic>
 #include "parser.h"
 #include "vw.h"
 #include "parse_regressor.h"
@@ -7,6 +10,7 @@ using namespace std;
 void dispatch_example(vw& all, example& ec)
 {
   all.learn(ec);
+  perf_timer timer(all.perf, perf_finish);
   as_singleline(all.l)->finish_example(all, ec);
 }
 
@@ -76,6 +80,7 @@ void process_example(vw& all, example* ec)
 void process_multi_ex(vw& all, multi_ex& ec_seq)
 {
   all.learn(ec_seq);
+  perf_timer timer(all.perf, perf_finish);
   as_multiline(all.l)->finish_example(all, ec_seq);
 }
 
@@ -197,7 +202,9 @@ void generic_driver(vector<vw*> alls)
 
 void generic_driver(vw& all)
 {
-  if(all.l->is_multiline)
+  if (all.learn_threads > 1)
+    generic_driver_learn_threads(all);
+  else if(all.l->is_multiline)
     multi_ex_generic_driver<process_multi_ex>(all);
   else
     generic_driver<vw&, process_example>(all, all);
@@ -235,6 +242,197 @@ void generic_driver_onethread(vw& all)
   all.l->end_examples();
 }
 
+/* --learn_threads: Hogwild learning.  Each thread has its own reduction stack (VW::seed_learner),
+** so the scratch state reductions keep between calls is never shared, while all the stacks read
+** and update all's weights without any locking.  Examples are taken off the ring (and multiline
+** ones grouped) in ring order under intake; finish_example, which prints progress and predictions
+** and accounts into the shared sd, runs under output, in the order learning completes.  End of
+** pass and save examples wait until every example taken before them has been finished.
+*/
+struct hogwild
+{
+  vw* all;
+  mutex intake;
+  mutex output;
+  atomic<size_t> in_flight; // taken off the ring but not finished yet
+  vector<vw*> learners;
+};
+
+// false for end of pass and save examples
+static bool is_ordinary(example* ec) { return ec->indices.size() > 1 || !(ec->end_pass || is_save_cmd(ec)); }
+
+// end of pass or save, run on all once every earlier example is done; intake must be held
+static void barrier(hogwild& h, example* ec)
+{
+  while (h.in_flight > 0)
+    this_thread::yield();
+
+  vw& all = *h.all;
+  if (ec->end_pass)
+    dispatch_end_pass(all, *ec);
+  else
+    save(all, ec);
+
+  for (vw* learner : h.learners)
+  {
+    learner->current_pass = all.current_pass;
+    learner->eta = all.eta;
+  }
+}
+
+static void learn_single(hogwild& h, vw& learner)
+{
+  vw& all = *h.all;
+  while (true)
+  {
+    example* ec;
+    {
+      lock_guard<mutex> lock(h.intake);
+      if ((ec = VW::get_example(all.p)) == nullptr)
+        return;
+      if (all.early_terminate)
+      {
+        VW::finish_example(all, *ec);
+        continue;
+      }
+      if (!is_ordinary(ec))
+      {
+        barrier(h, ec);
+        continue;
+      }
+      h.in_flight++;
+    }
+
+    learner.learn(*ec);
+    {
+      lock_guard<mutex> lock(h.output);
+      perf_timer timer(all.perf, perf_finish);
+      as_singleline(learner.l)->finish_example(learner, *ec);
+    }
+    if (&learner != &all) // a seeded learner's finish_example leaves all's ring examples alone
+      VW::finish_example(all, *ec);
+    h.in_flight--;
+  }
+}
+
+static void learn_multi(hogwild& h, vw& learner)
+{
+  vw& all = *h.all;
+  multi_ex ec_seq;
+  multi_ex taken; // ec_seq as learned, a seeded learner's finish_example clears it
+  bool more = true;
+  while (more)
+  {
+    {
+      lock_guard<mutex> lock(h.intake);
+      while (true)
+      {
+        example* ec = VW::get_example(all.p);
+        if (ec == nullptr)
+        {
+          more = false;
+          break;
+        }
+        if (all.early_terminate)
+          VW::finish_example(all, *ec);
+        else if (!is_ordinary(ec))
+          barrier(h, ec);
+        else if (complete_multi_ex(ec, ec_seq, all))
+          break;
+      }
+      if (ec_seq.size() == 0)
+        continue;
+      if (all.early_terminate)
+      {
+        VW::finish_example(all, ec_seq);
+        continue;
+      }
+      h.in_flight++;
+    }
+
+    taken = ec_seq;
+    learner.learn(ec_seq);
+    {
+      lock_guard<mutex> lock(h.output);
+      perf_timer timer(all.perf, perf_finish);
+      as_multiline(learner.l)->finish_example(learner, ec_seq);
+    }
+    if (&learner == &all)
+      VW::finish_example(all, ec_seq);
+    else
+    {
+      VW::finish_example(all, taken);
+      ec_seq.clear();
+    }
+    h.in_flight--;
+  }
+}
+
+static void learn_thread(hogwild& h, vw& learner)
+{
+  if (learner.l->is_multiline)
+    learn_multi(h, learner);
+  else
+    learn_single(h, learner);
+}
+
+// given on the command line (or in the model), rather than a switch defaulted to false
+static bool option_given(po::variables_map& vm, const char* option)
+{
+  if (vm.count(option) == 0)
+    return false;
+  return vm[option].value().type() != typeid(bool) || vm[option].as<bool>();
+}
+
+static string learn_threads_unsupported(vw& all)
+{
+  static const char* const unsupported[] = { "bfgs", "conjugate_gradient", "lda", "ksvm", "svrg", "new_mf", "OjaNewton",
+    "stage_poly", "search", "active", "boosting", "sendto", "print", "noop", "audit"
+  };
+
+  if (all.weights.sparse)
+    return "sparse weights are not thread safe";
+  if (all.daemon || all.active)
+    return "daemon predictions must be answered in order";
+  if (all.all_reduce != nullptr)
+    return "AllReduce synchronizes a single learner per node";
+  for (const char* option : unsupported)
+    if (option_given(all.opts_n_args.vm, option))
+      return string("--") + option + " is not supported";
+  return "";
+}
+
+void generic_driver_learn_threads(vw& all)
+{
+  string reason = learn_threads_unsupported(all);
+  if (!reason.empty())
+  {
+    if (!all.quiet)
+      all.opts_n_args.trace_message << "ignoring --learn_threads: " << reason << endl;
+    all.learn_threads = 1;
+    generic_driver(all);
+    return;
+  }
+
+  hogwild h;
+  h.all = &all;
+  h.in_flight = 0;
+  h.learners.push_back(&all);
+  for (size_t i = 1; i < all.learn_threads; i++)
+    h.learners.push_back(VW::seed_learner(all));
+
+  vector<thread> threads;
+  for (size_t i = 1; i < h.learners.size(); i++)
+    threads.push_back(thread(learn_thread, ref(h), ref(*h.learners[i])));
+  learn_thread(h, all);
+  for (thread& t : threads)
+    t.join();
+
+  all.l->end_examples();
+  for (size_t i = 1; i < h.learners.size(); i++)
+    VW::finish_learner(*h.learners[i]);
+}
+
 float recur_sensitivity(void*, base_learner& base, example& ec)
 {
   return base.sensitivity(ec);
@@ -85,6 +85,7 @@ struct finish_example_data
 void generic_driver(vw& all);
 void generic_driver(std::vector<vw*> alls);
 void generic_driver_onethread(vw& all);
+void generic_driver_learn_threads(vw& all);
 
 inline void noop_sl(void*, io_buf&, bool, bool) {}
 inline void noop(void*) {}
@@ -112,6 +113,18 @@ inline void decrement_offset(multi_ex& ec_seq, const size_t increment, const siz
   }
 }
 
+// what the predict loop standing in for a missing multipredict keeps
+inline void store_prediction(example& ec, polyprediction& pred, bool finalize_predictions)
+{ if (finalize_predictions) pred = ec.pred; // TODO: this breaks for complex labels because = doesn't do deep copy!
+  else                      pred.scalar = ec.partial_prediction;
+  //pred[c].scalar = finalize_prediction ec.partial_prediction; // TODO: this breaks for complex labels because = doesn't do deep copy! // note works if ec.partial_prediction, but only if finalize_prediction is run????
+}
+
+// a multiline prediction is spread over the examples, which only the learner knows how to gather
+inline void store_prediction(multi_ex&, polyprediction&, bool)
+{ THROW("multipredict is not implemented by this multiline learner");
+}
+
 template<class T,class E> struct learner
 {
 private:
@@ -151,23 +164,22 @@ public:
     decrement_offset(ec, increment, i);
   }
 
-  inline void multipredict(E& ec, size_t lo, size_t count, polyprediction* pred, bool finalize_predictions)
+  // predicts with the policies lo, lo+stride, ..., lo+(count-1)*stride
+  inline void multipredict(E& ec, size_t lo, size_t count, polyprediction* pred, bool finalize_predictions, size_t stride = 1)
   { assert((is_multiline && std::is_same<multi_ex, E>::value) ||
       (!is_multiline && std::is_same<example, E>::value));  // sanity check under debug compile
     if (learn_fd.multipredict_f == NULL)
     { increment_offset(ec, increment, lo);
       for (size_t c=0; c<count; c++)
       { learn_fd.predict_f(learn_fd.data, *learn_fd.base, (void*)&ec);
-        if (finalize_predictions) pred[c] = ec.pred; // TODO: this breaks for complex labels because = doesn't do deep copy!
-        else                      pred[c].scalar = ec.partial_prediction;
-        //pred[c].scalar = finalize_prediction ec.partial_prediction; // TODO: this breaks for complex labels because = doesn't do deep copy! // note works if ec.partial_prediction, but only if finalize_prediction is run????
-        increment_offset(ec, increment, 1);
+        store_prediction(ec, pred[c], finalize_predictions);
+        increment_offset(ec, increment, stride);
       }
-      decrement_offset(ec, increment, lo+count);
+      decrement_offset(ec, increment, lo+count*stride);
     }
     else
     { increment_offset(ec, increment, lo);
-      learn_fd.multipredict_f(learn_fd.data, *learn_fd.base, (void*)&ec, count, increment, pred, finalize_predictions);
+      learn_fd.multipredict_f(learn_fd.data, *learn_fd.base, (void*)&ec, count, increment*stride, pred, finalize_predictions);
       decrement_offset(ec, increment, lo);
     }
   }
@@ -179,6 +191,11 @@ public:
   template<class L>
   inline void set_multipredict(void (*u)(T&, L&, E&, size_t, size_t, polyprediction*, bool)) { learn_fd.multipredict_f = (learn_data::multi_fn)u; }
 
+  // for a reduction recognizing the learner it reduces to
+  template<class D, class L, class F>
+  inline bool predicts_with(void (*u)(D&, L&, F&)) const { return learn_fd.predict_f == (learn_data::fn)u; }
+  inline base_learner* get_base() const { return learn_fd.base; }
+
   inline void update(E& ec, size_t i=0)
   { assert((is_multiline && std::is_same<multi_ex, E>::value) ||
       (!is_multiline && std::is_same<example, E>::value));  // sanity check under debug compile
@@ -15,6 +15,7 @@ license as described in the file LICENSE.
 #include "accumulate.h"
 #include "best_constant.h"
 #include "vw_exception.h"
+#include "daemon_server.h"
 #include <fstream>
 
 using namespace std;
@@ -111,7 +112,9 @@ int main(int argc, char *argv[])
     //struct timeb t_start, t_end;
     //ftime(&t_start);
 
-    if (all.opts_n_args.vm.count("onethread") > 0) {
+    if (all.daemon_threads > 0)
+        serve_daemon_threads(all);
+    else if (all.opts_n_args.vm.count("onethread") > 0) {
         if (alls.size() == 1)
           LEARNER::generic_driver_onethread(all);
         else
@@ -34,6 +34,7 @@ template<class T> free_ptr<T> scoped_calloc_or_throw()
 }
 
 #ifdef MADV_MERGEABLE
+#include <unistd.h>
 template<class T>
 T* calloc_mergable_or_throw(size_t nmemb)
 { if (nmemb == 0)
@@ -0,0 +1,190 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+ */
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <string.h>
+#include <algorithm>
+#include <errno.h>
+#include <iostream>
+#include "mmap_io.h"
+
+// how far fill() moves the end of the window into a mapping at a time
+const size_t window = 1 << 26;
+
+mmap_io_buf::mmap_io_buf() : active(-1)
+{
+  owned = v_init<char>();
+#ifdef _WIN32
+  page = 1 << 12;
+#else
+  page = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+mmap_io_buf::~mmap_io_buf()
+{
+  deactivate(); // so that io_buf frees its own buffer rather than a mapping
+  while (!mappings.empty())
+    unmap(mappings.back().fd);
+}
+
+mmap_io_buf::mapping* mmap_io_buf::find(int f)
+{
+  for (mapping& m : mappings)
+    if (m.fd == f)
+      return &m;
+  return nullptr;
+}
+
+void mmap_io_buf::unmap(int f)
+{
+  for (size_t i = 0; i < mappings.size(); i++)
+    if (mappings[i].fd == f)
+    {
+      if (active == f)
+        deactivate();
+#ifndef _WIN32
+      munmap(mappings[i].begin, mappings[i].length);
+#endif
+      mappings.erase(mappings.begin() + i);
+      return;
+    }
+}
+
+// points space back at the io_buf's own buffer, carrying over the unread bytes
+void mmap_io_buf::deactivate()
+{
+  if (active == -1)
+    return;
+
+  size_t left = space.end() - head;
+  if ((size_t)(owned.end_array - owned.begin()) < left)
+    owned.resize(left);
+  memcpy(owned.begin(), head, left);
+  owned.end() = owned.begin() + left;
+
+  space = owned;
+  head = space.begin();
+  active = -1;
+}
+
+int mmap_io_buf::open_file(const char* name, bool stdin_off, int flag)
+{
+  int ret = io_buf::open_file(name, stdin_off, flag);
+  if (ret == -1)
+    return ret;
+  unmap(ret); // a descriptor closed behind our back and reused
+
+#ifndef _WIN32
+  struct stat st;
+  if (flag != READ || fstat(ret, &st) != 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size <= page)
+    return ret;
+
+  // Read only, so nothing is committed for it, and the kernel may drop the pages behind the window.
+  size_t file_size = (size_t)st.st_size;
+  void* region = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, ret, 0);
+  if (region == MAP_FAILED)
+  {
+    std::cerr << "mmap " << name << ": " << strerror(errno) << ", reading it instead" << std::endl;
+    return ret;
+  }
+  madvise(region, file_size, MADV_SEQUENTIAL);
+
+  char* begin = (char*)region;
+  mapping m = { ret, begin, begin + (file_size - 1) / page * page, file_size, begin };
+  mappings.push_back(m);
+#endif
+  return ret;
+}
+
+void mmap_io_buf::reset_file(int f)
+{
+  deactivate();
+  mapping* m = find(f);
+  if (m != nullptr)
+    m->released = m->begin; // read again from the start, faulting the dropped pages back in
+  io_buf::reset_file(f);
+}
+
+ssize_t mmap_io_buf::fill(int f)
+{
+  mapping* m = find(f);
+  if (active == f)
+  {
+    if (space.end() < m->end)
+    {
+      size_t added = std::min(window, (size_t)(m->end - space.end()));
+      space.end() += added;
+      space.end_array = space.end();
+      return added;
+    }
+    // the window reached the last page, which is read like the end of any other file
+    deactivate();
+    return io_buf::fill(f);
+  }
+
+  if (m == nullptr || head != space.end())
+  {
+    deactivate();
+    return io_buf::fill(f);
+  }
+
+  // Start wherever the descriptor is, a cache header may already have been read from it.
+#ifdef _WIN32
+  int64_t offset = _lseeki64(f, 0, SEEK_CUR);
+#else
+  off_t offset = lseek(f, 0, SEEK_CUR);
+#endif
+  if (offset < 0 || offset >= m->end - m->begin)
+  {
+    deactivate();
+    return io_buf::fill(f);
+  }
+#ifdef _WIN32
+  _lseeki64(f, m->end - m->begin, SEEK_SET);
+#else
+  lseek(f, m->end - m->begin, SEEK_SET);
+#endif
+
+  if (active == -1)
+    owned = space;
+  active = f;
+  space.begin() = m->begin + offset;
+  space.end() = space.begin() + std::min(window, (size_t)(m->end - space.begin()));
+  space.end_array = space.end();
+  head = space.begin();
+  return space.end() - space.begin();
+}
+
+void mmap_io_buf::compact()
+{
+  if (active == -1)
+  {
+    io_buf::compact();
+    return;
+  }
+
+  space.begin() = head; // the consumed part of a mapping is never needed again
+#ifndef _WIN32
+  mapping* m = find(active);
+  char* consumed = m->begin + (head - m->begin) / page * page;
+  if (consumed > m->released)
+  {
+    madvise(m->released, consumed - m->released, MADV_DONTNEED);
+    m->released = consumed;
+  }
+#endif
+}
+
+bool mmap_io_buf::close_file()
+{
+  if (files.size() > 0)
+    unmap(files.last());
+  return io_buf::close_file();
+}
@@ -0,0 +1,49 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+ */
+#pragma once
+#include "io_buf.h"
+#include <vector>
+
+/* An input io_buf that memory maps regular files instead of read()ing them.  While a mapped file
+** is being consumed, space is a window into the read only mapping, so buf_read and readto hand out
+** pointers into the file; fill() moves the window's end forward and compact() its beginning,
+** dropping the pages behind it.  The last page of a file is read() into the io_buf's own buffer,
+** like sockets, pipes and files too small or failing to map, so a reader peeking one byte past a
+** line stays inside the mapping.  Readers writing into their lines (the json parsers) can't use it.
+*/
+class mmap_io_buf : public io_buf
+{
+  struct mapping
+  { int fd;
+    char* begin;
+    char* end;      // of the part read through the mapping, the start of the file's last page
+    size_t length;  // of the mapping, the file size
+    char* released; // the pages before this are dropped
+  };
+
+  std::vector<mapping> mappings;
+  v_array<char> owned; // the io_buf's own buffer, stashed while space points into a mapping
+  int active;          // the file space points into, or -1
+  size_t page;
+
+  mapping* find(int f);
+  void unmap(int f);
+  void deactivate();
+
+public:
+  mmap_io_buf();
+  virtual ~mmap_io_buf();
+
+  virtual int open_file(const char* name, bool stdin_off, int flag = READ);
+
+  virtual void reset_file(int f);
+
+  virtual ssize_t fill(int f);
+
+  virtual void compact();
+
+  virtual bool close_file();
+};
@@ -21,6 +21,7 @@ license as described in the file LICENSE.
 #include "sender.h"
 #include "nn.h"
 #include "gd.h"
+#include "accumulate.h"
 #include "cbify.h"
 #include "oaa.h"
 #include "boosting.h"
@@ -324,6 +325,8 @@ void parse_diagnostics(arguments& arg)
       (arg.all->audit, "audit,a", "print weights of features")
       ("progress,P", po::value< string >(), "Progress update frequency. int: additive, float: multiplicative")
       (arg.all->quiet, "quiet", "Don't output disgnostics and progress updates")
+      ("perf_stats", "Time reading, parsing, setup, learning and output of examples, reported at the end")
+      ("perf_stats_json", po::value<string>(&arg.all->perf_stats_json), "Also write those timings as JSON to this file")
       ("help,h","Look here: http://hunch.net/~vw/ and click on Tutorial.").missing())
     return;
 
@@ -333,6 +336,9 @@ void parse_diagnostics(arguments& arg)
     exit(0);
   }
 
+  if (arg.vm.count("perf_stats") || arg.vm.count("perf_stats_json"))
+    arg.all->perf = new perf_stats();
+
   if (arg.vm.count("progress") && !arg.all->quiet)
     {
       string progress_str = arg.vm["progress"].as<string>();
@@ -386,6 +392,9 @@ void parse_source(arguments& arg)
     ("foreground", "in persistent daemon mode, do not run in the background")
     ("port", po::value<size_t>(),"port to listen on; use 0 to pick unused port")
     ("num_children", arg.all->num_children, "number of children for persistent daemon mode")
+    ("daemon_threads", arg.all->daemon_threads, "in persistent daemon mode, serve any number of connections from <n> threads of one process instead of children, predicting only unless --snapshot_interval is given")
+    ("snapshot_interval", arg.all->snapshot_interval, "with --daemon_threads, learn from labeled requests on a copy of the weights of its own and publish it to the predictions every <n> examples learned")
+    ("snapshot_generations", po::value<size_t>(&arg.all->snapshot_generations)->default_value(2), "with --snapshot_interval, the most copies of the weights to keep for predictions, at least 2")
     ("pid_file", po::value< string >(), "Write pid file in persistent daemon mode")
     ("port_file", po::value< string >(), "Write port used in persistent daemon mode")
     ("cache,c", "Use a cache.  The default is <data>.cache")
@@ -393,7 +402,9 @@ void parse_source(arguments& arg)
     ("json", "Enable JSON parsing.")
     ("dsjson", "Enable Decision Service JSON parsing.")
     ("kill_cache,k", "do not reuse existing cache: create a new one always")
+    ("convert_cache", "rewrite an existing cache in the older varint format as columns, which read faster")
     ("compressed", "use gzip format whenever possible. If a cache file is being created, this option creates a compressed cache file. A mixture of raw-text & compressed inputs are supported with autodetection.")
+    ("mmap", "memory map input files instead of reading them into a buffer")
     (arg.all->stdin_off, "no_stdin", "do not default to reading from stdin").missing();
 
   // Be friendly: if -d was left out, treat positional param as data file
@@ -411,7 +422,9 @@ void parse_source(arguments& arg)
   if ( (arg.vm.count("total") || arg.vm.count("node") || arg.vm.count("unique_id")) && !(arg.vm.count("total") && arg.vm.count("node") && arg.vm.count("unique_id")) )
     THROW("you must specificy unique_id, total, and node if you specify any");
 
-  if (arg.vm.count("daemon") || arg.vm.count("pid_file") || (arg.vm.count("port") && !arg.all->active) )
+  if (arg.all->active)
+    arg.all->daemon_threads = 0;
+  if (arg.vm.count("daemon") || arg.vm.count("pid_file") || (arg.vm.count("port") && !arg.all->active) || arg.all->daemon_threads > 0)
   {
     arg.all->daemon = true;
     // allow each child to process up to 1e5 connections
@@ -423,6 +436,16 @@ void parse_source(arguments& arg)
 
   if (ends_with(arg.all->data_filename, ".gz"))
     set_compressed(arg.all->p);
+  else if (arg.vm.count("mmap") && !arg.vm.count("compressed"))
+  {
+    if (arg.vm.count("json") || arg.vm.count("dsjson"))
+    {
+      if (!arg.all->quiet)
+        arg.trace_message << "ignoring --mmap: the json parser writes into the lines it reads" << endl;
+    }
+    else
+      set_mmapped(arg.all->p);
+  }
 
   if ((arg.vm.count("cache") || arg.vm.count("cache_file")) && arg.vm.count("invert_hash"))
     THROW("invert_hash is incompatible with a cache file.  Use it in single pass mode only.");
@@ -979,6 +1002,10 @@ void parse_output_preds(arguments& arg)
       ("raw_predictions,r", po::value< string >(), "File to output unnormalized predictions to").missing())
     return;
 
+  // the learners of --learn_threads finish examples in whatever order they complete
+  if (arg.all->learn_threads > 1 && (arg.vm.count("predictions") || arg.vm.count("raw_predictions")))
+    THROW("error: --predictions and --raw_predictions would be written out of order with --learn_threads");
+
   if (arg.vm.count("predictions"))
   {
     if (!arg.all->quiet)
@@ -1195,6 +1222,7 @@ vw& parse_args(int argc, char *argv[], trace_message_t trace_listener, void* tra
 
     all.opts_n_args.new_options("VW options")
       ("ring_size", all.p->ring_size, "size of example ring")
+      ("parse_threads", all.p->parse_threads, "number of threads parsing text input in parallel")
       ("onethread", "Disable parse thread").missing();
 
     all.opts_n_args.new_options("Update options")
@@ -1212,23 +1240,32 @@ vw& parse_args(int argc, char *argv[], trace_message_t trace_listener, void* tra
       ("normal_weights", all.normal_weights, "make initial weights normal")
       ("truncated_normal_weights", all.tnormal_weights, "make initial weights truncated normal")
       (all.weights.sparse, "sparse_weights", "Use a sparse datastructure for weights")
+      ("prefetch_distance", all.prefetch_distance, "Prefetch the dense weights of features this many ahead of the one being processed, 0 to disable")
+      ("huge_pages", po::value<string>(), "Back dense weights with huge pages: transparent, 2M or 1G (falling back to smaller pages)")
       ("input_feature_regularizer", all.per_feature_regularizer_input, "Per feature regularization input file").missing();
 
     all.opts_n_args.new_options("Parallelization options")
       ("span_server", po::value<string>(), "Location of server for setting up spanning tree")
       ("threads", "Enable multi-threading")
+      ("learn_threads", all.learn_threads, "number of threads learning from the parsed examples, each updating the shared weights without locking (Hogwild)")
       ("unique_id", po::value<size_t>()->default_value(0), "unique id used for cluster parallel jobs")
       ("total", po::value<size_t>()->default_value(1), "total number of nodes used in cluster parallel job")
-      ("node", po::value<size_t>()->default_value(0), "node number in cluster parallel job").missing();
+      ("node", po::value<size_t>()->default_value(0), "node number in cluster parallel job")
+      ("allreduce_compression", po::value<string>(), "How plain averaging and bfgs syncs over a span_server are sent: dense (default), sparse (nonzero changes only), fp16 or int8 (quantized changes, rounding error carried to the next sync; bfgs stays exact)").missing();
 
     po::variables_map& vm = all.opts_n_args.vm;
 
+    if (vm.count("huge_pages"))
+      all.pages = parse_weight_pages(vm["huge_pages"].as<string>());
+
     if (vm.count("span_server"))
     {
       all.all_reduce_type = AllReduceType::Socket;
       all.all_reduce = new AllReduceSockets(vm["span_server"].as<string>(),
         vm["unique_id"].as<size_t>(), vm["total"].as<size_t>(), vm["node"].as<size_t>());
     }
+    if (vm.count("allreduce_compression"))
+      all.sync_encoding = parse_sync_encoding(vm["allreduce_compression"].as<string>());
     parse_diagnostics(all.opts_n_args);
 
     all.initial_t = (float)all.sd->t;
@@ -1267,6 +1304,7 @@ void parse_modules(vw& all, io_buf& model)
   int temp_argc = 0;
   char** temp_argv = VW::get_argv_from_string(all.opts_n_args.file_options->str(), temp_argc);
 
+  all.opts_n_args.model_args_begin = all.opts_n_args.args.size();
   if (interactions_settings_doubled)
   {
     //remove
@@ -1275,6 +1313,7 @@ void parse_modules(vw& all, io_buf& model)
   }
   else
     add_to_args(all, temp_argc, temp_argv);
+  all.opts_n_args.model_args_end = all.opts_n_args.args.size();
   for (int i = 0; i < temp_argc; i++)
     free(temp_argv[i]);
   free(temp_argv);
@@ -1418,10 +1457,9 @@ vw* initialize(string s, io_buf* model, bool skipModelLoad, trace_message_t trac
   return ret;
 }
 
-vw* initialize(int argc, char* argv[], io_buf* model, bool skipModelLoad, trace_message_t trace_listener, void* trace_context)
+// the rest of initialize, once the arguments are parsed
+static vw* initialize(vw& all, io_buf* model, bool skipModelLoad)
 {
-  vw& all = parse_args(argc, argv, trace_listener, trace_context);
-
   try
   {
     // if user doesn't pass in a model, read from arguments
@@ -1452,6 +1490,12 @@ vw* initialize(int argc, char* argv[], io_buf* model, bool skipModelLoad, trace_
   }
 }
 
+vw* initialize(int argc, char* argv[], io_buf* model, bool skipModelLoad, trace_message_t trace_listener, void* trace_context)
+{
+  vw& all = parse_args(argc, argv, trace_listener, trace_context);
+  return initialize(all, model, skipModelLoad);
+}
+
 // Create a new VW instance while sharing the model with another instance
 // The extra arguments will be appended to those of the other VW instance
 vw* seed_vw_model(vw* vw_model, const string extra_args, trace_message_t trace_listener, void* trace_context)
@@ -1481,6 +1525,79 @@ vw* seed_vw_model(vw* vw_model, const string extra_args, trace_message_t trace_l
   return new_model;
 }
 
+// Options that read input or write output.  The seeded learners of --learn_threads leave all of
+// that to the instance they were seeded from.
+static const char* const not_seeded[] = { "data", "daemon", "port", "pid_file", "cache", "cache_file", "kill_cache",
+  "compressed", "convert_cache", "mmap", "parse_threads", "passes", "final_regressor", "readable_model", "invert_hash", "save_per_pass",
+  "output_feature_regularizer_binary", "output_feature_regularizer_text", "predictions", "raw_predictions",
+  "audit_regressor", "span_server", "unique_id", "total", "node", "allreduce_compression", "learn_threads", "quiet",
+  "perf_stats", "perf_stats_json", "num_children", "daemon_threads", "snapshot_interval", "snapshot_generations", "foreground",
+  "port_file"
+};
+
+vw* seed_learner(vw& all)
+{
+  // An initial regressor is read again for the state the reductions keep in it.  Its weights are
+  // read over all's, which hold the same values as nothing is learned before the learners are
+  // seeded.  It brings its options along once more.
+  bool skip_model_load = all.opts_n_args.vm.count("initial_regressor") == 0;
+  vector<string> seed_args = all.opts_n_args.args;
+  if (!skip_model_load)
+    seed_args.erase(seed_args.begin() + all.opts_n_args.model_args_begin, seed_args.begin() + all.opts_n_args.model_args_end);
+
+  po::positional_options_description p;
+  p.add("data", -1);
+  po::parsed_options parsed = po::command_line_parser(seed_args).
+                              style(po::command_line_style::default_style ^ po::command_line_style::allow_guessing).
+                              options(all.opts_n_args.all_opts).positional(p).allow_unregistered().run();
+
+  std::ostringstream args;
+  args << "--quiet";
+  for (po::option& o : parsed.options)
+  {
+    if (find(begin(not_seeded), end(not_seeded), o.string_key) != end(not_seeded))
+      continue;
+    for (string& token : o.original_tokens)
+      args << " " << token;
+  }
+
+  // all's weights are in place before the model is loaded, so the learner allocates none of its own
+  int argc = 0;
+  char** argv = get_argv_from_string(args.str(), argc);
+  vw* learner = nullptr;
+  try
+  {
+    vw& seeded = parse_args(argc, argv);
+    seeded.weights.shallow_copy(all.weights);
+    learner = initialize(seeded, nullptr, skip_model_load);
+  }
+  catch (...)
+  {
+    free_args(argc, argv);
+    throw;
+  }
+  free_args(argc, argv);
+  free_it(learner->sd);
+
+  learner->sd = all.sd;
+  // the passes themselves are read by all, which has the cache a seeded learner would need
+  learner->numpasses = all.numpasses;
+  learner->holdout_set_off = all.holdout_set_off;
+  learner->perf = all.perf;
+  for (int f : all.final_prediction_sink)
+    learner->final_prediction_sink.push_back(f);
+  learner->raw_prediction = all.raw_prediction;
+  return learner;
+}
+
+void finish_learner(vw& learner)
+{
+  learner.final_prediction_sink.clear();
+  learner.raw_prediction = -1;
+  learner.perf = nullptr;
+  finish(learner);
+}
+
 void delete_dictionary_entry(substring ss, features* A)
 {
   free(ss.begin);
@@ -1556,6 +1673,21 @@ void finish(vw& all, bool delete_all)
     all.opts_n_args.trace_message << endl;
   }
 
+  if (all.perf != nullptr)
+  {
+    if (!all.quiet)
+      all.perf->report(all.opts_n_args.trace_message, all.sd->example_number, all.sd->total_features);
+    if (!all.perf_stats_json.empty())
+    {
+      ofstream json(all.perf_stats_json.c_str());
+      all.perf->write_json(json, all.sd->example_number, all.sd->total_features);
+      if (!json)
+        cerr << "can't write perf stats to " << all.perf_stats_json << endl;
+    }
+    delete all.perf;
+    all.perf = nullptr;
+  }
+
   // implement finally.
   // finalize_regressor can throw if it can't write the file.
   // we still want to free up all the memory.
@@ -1619,6 +1751,7 @@ void finish(vw& all, bool delete_all)
   delete all.loss;
 
   delete all.all_reduce;
+  delete all.sync;
 
   if (delete_all) delete &all;
 
@@ -2,6 +2,42 @@
 
 using dispatch_fptr = std::function<void(vw&, v_array<example*>&)>;
 
+// all.p->reader, timed as perf_parse less the time it waited for input
+inline int read_examples(vw& all, v_array<example*>& examples)
+{
+  if (all.perf == nullptr)
+    return all.p->reader(&all, examples);
+
+  uint64_t start = perf_stats::now();
+  uint64_t read = all.perf->ticks(perf_read);
+  int ret = all.p->reader(&all, examples);
+  all.perf->add(perf_parse, start, all.perf->ticks(perf_read) - read);
+  return ret;
+}
+
+// turns examples[0] into an end_pass example once the current pass is exhausted
+inline void parse_dispatch_end_pass(vw& all, v_array<example*>& examples, size_t& example_number, dispatch_fptr dispatch)
+{
+  reset_source(all, all.num_bits);
+  all.do_reset_source = false;
+  all.passes_complete++;
+
+  //setup an end_pass example
+  all.p->lp.default_label(&examples[0]->l);
+  examples[0]->end_pass = true;
+  all.p->in_pass_counter = 0;
+
+  if (all.passes_complete == all.numpasses && example_number == all.pass_length)
+  {
+    all.passes_complete = 0;
+    all.pass_length = all.pass_length*2+1;
+  }
+  dispatch(all, examples);//must be called before lock_done or race condition exists.
+  if (all.passes_complete >= all.numpasses && all.max_examples >= example_number)
+    lock_done(*all.p);
+  example_number = 0;
+}
+
 inline void parse_dispatch(vw& all, dispatch_fptr dispatch)
 {
   v_array<example*> examples = v_init<example*>();
@@ -12,33 +48,14 @@ inline void parse_dispatch(vw& all, dispatch_fptr dispatch)
     while(!all.p->done)
     {
       examples.push_back(&VW::get_unused_example(&all)); // need at least 1 example
-      if (!all.do_reset_source && example_number != all.pass_length && all.max_examples > example_number && all.p->reader(&all, examples) > 0)
+      if (!all.do_reset_source && example_number != all.pass_length && all.max_examples > example_number && read_examples(all, examples) > 0)
       {
         VW::setup_examples(all, examples);
         example_number+=examples.size();
         dispatch(all, examples);
       }
       else
-      {
-        reset_source(all, all.num_bits);
-        all.do_reset_source = false;
-        all.passes_complete++;
-
-        //setup an end_pass example
-        all.p->lp.default_label(&examples[0]->l);
-        examples[0]->end_pass = true;
-        all.p->in_pass_counter = 0;
-
-        if (all.passes_complete == all.numpasses && example_number == all.pass_length)
-        {
-          all.passes_complete = 0;
-          all.pass_length = all.pass_length*2+1;
-        }
-        dispatch(all, examples);//must be called before lock_done or race condition exists.
-        if (all.passes_complete >= all.numpasses && all.max_examples >= example_number)
-          lock_done(*all.p);
-        example_number = 0;
-      }
+        parse_dispatch_end_pass(all, examples, example_number, dispatch);
 
       examples.clear();
     }
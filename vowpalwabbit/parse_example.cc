@@ -11,6 +11,7 @@ license as described in the file LICENSE.
 #include "unique_sort.h"
 #include "global_data.h"
 #include "constant.h"
+#include "delimiter_scan.h"
 
 using namespace std;
 
@@ -70,6 +71,7 @@ public:
   bool* spelling_features;
   v_array<char> spelling;
   uint32_t hash_seed;
+  delimiter_scan::scanner delimiters;
 
   vector<feature_dict*>* namespace_dictionaries;
 
@@ -116,8 +118,7 @@ public:
   {
     substring ret;
     ret.begin = reading_head;
-    while( !(*reading_head == ' ' || *reading_head == ':' || *reading_head == '\t' || *reading_head == '|' || reading_head == endLine || *reading_head == '\r' ))
-      ++reading_head;
+    reading_head = delimiters.next(reading_head); // the first ' ', ':', '\t', '|', '\r' or endLine
     ret.end = reading_head;
 
     return ret;
@@ -388,6 +389,7 @@ public:
       this->namespace_dictionaries = all.namespace_dictionaries;
       this->base = nullptr;
       this->hash_seed = all.hash_seed;
+      delimiters.start(reading_head, endLine);
       listNameSpace();
       if (base != nullptr)
         free(base);
@@ -395,7 +397,7 @@ public:
   }
 };
 
-void substring_to_example(vw* all, example* ae, substring example)
+void substring_to_label(vw* all, example* ae, substring example)
 {
   all->p->lp.default_label(&ae->l);
   char* bar_location = safe_index(example.begin, '|', example.end);
@@ -429,13 +431,22 @@ void substring_to_example(vw* all, example* ae, substring example)
 
   if (all->p->words.size() > 0)
     all->p->lp.parse_label(all->p, all->sd, &ae->l, all->p->words);
+}
 
+void substring_to_features(vw* all, example* ae, substring example)
+{
+  char* bar_location = safe_index(example.begin, '|', example.end);
   if (all->audit || all->hash_inv)
     TC_parser<true> parser_line(bar_location,example.end,*all,ae);
   else
     TC_parser<false> parser_line(bar_location,example.end,*all,ae);
 }
 
+void substring_to_example(vw* all, example* ae, substring example)
+{
+  substring_to_label(all, ae, example);
+  substring_to_features(all, ae, example);
+}
 
 namespace VW
 {
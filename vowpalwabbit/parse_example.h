@@ -16,10 +16,15 @@ typedef enum
 } FeatureInputType;
 
 void substring_to_example(vw* all, example* ae, substring example);
+// substring_to_example split in two: the label and tag use the parser's shared scratch space and
+// shared_data, while the features only read global state and may be parsed on a worker thread.
+void substring_to_label(vw* all, example* ae, substring example);
+void substring_to_features(vw* all, example* ae, substring example);
 
 namespace VW
 {
 example& get_unused_example(vw* all);
+bool unused_example_available(parser* p);//true if get_unused_example would not have to wait
 void read_line(vw& all, example* ex, char* line);//read example from the line.
 }
 
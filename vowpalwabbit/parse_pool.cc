@@ -0,0 +1,343 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD (revised)
+license as described in the file LICENSE.
+ */
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "parse_pool.h"
+
+using namespace std;
+
+/* The parse thread reads input lines, reserves one ring example per line (in input order) and
+** collects them into chunks.  Full chunks are handed to the workers, which parse the features.
+** A parsed chunk is committed only once every chunk submitted before it has been committed:
+** committing parses the label and tag, runs setup_example and publishes the examples, exactly as
+** the single threaded parser would have done.
+*/
+
+struct parse_chunk
+{
+  v_array<char> text;         // copies of the lines, io_buf moves its buffer on refill
+  v_array<size_t> line_ends;  // offset of the '\0' terminating each line in text
+  v_array<example*> examples; // the ring example reserved for each line
+  bool parsed;
+  exception_ptr error;
+
+  substring line(size_t i)
+  {
+    size_t begin = i == 0 ? 0 : line_ends[i-1] + 1;
+    substring ret = { text.begin() + begin, text.begin() + line_ends[i] };
+    return ret;
+  }
+
+  void clear()
+  {
+    text.clear();
+    line_ends.clear();
+    examples.clear();
+    parsed = false;
+    error = nullptr;
+  }
+};
+
+struct parse_pool
+{
+  vw* all;
+  dispatch_fptr dispatch;
+  size_t chunk_lines;
+
+  mutex lock; // protects everything below up to commit_lock
+  condition_variable work_available;
+  condition_variable chunk_committed;
+  deque<parse_chunk*> work;
+  deque<parse_chunk*> in_flight; // submitted and not yet committed, in input order
+  v_array<parse_chunk*> free_chunks;
+  exception_ptr error;
+  bool stopping;
+
+  mutex commit_lock; // serializes commits, guards the label parser scratch space in all->p
+  v_array<example*> publish;
+
+  v_array<parse_chunk*> chunks;
+  vector<thread> workers;
+};
+
+static void commit_chunk(parse_pool& pool, parse_chunk& c)
+{
+  vw& all = *pool.all;
+  for (size_t i = 0; i < c.examples.size(); i++)
+  {
+    { // the worker parsing the features counted the example's call
+      perf_timer timer(all.perf, perf_parse, 0);
+      substring_to_label(&all, c.examples[i], c.line(i));
+    }
+    VW::setup_example(all, c.examples[i]);
+    pool.publish.clear();
+    pool.publish.push_back(c.examples[i]);
+    pool.dispatch(all, pool.publish);
+  }
+}
+
+// commits parsed chunks from the front of in_flight until one is still being parsed
+static void commit_parsed_chunks(parse_pool& pool)
+{
+  lock_guard<mutex> serial(pool.commit_lock);
+  exception_ptr error = nullptr;
+  while (true)
+  {
+    parse_chunk* c;
+    {
+      lock_guard<mutex> l(pool.lock);
+      if (pool.in_flight.empty() || !pool.in_flight.front()->parsed)
+        return;
+      c = pool.in_flight.front();
+      error = pool.error;
+    }
+
+    if (error == nullptr)
+      try
+      {
+        if (c->error != nullptr)
+          rethrow_exception(c->error);
+        commit_chunk(pool, *c);
+      }
+      catch (...)
+      {
+        error = current_exception();
+      }
+
+    {
+      lock_guard<mutex> l(pool.lock);
+      pool.in_flight.pop_front();
+      pool.error = error;
+      c->clear();
+      pool.free_chunks.push_back(c);
+    }
+    pool.chunk_committed.notify_all();
+  }
+}
+
+static void parse_worker(parse_pool* pool)
+{
+  vw& all = *pool->all;
+  while (true)
+  {
+    parse_chunk* c;
+    {
+      unique_lock<mutex> l(pool->lock);
+      pool->work_available.wait(l, [pool] { return pool->stopping || !pool->work.empty(); });
+      if (pool->work.empty())
+        return;
+      c = pool->work.front();
+      pool->work.pop_front();
+    }
+
+    try
+    {
+      // one call per example, as without --parse_threads
+      perf_timer timer(all.perf, perf_parse, c->examples.size());
+      for (size_t i = 0; i < c->examples.size(); i++)
+        substring_to_features(&all, c->examples[i], c->line(i));
+    }
+    catch (...)
+    {
+      c->error = current_exception();
+    }
+
+    {
+      lock_guard<mutex> l(pool->lock);
+      c->parsed = true;
+    }
+    commit_parsed_chunks(*pool);
+  }
+}
+
+static void start_pool(parse_pool& pool, vw& all, dispatch_fptr dispatch)
+{
+  size_t num_threads = all.p->parse_threads;
+  size_t num_chunks = 2 * num_threads;
+
+  pool.all = &all;
+  pool.dispatch = dispatch;
+  // every chunk in flight must fit in the ring, or the parse thread starves the workers
+  pool.chunk_lines = max((size_t)1, min((size_t)64, all.p->ring_size / num_chunks));
+  pool.free_chunks = v_init<parse_chunk*>();
+  pool.publish = v_init<example*>();
+  pool.chunks = v_init<parse_chunk*>();
+  pool.error = nullptr;
+  pool.stopping = false;
+
+  for (size_t i = 0; i < num_chunks; i++)
+  {
+    parse_chunk* c = new parse_chunk;
+    c->text = v_init<char>();
+    c->line_ends = v_init<size_t>();
+    c->examples = v_init<example*>();
+    c->clear();
+    pool.chunks.push_back(c);
+    pool.free_chunks.push_back(c);
+  }
+
+  for (size_t i = 0; i < num_threads; i++)
+    pool.workers.push_back(thread(parse_worker, &pool));
+}
+
+static void stop_pool(parse_pool& pool)
+{
+  {
+    lock_guard<mutex> l(pool.lock);
+    pool.stopping = true;
+  }
+  pool.work_available.notify_all();
+  for (thread& t : pool.workers)
+    t.join();
+
+  for (parse_chunk* c : pool.chunks)
+  {
+    c->text.delete_v();
+    c->line_ends.delete_v();
+    c->examples.delete_v();
+    delete c;
+  }
+  pool.chunks.delete_v();
+  pool.free_chunks.delete_v();
+  pool.publish.delete_v();
+}
+
+static parse_chunk* acquire_chunk(parse_pool& pool)
+{
+  unique_lock<mutex> l(pool.lock);
+  pool.chunk_committed.wait(l, [&pool] { return pool.free_chunks.size() > 0 || pool.error != nullptr; });
+  if (pool.error != nullptr)
+    rethrow_exception(pool.error);
+  return pool.free_chunks.pop();
+}
+
+static void submit_chunk(parse_pool& pool, parse_chunk*& c)
+{
+  if (c == nullptr || c->examples.size() == 0)
+    return;
+  {
+    lock_guard<mutex> l(pool.lock);
+    pool.in_flight.push_back(c);
+    pool.work.push_back(c);
+  }
+  pool.work_available.notify_one();
+  c = nullptr;
+}
+
+// waits until every submitted chunk has been committed
+static void drain_pool(parse_pool& pool)
+{
+  unique_lock<mutex> l(pool.lock);
+  pool.chunk_committed.wait(l, [&pool] { return pool.in_flight.empty() || pool.error != nullptr; });
+  if (pool.error != nullptr)
+    rethrow_exception(pool.error);
+}
+
+// copies the next input line into the chunk, returns false at the end of the input
+static bool read_line(vw& all, parse_chunk& c)
+{
+  char* line;
+  size_t num_chars;
+  if (read_features(&all, line, num_chars) < 1)
+    return false;
+  push_many(c.text, line, num_chars);
+  c.text.push_back('\0');
+  c.line_ends.push_back(c.text.size() - 1);
+  return true;
+}
+
+void parse_dispatch_pool(vw& all, dispatch_fptr dispatch)
+{
+  parse_pool pool;
+  start_pool(pool, all, dispatch);
+
+  v_array<example*> examples = v_init<example*>();
+  size_t example_number = 0;  // for variable-size batch learning algorithms
+  parse_chunk* c = nullptr;
+
+  try
+  {
+    while(!all.p->done)
+    {
+      // Submit a partial chunk instead of blocking while holding it: when the ring is full the
+      // learner may be waiting for exactly these examples, and when the input buffer is empty
+      // the next read may wait on an interactive source such as stdin or a daemon socket.
+      if (c != nullptr && (!VW::unused_example_available(all.p) || all.p->input->head == all.p->input->space.end()))
+        submit_chunk(pool, c);
+
+      examples.push_back(&VW::get_unused_example(&all)); // need at least 1 example
+      if (!all.do_reset_source && example_number != all.pass_length && all.max_examples > example_number)
+      {
+        if (all.p->reader == read_features_string)
+        {
+          if (c == nullptr)
+            c = acquire_chunk(pool);
+          if (read_line(all, *c))
+          {
+            c->examples.push_back(examples[0]);
+            example_number++;
+            if (c->examples.size() >= pool.chunk_lines)
+              submit_chunk(pool, c);
+            examples.clear();
+            continue;
+          }
+        }
+        else if (read_examples(all, examples) > 0)
+        {
+          VW::setup_examples(all, examples);
+          example_number+=examples.size();
+          dispatch(all, examples);
+          examples.clear();
+          continue;
+        }
+      }
+
+      submit_chunk(pool, c);
+      drain_pool(pool);
+      parse_dispatch_end_pass(all, examples, example_number, dispatch);
+      examples.clear();
+    }
+  }
+  catch (VW::vw_exception& e)
+  {
+    std::cerr << "vw example #" << example_number << "(" << e.Filename() << ":" << e.LineNumber() << "): " << e.what() << std::endl;
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "vw: example #" << example_number << e.what() << std::endl;
+  }
+  stop_pool(pool); // before lock_done, so that nothing is published after the learner is told we are done
+  lock_done(*all.p);
+  examples.delete_v();
+}
+
+bool parse_pool_supported(vw& all, bool quiet)
+{
+  if (all.p->parse_threads <= 1)
+    return false;
+
+  const char* reason = nullptr;
+  if (all.opts_n_args.vm.count("onethread"))
+    reason = "--onethread parses on the learning thread";
+  else if (all.p->reader != read_features_string)
+    reason = "only text input is parsed in parallel";
+  else if (all.loaded_dictionaries.size() > 0)
+    reason = "dictionary lookups are not thread safe";
+
+  if (reason != nullptr)
+  {
+    if (!quiet)
+      all.opts_n_args.trace_message << "ignoring --parse_threads: " << reason << endl;
+    all.p->parse_threads = 1;
+    return false;
+  }
+  return true;
+}
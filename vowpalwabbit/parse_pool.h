@@ -0,0 +1,18 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+ */
+#pragma once
+#include "global_data.h"
+#include "parser.h"
+#include "parse_example.h"
+#include "parse_dispatch_loop.h"
+
+// Parallel counterpart of parse_dispatch, used when --parse_threads > 1.  Text input is split
+// into line-aligned chunks whose features are parsed by a pool of worker threads; labels and
+// setup_example are applied in input order so the learner sees the same example sequence.
+void parse_dispatch_pool(vw& all, dispatch_fptr dispatch);
+
+// Returns false (after saying why) when the configured input cannot be parsed in parallel.
+bool parse_pool_supported(vw& all, bool quiet);
@@ -16,6 +16,17 @@ license as described in the file LICENSE.
 #include "hash.h"
 #include "vw_exception.h"
 
+float pow10_table[pow10_max - pow10_min + 1];
+
+static bool fill_pow10_table()
+{
+  for (int e = pow10_min; e <= pow10_max; e++)
+    pow10_table[e - pow10_min] = powf(10, (float)e);
+  return true;
+}
+
+static bool pow10_table_filled = fill_pow10_table();
+
 bool substring_equal(const substring& a, const substring& b)
 {
   return (a.end - a.begin == b.end - b.begin) // same length
@@ -7,6 +7,7 @@ license as described in the file LICENSE.
 #include <iostream>
 #include <stdint.h>
 #include <math.h>
+#include <string.h>
 #include "v_array.h"
 #include "floatbits.h"
 
@@ -34,9 +35,8 @@ void tokenize(char delim, substring s, v_array<substring> &ret, bool allow_empty
 bool substring_equal(const substring&a, const substring&b);
 
 inline char* safe_index(char *start, char v, char *max)
-{ while (start != max && *start != v)
-    start++;
-  return start;
+{ char* found = (char*)memchr(start, v, max - start);
+  return found != nullptr ? found : max;
 }
 
 inline void print_substring(substring s)
@@ -56,6 +56,19 @@ typedef uint64_t (*hash_func_t)(substring, uint64_t);
 
 hash_func_t getHasher(const std::string& s);
 
+// powf(10, e) for the exponents parseFloat meets, computed once
+const int pow10_min = -80;
+const int pow10_max = 40;
+extern float pow10_table[pow10_max - pow10_min + 1];
+
+inline float pow10_lookup(int e)
+{ return e >= pow10_min && e <= pow10_max ? pow10_table[e - pow10_min] : powf(10, (float)e);
+}
+
+// below this many, digits * 10 + '9' is still at most 2^24, an integer a float holds exactly, so
+// digits can be gathered in an integer and give the same float as gathering them in one
+const uint32_t float_exact_digits = (1u << 24) / 10;
+
 // The following function is a home made strtof. The
 // differences are :
 //  - much faster (around 50% but depends on the string to parse)
@@ -76,13 +89,24 @@ inline float parseFloat(char * p, char **end, char * endLine = nullptr)
   { s = -1; p++;
   }
 
-  float acc = 0;
+  uint32_t digits = 0;
+  while (*p >= '0' && *p <= '9' && (endLine_is_null || p < endLine) && digits < float_exact_digits)
+    digits = digits * 10 + (*p++ - '0');
+  float acc = (float)digits;
   while (*p >= '0' && *p <= '9' && (endLine_is_null || p < endLine))
     acc = acc * 10 + *p++ - '0';
 
   int num_dec = 0;
   if (*p == '.')
-  { while (*(++p) >= '0' && *p <= '9' && (endLine_is_null || p < endLine))
+  { p++;
+    if (digits < float_exact_digits)
+    { while (*p >= '0' && *p <= '9' && (endLine_is_null || p < endLine) && digits < float_exact_digits && num_dec < 35)
+      { digits = digits * 10 + (*p++ - '0');
+        num_dec++;
+      }
+      acc = (float)digits;
+    }
+    for (; *p >= '0' && *p <= '9' && (endLine_is_null || p < endLine); p++)
     { if (num_dec < 35)
       { acc = acc *10 + (*p - '0');
         num_dec++;
@@ -103,7 +127,7 @@ inline float parseFloat(char * p, char **end, char * endLine = nullptr)
 
   }
   if (*p == ' ' || *p == '\n' || *p == '\t' || p == endLine)//easy case succeeded.
-  { acc *= powf(10,(float)(exp_acc-num_dec));
+  { acc *= pow10_lookup(exp_acc-num_dec);
     *end = p;
     return s * acc;
   }
@@ -87,6 +87,12 @@ template<class T> double calculate_sd(vw& all,T& weights)
   double sq_sum = inner_product(diff.begin(), diff.end(), diff.begin(), 0.0);
   return sqrt(sq_sum / my_size);
 }
+template<class T> void construct_weights(vw&, T& weights, size_t length, uint32_t stride_shift)
+{ new(&weights) T(length, stride_shift); }
+
+void construct_weights(vw& all, dense_parameters& weights, size_t length, uint32_t stride_shift)
+{ new(&weights) dense_parameters(length, stride_shift, all.pages); }
+
 template<class T> void initialize_regressor(vw& all, T& weights)
 {
   // Regressor is already initialized.
@@ -98,7 +104,7 @@ template<class T> void initialize_regressor(vw& all, T& weights)
   {
     uint32_t ss = weights.stride_shift();
     weights.~T();//dealloc so that we can realloc, now with a known size
-    new(&weights) T(length, ss);
+    construct_weights(all, weights, length, ss);
   }
   catch (const VW::vw_exception&)
   {
@@ -128,7 +134,13 @@ void initialize_regressor(vw& all)
   if (all.weights.sparse)
     initialize_regressor(all, all.weights.sparse_weights);
   else
+  {
+    bool allocated = !all.weights.dense_weights.not_null();
     initialize_regressor(all, all.weights.dense_weights);
+    all.weights.dense_weights.prefetch_distance(all.prefetch_distance);
+    if (allocated && all.pages != small_pages && !all.quiet)
+      all.opts_n_args.trace_message << "weights on " << weight_pages_description(all.weights.dense_weights.pages()) << endl;
+  }
 }
 
 const size_t default_buf_size = 512;
@@ -43,6 +43,12 @@ int getpid()
 #include <errno.h>
 #include <stdio.h>
 #include <assert.h>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define VW_CPU_RELAX() _mm_pause()
+#else
+#define VW_CPU_RELAX()
+#endif
 namespace po = boost::program_options;
 
 #include "parse_example.h"
@@ -54,6 +60,8 @@ namespace po = boost::program_options;
 #include "vw_exception.h"
 #include "parse_example_json.h"
 #include "parse_dispatch_loop.h"
+#include "parse_pool.h"
+#include "mmap_io.h"
 
 using namespace std;
 
@@ -129,6 +137,45 @@ void condition_variable_signal_all(CV * pcv)
 #endif
 }
 
+void initialize_ring_waiter(ring_waiter& w)
+{
+  w.parked = false;
+  initialize_mutex(&w.lock);
+  initialize_condition_variable(&w.cv);
+}
+
+// How often a waiter polls the ring before parking.  The parser and learner usually run within a
+// few examples of each other, so most waits end while spinning and never enter the kernel.
+const size_t ring_spin_count = 1 << 10;
+
+template<class F> void spin_then_park(ring_waiter& w, F ready)
+{
+  for (size_t i = 0; i < ring_spin_count; i++)
+  {
+    if (ready())
+      return;
+    VW_CPU_RELAX();
+  }
+
+  mutex_lock(&w.lock);
+  w.parked = true; // must be visible before ready() is rechecked, pairs with wake()
+  while (!ready())
+    condition_variable_wait(&w.cv, &w.lock);
+  w.parked = false;
+  mutex_unlock(&w.lock);
+}
+
+// call after making the condition of the matching spin_then_park true
+void wake(ring_waiter& w)
+{
+  if (w.parked)
+  {
+    mutex_lock(&w.lock);
+    condition_variable_signal_all(&w.cv);
+    mutex_unlock(&w.lock);
+  }
+}
+
 //This should not? matter in a library mode.
 bool got_sigterm;
 
@@ -154,6 +201,7 @@ parser* new_parser()
   ret.local_example_number = 0;
   ret.in_pass_counter = 0;
   ret.ring_size = 1 << 8;
+  ret.parse_threads = 1;
   ret.done = false;
   ret.used_index = 0;
   ret.jsonp = nullptr;
@@ -168,7 +216,14 @@ void set_compressed(parser* par)
   par->output = new comp_io_buf;
 }
 
-uint32_t cache_numbits(io_buf* buf, int filepointer)
+void set_mmapped(parser* par)
+{
+  finalize_source(par);
+  par->input = new mmap_io_buf;
+  par->output = new io_buf;
+}
+
+uint32_t cache_numbits(io_buf* buf, int filepointer, char* format = nullptr)
 {
   v_array<char> t = v_init<char>();
 
@@ -199,8 +254,10 @@ uint32_t cache_numbits(io_buf* buf, int filepointer)
     if (buf->read_file(filepointer, &temp, 1) < 1)
       THROW("failed to read");
 
-    if (temp != 'c')
+    if (temp != cache_varint_format && temp != cache_columns_format)
       THROW("data file is not a cache file");
+    if (format != nullptr)
+      *format = temp;
   }
   catch(...)
   {
@@ -250,17 +307,15 @@ void reset_source(vw& all, size_t numbits)
           io_buf::close_file_or_socket(fd);
       }
     input->open_file(all.p->output->finalname.begin(), all.stdin_off, io_buf::READ); //pushing is merged into open_file
-    all.p->reader = read_cached_features;
+    all.p->reader = read_cached_columns;
   }
   if ( all.p->resettable == true )
   {
     if (all.daemon)
     {
       // wait for all predictions to be sent back to client
-      mutex_lock(&all.p->output_lock);
-      while (all.p->local_example_number != all.p->end_parsed_examples)
-        condition_variable_wait(&all.p->output_done, &all.p->output_lock);
-      mutex_unlock(&all.p->output_lock);
+      parser* p = all.p;
+      spin_then_park(p->output_done, [p] { return p->local_example_number == p->end_parsed_examples; });
 
       // close socket, erase final prediction sink and socket
       io_buf::close_file_or_socket(all.p->input->files[0]);
@@ -325,6 +380,59 @@ void finalize_source(parser* p)
   }
 }
 
+void write_cache_header(io_buf& output, int f, uint32_t numbits)
+{
+  size_t v_length = (uint64_t)version.to_string().length()+1;
+
+  output.write_file(f, &v_length, sizeof(v_length));
+  output.write_file(f,version.to_string().c_str(),v_length);
+  output.write_file(f,&cache_columns_format,1);
+  output.write_file(f, &numbits, sizeof(numbits));
+}
+
+// Rewrites a cache file made in the varint format as columns, in place of the file opened last
+// by the input, and returns the descriptor of the rewritten file.  Only with --convert_cache: the
+// varint format is still read as it is.
+int convert_cache_file(vw& all, string& name, uint32_t numbits, bool quiet)
+{
+  if (!quiet)
+    all.opts_n_args.trace_message << "converting cache_file = " << name << " to columns" << endl;
+
+  io_buf* input = all.p->input;
+  io_buf* from = input->compressed() ? new comp_io_buf : new io_buf;
+  io_buf* to = input->compressed() ? new comp_io_buf : new io_buf;
+  string temp = name+string(".writing");
+  try
+  {
+    int f = from->open_file(name.c_str(), all.stdin_off, io_buf::READ);
+    cache_numbits(from, f);
+    f = to->open_file(temp.c_str(), all.stdin_off, io_buf::WRITE);
+    if (f == -1)
+      THROW("can't create cache file: " << temp);
+    write_cache_header(*to, f, numbits);
+    convert_cache(all, *from, *to);
+  }
+  catch (...)
+  {
+    delete from;
+    delete to;
+    throw;
+  }
+  from->close_files();
+  to->close_files();
+  delete from;
+  delete to;
+
+  input->close_file();
+  remove(name.c_str());
+  if (0 != rename(temp.c_str(), name.c_str()))
+    THROW("convert_cache_file cannot rename: " << temp << " to " << name);
+
+  int f = input->open_file(name.c_str(), all.stdin_off, io_buf::READ);
+  cache_numbits(input, f);
+  return f;
+}
+
 void make_write_cache(vw& all, string &newname, bool quiet)
 {
   io_buf* output = all.p->output;
@@ -344,12 +452,7 @@ void make_write_cache(vw& all, string &newname, bool quiet)
     return;
   }
 
-  size_t v_length = (uint64_t)version.to_string().length()+1;
-
-  output->write_file(f, &v_length, sizeof(v_length));
-  output->write_file(f,version.to_string().c_str(),v_length);
-  output->write_file(f,"c",1);
-  output->write_file(f, &all.num_bits, sizeof(all.num_bits));
+  write_cache_header(*output, f, all.num_bits);
 
   push_many(output->finalname,newname.c_str(),newname.length()+1);
   all.p->write_cache = true;
@@ -368,6 +471,7 @@ void parse_cache(vw& all, po::variables_map &vm, string source,
 
   all.p->write_cache = false;
 
+  int (*cache_reader)(vw*, v_array<example*>&) = nullptr; // of the caches read so far
   for (size_t i = 0; i < caches.size(); i++)
   {
     int f = -1;
@@ -381,7 +485,8 @@ void parse_cache(vw& all, po::variables_map &vm, string source,
       make_write_cache(all, caches[i], quiet);
     else
     {
-      uint64_t c = cache_numbits(all.p->input, f);
+      char format = cache_columns_format;
+      uint64_t c = cache_numbits(all.p->input, f, &format);
       if (c < all.num_bits)
       {
         if (!quiet)
@@ -391,9 +496,17 @@ void parse_cache(vw& all, po::variables_map &vm, string source,
       }
       else
       {
+        if (format == cache_varint_format && vm.count("convert_cache"))
+        {
+          convert_cache_file(all, caches[i], (uint32_t)c, quiet);
+          format = cache_columns_format;
+        }
+        int (*reader)(vw*, v_array<example*>&) = format == cache_varint_format ? read_cached_features : read_cached_columns;
+        if (cache_reader != nullptr && cache_reader != reader)
+          THROW("cache files in both the varint and the columns format: try --convert_cache");
         if (!quiet)
           all.opts_n_args.trace_message << "using cache_file = " << caches[i].c_str() << endl;
-        all.p->reader = read_cached_features;
+        cache_reader = all.p->reader = reader;
         if (c == all.num_bits)
           all.p->sorted_cache = true;
         else
@@ -461,7 +574,7 @@ void enable_sources(vw& all, bool quiet, size_t passes)
       THROWERRNO("bind");
 
     // listen on socket
-    if (listen(all.p->bound_sock, 1) < 0)
+    if (listen(all.p->bound_sock, all.daemon_threads > 0 ? SOMAXCONN : 1) < 0)
       THROWERRNO("listen");
 
     // write port file
@@ -500,6 +613,10 @@ void enable_sources(vw& all, bool quiet, size_t passes)
       pid_file.close();
     }
 
+    // serve_daemon_threads takes the connections from here
+    if (all.daemon_threads > 0)
+      return;
+
     if (all.daemon && !all.active)
     {
 #ifdef _WIN32
@@ -668,17 +785,19 @@ child:
     THROW("need a cache file for multiple passes : try using --cache_file");
 
   all.p->input->count = all.p->input->files.size();
+  all.p->input->perf = all.perf;
   if (!quiet && !all.daemon)
     all.opts_n_args.trace_message << "num sources = " << all.p->input->files.size() << endl;
+
+  if (parse_pool_supported(all, quiet) && !quiet)
+    all.opts_n_args.trace_message << "parse threads = " << all.p->parse_threads << endl;
 }
 
 void lock_done(parser& p)
 {
-  mutex_lock(&p.examples_lock);
   p.done = true;
   //in case get_example() is waiting for a fresh example, wake so it can realize there are no more.
-  condition_variable_signal_all(&p.example_available);
-  mutex_unlock(&p.examples_lock);
+  wake(p.example_available);
 }
 
 void set_done(vw& all)
@@ -771,20 +890,20 @@ namespace VW
 example& get_unused_example(vw* all)
 {
   parser* p = all->p;
-  while (true)
-  {
-    mutex_lock(&p->examples_lock);
-    if (p->examples[p->begin_parsed_examples % p->ring_size].in_use == false)
-    {
-      example& ret = p->examples[p->begin_parsed_examples++ % p->ring_size];
-      ret.in_use = true;
-      mutex_unlock(&p->examples_lock);
-      return ret;
-    }
-    else
-      condition_variable_wait(&p->example_unused, &p->examples_lock);
-    mutex_unlock(&p->examples_lock);
-  }
+  size_t ring_index = p->begin_parsed_examples++ % p->ring_size;
+  std::atomic<bool>& in_use = p->ring_in_use[ring_index];
+  if (in_use)
+    spin_then_park(p->example_unused, [&in_use] { return !in_use; });
+  in_use = true;
+
+  example& ret = p->examples[ring_index];
+  ret.in_use = true;
+  return ret;
+}
+
+bool unused_example_available(parser* p)
+{
+  return !p->ring_in_use[p->begin_parsed_examples % p->ring_size];
 }
 
 void setup_examples(vw& all, v_array<example*>& examples)
@@ -795,13 +914,14 @@ void setup_examples(vw& all, v_array<example*>& examples)
 
 void setup_example(vw& all, example* ae)
 {
+  perf_timer timer(all.perf, perf_setup);
   if (all.p->sort_features && ae->sorted == false)
     unique_sort_features(all.parse_mask, ae);
 
   if (all.p->write_cache)
   {
     all.p->lp.cache_label(&ae->l, *(all.p->output));
-    cache_features(*(all.p->output), ae, all.parse_mask);
+    cache_columns(*(all.p->output), ae, all.parse_mask);
   }
 
   ae->partial_prediction = 0.;
@@ -993,29 +1113,24 @@ void finish_example(vw& all, example& ec)
   if (!is_ring_example(all, &ec))
     return;
 
-  mutex_lock(&all.p->output_lock);
   all.p->local_example_number++;
-  condition_variable_signal(&all.p->output_done);
-  mutex_unlock(&all.p->output_lock);
+  wake(all.p->output_done);
 
   empty_example(all, ec);
 
-  mutex_lock(&all.p->examples_lock);
   assert(ec.in_use);
   ec.in_use = false;
-  condition_variable_signal(&all.p->example_unused);
+  all.p->ring_in_use[&ec - all.p->examples] = false;
+  wake(all.p->example_unused);
   if (all.p->done)
-    condition_variable_signal_all(&all.p->example_available);
-  mutex_unlock(&all.p->examples_lock);
+    wake(all.p->example_available);
 }
 }
 
 void thread_dispatch(vw& all, v_array<example*> examples)
 {
-  mutex_lock(&all.p->examples_lock);
   all.p->end_parsed_examples+=examples.size();
-  condition_variable_signal_all(&all.p->example_available);
-  mutex_unlock(&all.p->examples_lock);
+  wake(all.p->example_available);
 }
 
 #ifdef _WIN32
@@ -1025,7 +1140,10 @@ void *main_parse_loop(void *in)
 #endif
 {
   vw* all = (vw*)in;
-  parse_dispatch(*all, thread_dispatch);
+  if (all->p->parse_threads > 1)
+    parse_dispatch_pool(*all, thread_dispatch);
+  else
+    parse_dispatch(*all, thread_dispatch);
   return 0L;
 }
 
@@ -1033,30 +1151,20 @@ namespace VW
 {
 example* get_example(parser* p)
 {
-  mutex_lock(&p->examples_lock);
-  if (p->end_parsed_examples != p->used_index)
-  {
-    size_t ring_index = p->used_index++ % p->ring_size;
-    if (!(p->examples+ring_index)->in_use)
-      cout << "error: example should be in_use " << p->used_index << " " << p->end_parsed_examples << " " << ring_index << endl;
-    assert((p->examples+ring_index)->in_use);
-    mutex_unlock(&p->examples_lock);
-    return p->examples + ring_index;
-  }
-  else
+  // only read the shared end_parsed_examples once the examples published at the last look are consumed
+  if (p->used_index == p->parsed_seen)
   {
-    if (!p->done)
-    {
-      condition_variable_wait(&p->example_available, &p->examples_lock);
-      mutex_unlock(&p->examples_lock);
-      return get_example(p);
-    }
-    else
-    {
-      mutex_unlock(&p->examples_lock);
+    spin_then_park(p->example_available, [p] { return p->end_parsed_examples != p->used_index || p->done; });
+    p->parsed_seen = p->end_parsed_examples;
+    if (p->used_index == p->parsed_seen)
       return nullptr;
-    }
   }
+
+  size_t ring_index = p->used_index++ % p->ring_size;
+  if (!(p->examples+ring_index)->in_use)
+    cout << "error: example should be in_use " << p->used_index << " " << p->parsed_seen << " " << ring_index << endl;
+  assert((p->examples+ring_index)->in_use);
+  return p->examples + ring_index;
 }
 
 float get_topic_prediction(example* ec, size_t i)
@@ -1127,32 +1235,34 @@ float get_confidence(example* ec)
 void initialize_examples(vw& all)
 {
   all.p->used_index = 0;
+  all.p->parsed_seen = 0;
   all.p->begin_parsed_examples = 0;
   all.p->end_parsed_examples = 0;
   all.p->done = false;
 
   all.p->examples = calloc_or_throw<example>(all.p->ring_size);
+  all.p->ring_in_use = new std::atomic<bool>[all.p->ring_size];
 
   for (size_t i = 0; i < all.p->ring_size; i++)
   {
     memset(&all.p->examples[i].l, 0, sizeof(polylabel));
     all.p->examples[i].in_use = false;
+    all.p->ring_in_use[i] = false;
   }
 }
 
 void adjust_used_index(vw& all)
 {
   all.p->used_index=all.p->begin_parsed_examples;
+  all.p->parsed_seen=all.p->used_index;
 }
 
 void initialize_parser_datastructures(vw& all)
 {
   initialize_examples(all);
-  initialize_mutex(&all.p->examples_lock);
-  initialize_condition_variable(&all.p->example_available);
-  initialize_condition_variable(&all.p->example_unused);
-  initialize_mutex(&all.p->output_lock);
-  initialize_condition_variable(&all.p->output_done);
+  initialize_ring_waiter(all.p->example_available);
+  initialize_ring_waiter(all.p->example_unused);
+  initialize_ring_waiter(all.p->output_done);
 }
 
 namespace VW
@@ -1181,6 +1291,7 @@ void free_parser(vw& all)
       VW::dealloc_example(all.p->lp.delete_label, all.p->examples[i], all.delete_prediction);
 
     free(all.p->examples);
+    delete[] all.p->ring_in_use;
   }
 
   io_buf* output = all.p->output;
@@ -1195,8 +1306,9 @@ void free_parser(vw& all)
 
 void release_parser_datastructures(vw& all)
 {
-  delete_mutex(&all.p->examples_lock);
-  delete_mutex(&all.p->output_lock);
+  delete_mutex(&all.p->example_available.lock);
+  delete_mutex(&all.p->example_unused.lock);
+  delete_mutex(&all.p->output_done.lock);
 }
 
 namespace VW
@@ -4,6 +4,7 @@ individual contributors. All rights reserved.  Released under a BSD
 license as described in the file LICENSE.
  */
 #pragma once
+#include <atomic>
 #include "io_buf.h"
 #include "parse_primitives.h"
 #include "example.h"
@@ -13,6 +14,14 @@ namespace po = boost::program_options;
 
 struct vw;
 
+// One side of the parser/learner handoff.  A thread waiting on the example ring spins briefly and
+// only then parks on cv; the other side takes the lock only when it sees somebody parked.
+struct ring_waiter
+{ std::atomic<bool> parked;
+  MUTEX lock;
+  CV cv;
+};
+
 struct parser
 { v_array<substring> channels;//helper(s) for text parsing
   v_array<substring> words;
@@ -28,20 +37,21 @@ struct parser
   bool sorted_cache;
 
   size_t ring_size;
-  uint64_t begin_parsed_examples; // The index of the beginning parsed example.
-  uint64_t end_parsed_examples; // The index of the fully parsed example.
-  uint64_t local_example_number;
+  size_t parse_threads; // workers parsing text input in parallel, see parse_pool.h
+  uint64_t begin_parsed_examples; // The index of the beginning parsed example.  Parser side only.
+  std::atomic<uint64_t> end_parsed_examples; // The index of the fully parsed example.  Published by the parser.
+  std::atomic<uint64_t> local_example_number;
   uint32_t in_pass_counter;
   example* examples;
-  uint64_t used_index;
+  std::atomic<bool>* ring_in_use; // per ring slot, handed back by finish_example
+  uint64_t used_index; // Learner side only.
+  uint64_t parsed_seen; // the learner's last look at end_parsed_examples
   bool emptylines_separate_examples; // true if you want to have holdout computed on a per-block basis rather than a per-line basis
-  MUTEX examples_lock;
-  CV example_available;
-  CV example_unused;
-  MUTEX output_lock;
-  CV output_done;
+  ring_waiter example_available;
+  ring_waiter example_unused;
+  ring_waiter output_done;
 
-  bool done;
+  std::atomic<bool> done;
   v_array<size_t> gram_mask;
 
   v_array<size_t> ids; //unique ids for sources
@@ -81,5 +91,6 @@ bool inconsistent_cache(size_t numbits, io_buf& cache);
 void reset_source(vw& all, size_t numbits);
 void finalize_source(parser* source);
 void set_compressed(parser* par);
+void set_mmapped(parser* par);
 void initialize_examples(vw& all);
 void free_parser(vw& all);
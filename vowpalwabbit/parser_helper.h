@@ -30,11 +30,12 @@ class arguments {
   std::stringstream* file_options; // the set of options to store in the model file.
   po::variables_map vm; //A stored map from option to value.
   std::vector<std::string> args;//All arguments
+  size_t model_args_begin, model_args_end;//args[model_args_begin, model_args_end) were read from the initial regressor.
   vw* all;//backdoor that should go away over time.
 
   //initialization
- arguments(vw& all_in, std::string name_in=""):new_od(name_in), missing_critical(false), all(&all_in) {file_options = new std::stringstream;};
- arguments():missing_critical(false){};//this should not be used but appears sometimes unavoidable.  Do an in-place allocation with the upper initializer after it is used.
+ arguments(vw& all_in, std::string name_in=""):new_od(name_in), missing_critical(false), model_args_begin(0), model_args_end(0), all(&all_in) {file_options = new std::stringstream;};
+ arguments():missing_critical(false), model_args_begin(0), model_args_end(0){};//this should not be used but appears sometimes unavoidable.  Do an in-place allocation with the upper initializer after it is used.
   ~arguments(){ delete file_options;};
 
   //reinitialization
@@ -0,0 +1,114 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#include <iomanip>
+#include "perf_stats.h"
+
+using namespace std;
+
+const char* perf_stage_name(perf_stage stage)
+{
+  switch (stage)
+  {
+    case perf_read:
+      return "read";
+    case perf_parse:
+      return "parse";
+    case perf_setup:
+      return "setup";
+    case perf_learn:
+      return "learn";
+    case perf_predict:
+      return "predict";
+    case perf_finish:
+      return "finish";
+    default:
+      return "unknown";
+  }
+}
+
+perf_stats::perf_stats()
+{
+  for (size_t i = 0; i < perf_stage_count; i++)
+  {
+    _ticks[i] = 0;
+    _calls[i] = 0;
+  }
+  _bytes = 0;
+  _start_ticks = now();
+  _start_time = chrono::steady_clock::now();
+}
+
+double perf_stats::wall_seconds() const
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - _start_time).count();
+}
+
+// calibrated over the whole run, rdtsc counts at a constant rate on current processors
+double perf_stats::ticks_per_second() const
+{
+  double wall = wall_seconds();
+  uint64_t ticks = now() - _start_ticks;
+  if (wall <= 0. || ticks == 0)
+    return 1e9;
+  return ticks / wall;
+}
+
+double perf_stats::seconds(perf_stage stage, double ticks_per_second) const
+{
+  return ticks(stage) / ticks_per_second;
+}
+
+void perf_stats::report(ostream& out, uint64_t examples, uint64_t features) const
+{
+  double wall = wall_seconds();
+  double rate = ticks_per_second();
+
+  ios_base::fmtflags flags = out.flags();
+  streamsize precision = out.precision();
+  out << fixed;
+  out << "perf stats over " << setprecision(3) << wall << " s, " << examples << " examples, " << features
+      << " features" << endl;
+  out << left << setw(8) << "stage" << right << setw(12) << "calls" << setw(12) << "seconds" << setw(12) << "ns/call"
+      << setw(8) << "wall%" << endl;
+  for (size_t i = 0; i < perf_stage_count; i++)
+  {
+    perf_stage stage = (perf_stage)i;
+    uint64_t calls = _calls[i].load(memory_order_relaxed);
+    double s = seconds(stage, rate);
+    out << left << setw(8) << perf_stage_name(stage) << right << setw(12) << calls << setw(12) << setprecision(3) << s
+        << setw(12) << setprecision(1) << (calls == 0 ? 0. : s * 1e9 / calls) << setw(8)
+        << (wall <= 0. ? 0. : 100. * s / wall) << endl;
+  }
+  uint64_t bytes = _bytes.load(memory_order_relaxed);
+  double read = seconds(perf_read, rate);
+  out << "input bytes = " << bytes;
+  if (read > 0.)
+    out << " (" << setprecision(1) << bytes / read / (1 << 20) << " MB/s while reading)";
+  out << endl;
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void perf_stats::write_json(ostream& out, uint64_t examples, uint64_t features) const
+{
+  double wall = wall_seconds();
+  double rate = ticks_per_second();
+
+  out << setprecision(9);
+  out << "{\"wall_seconds\":" << wall << ",\"examples\":" << examples << ",\"features\":" << features
+      << ",\"input_bytes\":" << _bytes.load(memory_order_relaxed) << ",\"stages\":{";
+  for (size_t i = 0; i < perf_stage_count; i++)
+  {
+    perf_stage stage = (perf_stage)i;
+    uint64_t calls = _calls[i].load(memory_order_relaxed);
+    double s = seconds(stage, rate);
+    if (i > 0)
+      out << ",";
+    out << "\"" << perf_stage_name(stage) << "\":{\"calls\":" << calls << ",\"seconds\":" << s
+        << ",\"ns_per_call\":" << (calls == 0 ? 0. : s * 1e9 / calls) << "}";
+  }
+  out << "}}" << endl;
+}
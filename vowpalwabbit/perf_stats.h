@@ -0,0 +1,93 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+/* Per stage timers for --perf_stats.  Each stage of the example pipeline charges the time it
+** took and a call to its counter.  Time is taken with rdtsc where available (steady_clock
+** elsewhere) and converted to seconds against steady_clock at the end of the run.  Stages
+** running on several threads (parse with --parse_threads, learn with --learn_threads) add up
+** the time of all of them, so a stage can account for more than the wall time.
+*/
+enum perf_stage
+{ perf_read,    // waiting for input: io_buf refills from a file, pipe or socket
+  perf_parse,   // turning input into features, hashing included, less the time in read
+  perf_setup,   // setup_example: cache writing, constant feature, feature limits, counts
+  perf_learn,   // learner learn on training examples
+  perf_predict, // learner predict on test examples (and with -t)
+  perf_finish,  // learner finish_example: loss accounting, progress, predictions output
+  perf_stage_count
+};
+
+class perf_stats
+{
+public:
+  perf_stats();
+
+  // in ticks: cycles with rdtsc, nanoseconds otherwise
+  static uint64_t now()
+  {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_ia32_rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  // charges the ticks since start, less excluded, and calls calls to stage
+  void add(perf_stage stage, uint64_t start, uint64_t excluded = 0, uint64_t calls = 1)
+  {
+    _ticks[stage].fetch_add(now() - start - excluded, std::memory_order_relaxed);
+    _calls[stage].fetch_add(calls, std::memory_order_relaxed);
+  }
+
+  void add_bytes(size_t bytes) { _bytes.fetch_add(bytes, std::memory_order_relaxed); }
+
+  uint64_t ticks(perf_stage stage) const { return _ticks[stage].load(std::memory_order_relaxed); }
+
+  // a table of the stages, as seconds, calls and time per call
+  void report(std::ostream& out, uint64_t examples, uint64_t features) const;
+
+  // the same as a JSON object
+  void write_json(std::ostream& out, uint64_t examples, uint64_t features) const;
+
+private:
+  std::atomic<uint64_t> _ticks[perf_stage_count];
+  std::atomic<uint64_t> _calls[perf_stage_count];
+  std::atomic<uint64_t> _bytes;
+  uint64_t _start_ticks;
+  std::chrono::steady_clock::time_point _start_time;
+
+  double wall_seconds() const;
+  double seconds(perf_stage stage, double ticks_per_second) const;
+  double ticks_per_second() const;
+};
+
+// charges its own lifetime and calls calls to stage, when perf is not null
+class perf_timer
+{
+public:
+  perf_timer(perf_stats* perf, perf_stage stage, uint64_t calls = 1)
+    : _perf(perf), _stage(stage), _calls(calls), _start(perf == nullptr ? 0 : perf_stats::now()) {}
+  ~perf_timer()
+  {
+    if (_perf != nullptr)
+      _perf->add(_stage, _start, 0, _calls);
+  }
+
+private:
+  perf_stats* _perf;
+  perf_stage _stage;
+  uint64_t _calls;
+  uint64_t _start;
+};
+
+const char* perf_stage_name(perf_stage stage);
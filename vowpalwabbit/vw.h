@@ -29,6 +29,10 @@ namespace VW
 vw* initialize(std::string s, io_buf* model=nullptr, bool skipModelLoad=false, trace_message_t trace_listener = nullptr, void* trace_context = nullptr);
 vw* initialize(int argc, char* argv[], io_buf* model=nullptr, bool skipModelLoad = false, trace_message_t trace_listener = nullptr, void* trace_context = nullptr);
 vw* seed_vw_model(vw* vw_model, std::string extra_args, trace_message_t trace_listener = nullptr, void* trace_context = nullptr);
+// Another reduction stack for a --learn_threads learner thread, see LEARNER::generic_driver_learn_threads.
+vw* seed_learner(vw& all);
+// Undoes seed_learner, leaving the output sinks it shares open.
+void finish_learner(vw& learner);
 
 void cmd_string_replace_value( std::stringstream*& ss, std::string flag_to_replace, std::string new_value );
 
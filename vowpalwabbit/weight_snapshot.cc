@@ -0,0 +1,70 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#include <string.h>
+#include <atomic>
+#include "weight_snapshot.h"
+#include "vw_exception.h"
+
+using namespace std;
+
+static void copy_weights(dense_parameters& to, dense_parameters& from)
+{
+  memcpy(to.first(), from.first(), (from.mask() + 1) * sizeof(weight));
+}
+
+static weight_snapshots::generation allocate(dense_parameters& weights)
+{
+  weight_snapshots::generation g(new dense_parameters((weights.mask() + 1) >> weights.stride_shift(),
+                                                      weights.stride_shift(), weights.pages()));
+  g->prefetch_distance(weights.prefetch_distance());
+  return g;
+}
+
+weight_snapshots::weight_snapshots(dense_parameters& weights, size_t max_generations)
+  : _max_generations(max_generations), _published(0), _skipped(0)
+{
+  if (max_generations < 2)
+    THROW("weight snapshots need at least 2 generations, one read and one to publish into");
+  _current = allocate(weights);
+  copy_weights(*_current, weights);
+  _pool.push_back(_current);
+}
+
+weight_snapshots::generation weight_snapshots::acquire() const { return atomic_load(&_current); }
+
+bool weight_snapshots::publish(dense_parameters& weights)
+{
+  // Only _current hands out new references, and only this thread replaces it, so a generation that
+  // is not current and is held by the pool alone stays free until it is published.
+  generation* free_one = nullptr;
+  for (generation& g : _pool)
+    if (g != _current && g.use_count() == 1)
+    {
+      free_one = &g;
+      break;
+    }
+  if (free_one != nullptr)
+  {
+    // use_count() reads the count relaxed.  The last reader let go of the generation with a release
+    // decrement, and this fence orders that reader's reads of the weights before the copy below.
+    atomic_thread_fence(memory_order_acquire);
+  }
+  else
+  {
+    if (_pool.size() == _max_generations)
+    {
+      _skipped++;
+      return false;
+    }
+    _pool.push_back(allocate(weights));
+    free_one = &_pool.back();
+  }
+
+  copy_weights(**free_one, weights);
+  atomic_store(&_current, *free_one);
+  _published++;
+  return true;
+}
@@ -0,0 +1,45 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#pragma once
+#include <stddef.h>
+#include <memory>
+#include <vector>
+#include "array_parameters.h"
+
+/* Published copies of the dense weights, so predictions can be served while learning goes on
+** (--snapshot_interval).  The learner trains on weights of its own and now and then publishes them:
+** they are copied into a generation nobody reads and that generation becomes the current one.
+** Readers take the current generation and predict on it for as long as they hold it, the way RCU
+** readers do, without ever seeing a write.  A generation is written again only once its last reader
+** has let it go, and no more generations are allocated than asked for, so publishing is skipped
+** (and tried again at the next interval) while all the others are still read.
+*/
+class weight_snapshots
+{
+public:
+  typedef std::shared_ptr<dense_parameters> generation;
+
+  // the first generation is a copy of weights; at most max_generations are ever allocated
+  weight_snapshots(dense_parameters& weights, size_t max_generations);
+
+  // the current generation; predict on it through dense_parameters::shallow_copy
+  generation acquire() const;
+
+  // copies weights into a free generation and makes it current, false when none is free; not to be
+  // called from more than one thread at a time
+  bool publish(dense_parameters& weights);
+
+  size_t generations() const { return _pool.size(); } // allocated so far
+  size_t published() const { return _published; }
+  size_t skipped() const { return _skipped; }
+
+private:
+  std::vector<generation> _pool;
+  size_t _max_generations;
+  generation _current;
+  size_t _published;
+  size_t _skipped;
+};
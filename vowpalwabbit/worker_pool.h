@@ -0,0 +1,92 @@
+/*
+Copyright (c) by respective owners including Yahoo!, Microsoft, and
+individual contributors. All rights reserved.  Released under a BSD
+license as described in the file LICENSE.
+*/
+#pragma once
+#include <stddef.h>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// A fixed set of threads that run one job at a time, the calling thread taking part as thread 0.
+// Used by reductions that split their own passes (--lda_threads, --bfgs_threads).
+class worker_pool
+{
+public:
+  worker_pool() : _generation(0), _running(0), _stopping(false) {}
+  ~worker_pool() { stop(); }
+
+  void start(size_t threads)
+  {
+    for (size_t i = 1; i < threads; i++)
+      _workers.push_back(std::thread(&worker_pool::work, this, i));
+  }
+
+  void stop()
+  {
+    {
+      std::lock_guard<std::mutex> l(_lock);
+      _stopping = true;
+    }
+    _start.notify_all();
+    for (std::thread& t : _workers)
+      t.join();
+    _workers.clear();
+  }
+
+  size_t threads() const { return _workers.size() + 1; }
+
+  // runs job(i) for every thread i, 0 on this one, and returns once all are done
+  void run(const std::function<void(size_t)>& job)
+  {
+    if (_workers.empty())
+    {
+      job(0);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> l(_lock);
+      _job = &job;
+      _running = _workers.size();
+      _generation++;
+    }
+    _start.notify_all();
+    job(0);
+    std::unique_lock<std::mutex> l(_lock);
+    _done.wait(l, [this] { return _running == 0; });
+  }
+
+private:
+  std::vector<std::thread> _workers;
+  std::mutex _lock;
+  std::condition_variable _start;
+  std::condition_variable _done;
+  const std::function<void(size_t)>* _job;
+  size_t _generation; // of the current job
+  size_t _running;    // workers not done with it
+  bool _stopping;
+
+  void work(size_t i)
+  {
+    size_t last = 0;
+    while (true)
+    {
+      const std::function<void(size_t)>* job;
+      {
+        std::unique_lock<std::mutex> l(_lock);
+        _start.wait(l, [this, last] { return _stopping || _generation != last; });
+        if (_stopping)
+          return;
+        last = _generation;
+        job = _job;
+      }
+      (*job)(i);
+      std::lock_guard<std::mutex> l(_lock);
+      if (--_running == 0)
+        _done.notify_one();
+    }
+  }
+};